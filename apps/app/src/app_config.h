@@ -1,45 +1,75 @@
 #pragma once
 
+#include "qtutils/config_key.h"
 #include "qtutils/config_manager.h"
-#include <algorithm>
+#include "qtutils/config_schema.h"
+#include <QtGlobal>
 
 namespace AppConfig
 {
 
+// Every key the app reads, declared once; the schema table and the typed handles below are built from these.
+inline constexpr auto kWindowTitleSpec = QtUtils::configSpec("ui/window_title", "Test", "Main window title");
+inline constexpr auto kWindowMaximizedSpec =
+    QtUtils::configSpec("ui/window_maximized", false, "Open the main window maximized");
+inline constexpr auto kImagePathSpec =
+    QtUtils::configSpec("ui/image_path", ":/images/pandas-waving", "Image shown in the main window");
+inline constexpr auto kLogLevelSpec =
+    QtUtils::configSpec("log/level", 0, 0, 4, "Minimum log level: 0 debug, 1 info, 2 warning, 3 critical, 4 fatal");
+inline constexpr auto kLogEnabledSpec = QtUtils::configSpec("log/enabled", true, "Write logs to console and file");
+
+inline constexpr QtUtils::ConfigField kSchema[] = {
+    QtUtils::ConfigField::of(kWindowTitleSpec),
+    QtUtils::ConfigField::of(kWindowMaximizedSpec),
+    QtUtils::ConfigField::of(kImagePathSpec),
+    QtUtils::ConfigField::of(kLogLevelSpec),
+    QtUtils::ConfigField::of(kLogEnabledSpec),
+};
+static_assert(QtUtils::ConfigSchema::isValid(kSchema), "duplicate key, missing doc or default out of range");
+
+inline const QtUtils::ConfigKey<QString> kWindowTitle{kWindowTitleSpec};
+inline const QtUtils::ConfigKey<bool> kWindowMaximized{kWindowMaximizedSpec};
+inline const QtUtils::ConfigKey<QString> kImagePath{kImagePathSpec};
+inline const QtUtils::ConfigKey<int> kLogLevel{kLogLevelSpec};
+inline const QtUtils::ConfigKey<bool> kLogEnabled{kLogEnabledSpec};
+
+// Values that do not fit the schema are repaired here, once, so reads only convert when a value changes.
 inline void initDefaults()
 {
-  QtUtils::ConfigManager::instance().registerDefaults({
-      {QStringLiteral("ui/window_title"),     QStringLiteral("Test")                  },
-      {QStringLiteral("ui/window_maximized"), false                                   },
-      {QStringLiteral("ui/image_path"),       QStringLiteral(":/images/pandas-waving")},
-      {QStringLiteral("log/level"),           0                                       },
-      {QStringLiteral("log/enabled"),         true                                    },
-  });
+  QtUtils::ConfigSchema::registerDefaults(kSchema);
+  QtUtils::ConfigSchema::validate(kSchema);
 }
 
 inline QString windowTitle()
 {
-  return QtUtils::ConfigManager::instance().stringValue(QStringLiteral("ui/window_title"));
+  return kWindowTitle.get();
 }
 
 inline bool windowMaximized()
 {
-  return QtUtils::ConfigManager::instance().boolValue(QStringLiteral("ui/window_maximized"));
+  return kWindowMaximized.get();
 }
 
 inline QString imagePath()
 {
-  return QtUtils::ConfigManager::instance().stringValue(QStringLiteral("ui/image_path"));
+  return kImagePath.get();
 }
 
 inline int logLevel()
 {
-  return std::clamp(QtUtils::ConfigManager::instance().intValue(QStringLiteral("log/level")), 0, 4);
+  return kLogLevel.get();
 }
 
 inline bool logEnabled()
 {
-  return QtUtils::ConfigManager::instance().boolValue(QStringLiteral("log/enabled"));
+  return kLogEnabled.get();
+}
+
+// log/level counts up in severity: 0 debug, 1 info, 2 warning, 3 critical, 4 fatal.
+inline QtMsgType logMinLevel()
+{
+  static constexpr QtMsgType kLevels[] = {QtDebugMsg, QtInfoMsg, QtWarningMsg, QtCriticalMsg, QtFatalMsg};
+  return kLevels[logLevel()];
 }
 
 } // namespace AppConfig
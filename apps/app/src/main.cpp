@@ -1,14 +1,52 @@
 #include "app_config.h"
 #include "mainwindow.h"
+#include "qtutils/config_manager.h"
 #include "qtutils/log_manager.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <cstdio>
+
+namespace
+{
+
+void applyLogSettings()
+{
+  const bool enabled = AppConfig::logEnabled();
+  QtUtils::LogManager::instance().configure(AppConfig::logMinLevel(), enabled, enabled);
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
   QApplication app(argc, argv);
 
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  QCommandLineOption dumpSchemaOption("dump-config-schema",
+                                      "Print every config key with its default, type, range and doc as INI, then exit");
+  parser.addOption(dumpSchemaOption);
+  parser.process(app);
+  if (parser.isSet(dumpSchemaOption))
+  {
+    fputs(QtUtils::ConfigSchema::dump(AppConfig::kSchema).toUtf8().constData(), stdout);
+    return 0;
+  }
+
   QtUtils::LogManager::instance();
+  // Settings changed from the UI reach config.ini in one write once they settle, and at exit.
+  QtUtils::ConfigManager::instance().setWriteBehind(500);
   AppConfig::initDefaults();
+  applyLogSettings();
+
+  // Lets log/level and log/enabled be changed in config.ini without a restart.
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.subscribe({AppConfig::kLogLevel.key(), AppConfig::kLogEnabled.key()},
+                   [](const QStringList &)
+                   {
+                     applyLogSettings();
+                   });
+  config.startWatching();
 
   MainWindow mainwindow;
   mainwindow.show();
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QtGlobal>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BENCH_CLOCK_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Timestamp source for per-call latencies. On x86 it reads the TSC (a few ns, no syscall, invariant on the
+// machines we bench on) and is calibrated once against steady_clock; elsewhere it falls back to steady_clock.
+class BenchClock
+{
+public:
+  static quint64 now()
+  {
+#ifdef BENCH_CLOCK_TSC
+    return __rdtsc();
+#else
+    return static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                    .count());
+#endif
+  }
+
+  // Calibrates on first use (about 20 ms); call it before timing starts.
+  static double nanosPerTick()
+  {
+    static const double nanos_per_tick = calibrate();
+    return nanos_per_tick;
+  }
+
+  static quint64 toNanos(quint64 ticks)
+  {
+    return static_cast<quint64>(static_cast<double>(ticks) * nanosPerTick());
+  }
+
+private:
+  static double calibrate()
+  {
+#ifdef BENCH_CLOCK_TSC
+    const auto wall_begin = std::chrono::steady_clock::now();
+    const quint64 ticks_begin = now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const quint64 ticks_end = now();
+    const auto wall_end = std::chrono::steady_clock::now();
+
+    const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall_end - wall_begin).count();
+    return ticks_end > ticks_begin ? static_cast<double>(wall_ns) / static_cast<double>(ticks_end - ticks_begin) : 1.0;
+#else
+    return 1.0;
+#endif
+  }
+};
@@ -0,0 +1,346 @@
+#include "bench_report.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QStorageInfo>
+#include <QStringList>
+#include <QSysInfo>
+#include <QThread>
+#include <utility>
+
+namespace
+{
+
+QString readCpuModel()
+{
+  QFile cpuinfo(QStringLiteral("/proc/cpuinfo"));
+  if (cpuinfo.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    while (!cpuinfo.atEnd())
+    {
+      const QByteArray line = cpuinfo.readLine();
+      if (line.startsWith("model name") || line.startsWith("Model") || line.startsWith("Hardware"))
+      {
+        const int colon = line.indexOf(':');
+        if (colon > 0)
+        {
+          return QString::fromUtf8(line.mid(colon + 1).trimmed());
+        }
+      }
+    }
+  }
+  return QSysInfo::currentCpuArchitecture();
+}
+
+QJsonObject latencyToJson(const LatencyHistogram &latency)
+{
+  QJsonObject json;
+  json["count"] = static_cast<qint64>(latency.count());
+  json["mean_ns"] = latency.mean();
+  json["p50_ns"] = static_cast<qint64>(latency.percentile(50.0));
+  json["p90_ns"] = static_cast<qint64>(latency.percentile(90.0));
+  json["p99_ns"] = static_cast<qint64>(latency.percentile(99.0));
+  json["p999_ns"] = static_cast<qint64>(latency.percentile(99.9));
+  json["max_ns"] = static_cast<qint64>(latency.max());
+
+  QJsonArray stalls;
+  for (const LatencyStall &stall : latency.worstStalls())
+  {
+    QJsonObject entry;
+    entry["latency_ns"] = static_cast<qint64>(stall.latency_ns);
+    entry["at_ns"] = static_cast<qint64>(stall.at_ns);
+    entry["thread"] = stall.thread_id;
+    stalls.append(entry);
+  }
+  json["worst_stalls"] = stalls;
+  return json;
+}
+
+QJsonObject costToJson(const CostCounters &cost, qint64 messages)
+{
+  const std::pair<const char *, qint64> counts[] = {
+      {"cycles", cost.cycles},
+      {"instructions", cost.instructions},
+      {"cache_misses", cost.cache_misses},
+      {"context_switches", cost.context_switches},
+      {"page_faults", cost.page_faults},
+      {"allocations", cost.allocations},
+      {"frees", cost.frees},
+  };
+
+  QJsonObject json;
+  for (const auto &count : counts)
+  {
+    if (count.second >= 0 && messages > 0)
+    {
+      json[QString::fromLatin1(count.first)] = static_cast<double>(count.second) / static_cast<double>(messages);
+    }
+  }
+  return json;
+}
+
+void flatten(const QJsonObject &object, const QString &prefix, QStringList &names, QStringList &values)
+{
+  for (auto it = object.constBegin(); it != object.constEnd(); ++it)
+  {
+    const QString name = prefix.isEmpty() ? it.key() : prefix + '.' + it.key();
+    const QJsonValue value = it.value();
+    if (value.isObject())
+    {
+      flatten(value.toObject(), name, names, values);
+      continue;
+    }
+    if (value.isArray())
+    {
+      continue;
+    }
+
+    QString text;
+    if (value.isBool())
+    {
+      text = value.toBool() ? QStringLiteral("true") : QStringLiteral("false");
+    }
+    else if (value.isDouble())
+    {
+      text = QString::number(value.toDouble(), 'g', 15);
+    }
+    else
+    {
+      text = value.toString();
+      if (text.contains(',') || text.contains('"'))
+      {
+        text = '"' + text.replace('"', QStringLiteral("\"\"")) + '"';
+      }
+    }
+    names.append(name);
+    values.append(text);
+  }
+}
+
+const char *levelName(QtMsgType level)
+{
+  switch (level)
+  {
+  case QtInfoMsg:
+    return "info";
+  case QtWarningMsg:
+    return "warning";
+  case QtCriticalMsg:
+    return "critical";
+  default:
+    return "debug";
+  }
+}
+
+double valueAt(const QJsonObject &root, const QString &path, bool &found)
+{
+  QJsonValue value = root;
+  for (const QString &key : path.split('.'))
+  {
+    if (!value.isObject() || !value.toObject().contains(key))
+    {
+      found = false;
+      return 0;
+    }
+    value = value.toObject().value(key);
+  }
+  found = value.isDouble();
+  return value.toDouble();
+}
+
+} // namespace
+
+HostInfo BenchReport::collectHostInfo(const QString &log_dir)
+{
+  HostInfo host;
+  host.hostname = QSysInfo::machineHostName();
+  host.cpu_model = readCpuModel();
+  host.cpu_cores = QThread::idealThreadCount();
+  host.os = QSysInfo::prettyProductName();
+  host.kernel = QSysInfo::kernelType() + ' ' + QSysInfo::kernelVersion();
+
+  const QStorageInfo storage(log_dir);
+  if (storage.isValid())
+  {
+    host.filesystem = QString::fromUtf8(storage.fileSystemType()) + " on " + QString::fromUtf8(storage.device());
+  }
+  return host;
+}
+
+QJsonObject BenchReport::hostToJson(const HostInfo &host)
+{
+  QJsonObject json_host;
+  json_host["hostname"] = host.hostname;
+  json_host["cpu_model"] = host.cpu_model;
+  json_host["cpu_cores"] = host.cpu_cores;
+  json_host["os"] = host.os;
+  json_host["kernel"] = host.kernel;
+  json_host["filesystem"] = host.filesystem;
+  return json_host;
+}
+
+QJsonObject BenchReport::configToJson(const BenchConfig &config)
+{
+  QJsonObject json_config;
+  json_config["threads"] = config.thread_count;
+  json_config["logs_per_thread"] = config.logs_per_thread;
+  json_config["message_size"] = config.message_size;
+  json_config["warmup_logs"] = config.warmup_logs;
+  json_config["file"] = config.enable_file;
+  json_config["console"] = config.enable_console;
+  json_config["lidar"] = config.simulate_lidar;
+  json_config["burst_count"] = config.burst_count;
+  json_config["burst_interval_us"] = config.burst_interval_us;
+  json_config["shutdown_budget_ms"] = config.shutdown_budget_ms;
+  json_config["drain_file_only"] = config.drain_file_only;
+  json_config["debug_sample_rate"] = static_cast<qint64>(config.debug_sample_rate);
+  json_config["json_lines"] = config.json_output;
+  json_config["e2e"] = config.measure_e2e;
+  json_config["perf"] = config.measure_perf;
+  json_config["flush_size"] = config.flush_size;
+  json_config["flush_timeout_ms"] = config.flush_timeout_ms;
+  json_config["level"] = QString::fromLatin1(levelName(config.message_level));
+  json_config["max_file_size"] = config.max_file_size;
+  json_config["max_file_count"] = config.max_file_count;
+  json_config["prefill_files"] = config.prefill_files;
+  if (!config.replay_file.isEmpty())
+  {
+    json_config["replay_file"] = config.replay_file;
+    json_config["replay_speed"] = config.replay_speed;
+  }
+  return json_config;
+}
+
+QJsonObject BenchReport::toJson(const BenchConfig &config, const BenchResult &result, const HostInfo &host)
+{
+  QJsonObject json_result;
+  json_result["total_logs"] = result.total_logs;
+  json_result["total_bytes"] = result.total_bytes;
+  json_result["elapsed_ms"] = result.elapsed_ms;
+  json_result["throughput_logs_per_sec"] = result.throughput_logs_per_sec;
+  json_result["throughput_mb_per_sec"] = result.throughput_mb_per_sec;
+  json_result["startup_handler_us"] = result.startup_handler_us;
+  json_result["startup_storage_us"] = result.startup_storage_us;
+  json_result["shutdown_ms"] = result.shutdown_ms;
+  json_result["enqueue_latency"] = latencyToJson(result.latency);
+  if (config.measure_e2e)
+  {
+    json_result["e2e_latency"] = latencyToJson(result.e2e_latency);
+  }
+  QJsonObject cost;
+  cost["producer"] = costToJson(result.producer_cost, result.total_logs);
+  cost["worker"] = costToJson(result.worker_cost, result.total_logs);
+  json_result["cost_per_message"] = cost;
+  if (config.enable_file)
+  {
+    QJsonObject rotation;
+    rotation["count"] = static_cast<qint64>(result.rotation.rotations);
+    rotation["worker_stall"] = latencyToJson(result.rotation.worker_stall);
+    if (config.measure_rotation)
+    {
+      rotation["producer_near_rotation"] = latencyToJson(result.rotation.producer_near);
+      rotation["producer_elsewhere"] = latencyToJson(result.rotation.producer_away);
+    }
+    json_result["rotation"] = rotation;
+  }
+
+  QJsonObject report;
+  report["tool"] = QCoreApplication::applicationName();
+  report["version"] = QCoreApplication::applicationVersion();
+  report["qt_version"] = QString::fromLatin1(qVersion());
+  report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+  report["host"] = hostToJson(host);
+  report["config"] = configToJson(config);
+  report["results"] = json_result;
+  return report;
+}
+
+QByteArray BenchReport::toCsv(const QJsonObject &report)
+{
+  QStringList names;
+  QStringList values;
+  flatten(report, QString(), names, values);
+  return (names.join(',') + '\n' + values.join(',') + '\n').toUtf8();
+}
+
+QByteArray BenchReport::toCsv(const QJsonArray &rows)
+{
+  QByteArray csv;
+  for (qsizetype i = 0; i < rows.size(); ++i)
+  {
+    QStringList names;
+    QStringList values;
+    flatten(rows.at(i).toObject(), QString(), names, values);
+    if (i == 0)
+    {
+      csv += names.join(',').toUtf8() + '\n';
+    }
+    csv += values.join(',').toUtf8() + '\n';
+  }
+  return csv;
+}
+
+bool BenchReport::compareWithBaseline(const QJsonObject &current,
+                                      const QString &baseline_path,
+                                      double threshold_percent,
+                                      std::vector<MetricComparison> &comparisons,
+                                      QString &error)
+{
+  QFile file(baseline_path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    error = QString("Cannot open baseline %1: %2").arg(baseline_path, file.errorString());
+    return false;
+  }
+
+  QJsonParseError parse_error;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parse_error);
+  if (parse_error.error != QJsonParseError::NoError || !document.isObject())
+  {
+    error = QString("Invalid baseline %1: %2").arg(baseline_path, parse_error.errorString());
+    return false;
+  }
+  const QJsonObject baseline = document.object();
+
+  struct Metric
+  {
+    const char *path;
+    bool higher_is_better;
+  };
+  static const Metric metrics[] = {
+      {"results.throughput_logs_per_sec", true},
+      {"results.enqueue_latency.p99_ns", false},
+      {"results.e2e_latency.p99_ns", false},
+      {"results.rotation.worker_stall.p99_ns", false},
+  };
+
+  comparisons.clear();
+  for (const Metric &metric : metrics)
+  {
+    bool in_baseline = false;
+    bool in_current = false;
+    const double before = valueAt(baseline, QString::fromLatin1(metric.path), in_baseline);
+    const double after = valueAt(current, QString::fromLatin1(metric.path), in_current);
+    if (!in_baseline || !in_current || before <= 0)
+    {
+      continue;
+    }
+
+    MetricComparison comparison;
+    comparison.metric = QString::fromLatin1(metric.path);
+    comparison.baseline = before;
+    comparison.current = after;
+    comparison.change_percent = (after - before) / before * 100.0;
+    comparison.regressed = metric.higher_is_better ? comparison.change_percent < -threshold_percent
+                                                   : comparison.change_percent > threshold_percent;
+    comparisons.push_back(comparison);
+  }
+
+  if (comparisons.empty())
+  {
+    error = QString("Baseline %1 has no comparable metrics").arg(baseline_path);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "bench_types.h"
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+struct HostInfo
+{
+  QString hostname;
+  QString cpu_model;
+  int cpu_cores{0};
+  QString os;
+  QString kernel;
+  QString filesystem;
+};
+
+struct MetricComparison
+{
+  QString metric;
+  double baseline{0};
+  double current{0};
+  double change_percent{0};
+  bool regressed{false};
+};
+
+// Machine-readable run reports and regression checks against a stored run.
+class BenchReport
+{
+public:
+  BenchReport() = delete;
+
+  static HostInfo collectHostInfo(const QString &log_dir);
+
+  static QJsonObject toJson(const BenchConfig &config, const BenchResult &result, const HostInfo &host);
+  static QJsonObject configToJson(const BenchConfig &config);
+  static QJsonObject hostToJson(const HostInfo &host);
+  // One header line and one value line; nested keys are flattened to "a.b".
+  static QByteArray toCsv(const QJsonObject &report);
+  // One line per row, with the header taken from the first row.
+  static QByteArray toCsv(const QJsonArray &rows);
+
+  // Throughput may not drop and p99 latencies may not rise by more than threshold_percent.
+  static bool compareWithBaseline(const QJsonObject &current,
+                                  const QString &baseline_path,
+                                  double threshold_percent,
+                                  std::vector<MetricComparison> &comparisons,
+                                  QString &error);
+};
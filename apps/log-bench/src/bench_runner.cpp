@@ -0,0 +1,428 @@
+#include "bench_runner.h"
+#include "bench_clock.h"
+#include "alloc_counter.h"
+#include "e2e_probe.h"
+#include "message_corpus.h"
+#include "perf_counters.h"
+#include "rotation_probe.h"
+#include "qtutils/common_utils.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Owned by one producer thread; merged after the run so producers never share a cache line.
+struct ThreadStats
+{
+  LatencyHistogram latency;
+  qint64 logs{0};
+  qint64 bytes{0};
+  CostCounters cost;
+  std::vector<EnqueueSample> samples;
+};
+
+// What one thread spends between begin() and end(): perf events when enabled, heap calls whenever counted.
+class ThreadCost
+{
+public:
+  ThreadCost(bool measure_perf, qint64 tid) : perf_enabled_(measure_perf && perf_.open(tid)), tid_(tid)
+  {
+  }
+
+  const PerfCounters &perf() const
+  {
+    return perf_;
+  }
+
+  void begin()
+  {
+    allocs_ = countAllocs();
+    if (perf_enabled_)
+    {
+      perf_.start();
+    }
+  }
+
+  void end(CostCounters &cost)
+  {
+    if (perf_enabled_)
+    {
+      perf_.stop();
+      perf_.addTo(cost);
+    }
+    // Counts shared with other threads would be wrong, so they stay unset and are reported as n/a.
+    const AllocCounts spent = countAllocs() - allocs_;
+    if (AllocCounter::isAvailable() && spent.exact)
+    {
+      cost.allocations = static_cast<qint64>(spent.allocations);
+      cost.frees = static_cast<qint64>(spent.frees);
+    }
+  }
+
+private:
+  AllocCounts countAllocs() const
+  {
+    return tid_ == 0 ? AllocCounter::current() : AllocCounter::forThread(tid_);
+  }
+
+  PerfCounters perf_;
+  bool perf_enabled_;
+  qint64 tid_;
+  AllocCounts allocs_;
+};
+
+void addCount(qint64 &total, qint64 part)
+{
+  if (part >= 0)
+  {
+    total = (total < 0 ? 0 : total) + part;
+  }
+}
+
+void addCosts(CostCounters &total, const CostCounters &part)
+{
+  addCount(total.cycles, part.cycles);
+  addCount(total.instructions, part.instructions);
+  addCount(total.cache_misses, part.cache_misses);
+  addCount(total.context_switches, part.context_switches);
+  addCount(total.page_faults, part.page_faults);
+  addCount(total.allocations, part.allocations);
+  addCount(total.frees, part.frees);
+}
+
+// Producers build their messages first and then wait here, so generation stays out of the timed region.
+struct StartGate
+{
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  quint64 start_ticks{0};
+
+  void arriveAndWait()
+  {
+    ready.fetch_add(1, std::memory_order_release);
+    while (!go.load(std::memory_order_acquire))
+    {
+      std::this_thread::yield();
+    }
+  }
+};
+
+void timedLog(
+    const CorpusEntry &entry, int thread_id, const BenchConfig &config, quint64 start_ticks, ThreadStats &stats)
+{
+  const quint64 t1 = BenchClock::now();
+  if (config.measure_e2e)
+  {
+    char tag[E2eProbe::kTagCapacity];
+    logStream(entry.level).noquote() << E2eProbe::formatTag(tag, t1, thread_id) << entry.text;
+  }
+  else
+  {
+    logStream(entry.level).noquote() << entry.text;
+  }
+  const quint64 t2 = BenchClock::now();
+
+  const quint64 latency_ns = BenchClock::toNanos(t2 - t1);
+  const quint64 at_ns = BenchClock::toNanos(t1 - start_ticks);
+  stats.latency.record(latency_ns, at_ns, thread_id);
+  if (config.measure_rotation)
+  {
+    stats.samples.push_back({at_ns, latency_ns});
+  }
+  stats.bytes += entry.bytes;
+  ++stats.logs;
+}
+
+void lidarSimulatorThread(int thread_id, const BenchConfig &config, ThreadStats &stats, StartGate &gate)
+{
+  const std::vector<CorpusEntry> corpus = MessageCorpus::generate(config, thread_id);
+  ThreadCost cost(config.measure_perf, 0);
+  gate.arriveAndWait();
+  cost.begin();
+
+  const int logs_count = config.logs_per_thread;
+  int remaining = logs_count;
+  int burst_size = config.burst_count;
+
+  while (remaining > 0)
+  {
+    int batch = std::min(burst_size, remaining);
+
+    for (int i = 0; i < batch; ++i)
+    {
+      const int msg_id = logs_count - remaining + i;
+      timedLog(corpus[static_cast<size_t>(msg_id) % corpus.size()], thread_id, config, gate.start_ticks, stats);
+    }
+
+    remaining -= batch;
+
+    if (remaining > 0 && config.burst_interval_us > 0)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(config.burst_interval_us));
+    }
+  }
+  cost.end(stats.cost);
+}
+
+void standardBenchThread(int thread_id, const BenchConfig &config, ThreadStats &stats, StartGate &gate)
+{
+  const std::vector<CorpusEntry> corpus = MessageCorpus::generate(config, thread_id);
+  ThreadCost cost(config.measure_perf, 0);
+  gate.arriveAndWait();
+  cost.begin();
+
+  for (int i = 0; i < config.logs_per_thread; ++i)
+  {
+    timedLog(corpus[static_cast<size_t>(i) % corpus.size()], thread_id, config, gate.start_ticks, stats);
+  }
+  cost.end(stats.cost);
+}
+
+// Sleeps until each entry's recorded offset, scaled by replay_speed; a late producer sends immediately.
+void replayThread(int thread_id,
+                  const BenchConfig &config,
+                  const std::vector<CorpusEntry> &stream,
+                  ThreadStats &stats,
+                  StartGate &gate)
+{
+  ThreadCost cost(config.measure_perf, 0);
+  gate.arriveAndWait();
+  cost.begin();
+
+  const auto replay_start = std::chrono::steady_clock::now();
+  for (const CorpusEntry &entry : stream)
+  {
+    if (config.replay_speed > 0)
+    {
+      const auto due =
+          replay_start + std::chrono::nanoseconds(static_cast<qint64>(entry.offset_ns / config.replay_speed));
+      if (std::chrono::steady_clock::now() < due)
+      {
+        std::this_thread::sleep_until(due);
+      }
+    }
+    timedLog(entry, thread_id, config, gate.start_ticks, stats);
+  }
+  cost.end(stats.cost);
+}
+
+// Empty files named like the app's logs; LogManager prunes them oldest first like any other.
+void prefillLogDir(int count)
+{
+  const QDir dir(QtUtils::CommonUtils::getAppLogDirPath());
+  const qsizetype existing = dir.entryList(QStringList{QStringLiteral("*.log")}, QDir::Files).size();
+  const QString prefix = QString("%1-prefill-%2")
+                             .arg(QtUtils::CommonUtils::getAppName())
+                             .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmsszzz"));
+  for (qsizetype i = existing; i < count; ++i)
+  {
+    QFile file(dir.filePath(QString("%1-%2.log").arg(prefix).arg(i)));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+      fprintf(stderr, "Cannot prefill %s: %s\n", qPrintable(file.fileName()), qPrintable(file.errorString()));
+      return;
+    }
+  }
+}
+
+void warmup(int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    qDebug() << "Warmup message" << i;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+} // namespace
+
+QDebug logStream(QtMsgType level)
+{
+  switch (level)
+  {
+  case QtInfoMsg:
+    return qInfo();
+  case QtWarningMsg:
+    return qWarning();
+  case QtCriticalMsg:
+    return qCritical();
+  default:
+    return qDebug();
+  }
+}
+
+BenchResult runBenchmark(const BenchConfig &config, const BenchProbes &probes, const ReplayStreams *replay)
+{
+  BenchResult result;
+  const int thread_count = replay != nullptr ? static_cast<int>(replay->size()) : config.thread_count;
+
+  std::vector<std::unique_ptr<ThreadStats>> stats;
+  for (int t = 0; t < thread_count; ++t)
+  {
+    stats.push_back(std::make_unique<ThreadStats>());
+    if (config.measure_rotation)
+    {
+      stats.back()->samples.reserve(replay != nullptr ? (*replay)[t].size()
+                                                      : static_cast<size_t>(config.logs_per_thread));
+    }
+  }
+  StartGate gate;
+
+  BenchClock::nanosPerTick();
+  warmup(config.warmup_logs);
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+
+  for (int t = 0; t < thread_count; ++t)
+  {
+    if (replay != nullptr)
+    {
+      threads.emplace_back(
+          replayThread, t, std::cref(config), std::cref((*replay)[t]), std::ref(*stats[t]), std::ref(gate));
+    }
+    else if (config.simulate_lidar)
+    {
+      threads.emplace_back(lidarSimulatorThread, t, std::cref(config), std::ref(*stats[t]), std::ref(gate));
+    }
+    else
+    {
+      threads.emplace_back(standardBenchThread, t, std::cref(config), std::ref(*stats[t]), std::ref(gate));
+    }
+  }
+
+  while (gate.ready.load(std::memory_order_acquire) < thread_count)
+  {
+    std::this_thread::yield();
+  }
+
+  auto bench_start = std::chrono::steady_clock::now();
+  gate.start_ticks = BenchClock::now();
+  if (probes.e2e != nullptr)
+  {
+    probes.e2e->setStartTicks(gate.start_ticks);
+  }
+  if (probes.rotation != nullptr)
+  {
+    probes.rotation->setStartTicks(gate.start_ticks);
+  }
+  gate.go.store(true, std::memory_order_release);
+
+  for (auto &th : threads)
+  {
+    th.join();
+  }
+
+  auto bench_end = std::chrono::steady_clock::now();
+  result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(bench_end - bench_start).count();
+  for (int t = 0; t < thread_count; ++t)
+  {
+    ThreadStats &thread_stats = *stats[t];
+    result.total_logs += thread_stats.logs;
+    result.total_bytes += thread_stats.bytes;
+    addCosts(result.producer_cost, thread_stats.cost);
+    result.latency.merge(thread_stats.latency);
+    if (probes.rotation != nullptr && config.measure_rotation)
+    {
+      probes.rotation->addSamples(t, std::move(thread_stats.samples));
+    }
+  }
+  result.avg_enqueue_latency_us = result.latency.mean() / 1000.0;
+
+  result.throughput_logs_per_sec =
+      result.elapsed_ms > 0 ? static_cast<double>(result.total_logs) * 1000.0 / result.elapsed_ms : 0;
+  result.throughput_mb_per_sec =
+      result.elapsed_ms > 0 ? static_cast<double>(result.total_bytes) / 1024.0 / 1024.0 * 1000.0 / result.elapsed_ms
+                            : 0;
+
+  return result;
+}
+
+void startSession(QtUtils::LogManager &log_manager, const BenchConfig &config)
+{
+  log_manager.restart();
+  while (!log_manager.isStorageReady())
+  {
+    std::this_thread::yield();
+  }
+
+  log_manager.configure(QtDebugMsg, config.enable_console, config.enable_file);
+  log_manager.setShutdownBudget(config.shutdown_budget_ms);
+  log_manager.setSampling(QtDebugMsg, config.debug_sample_rate);
+  log_manager.setOutputFormat(config.json_output ? QtUtils::LogManager::OutputFormat::JsonLines
+                                                 : QtUtils::LogManager::OutputFormat::Text);
+  log_manager.setFlushSize(config.flush_size);
+  log_manager.setFlushTimeout(config.flush_timeout_ms);
+  log_manager.setMaxFileSize(config.max_file_size);
+  log_manager.setMaxFileCount(config.max_file_count);
+  if (config.enable_file && config.prefill_files > 0)
+  {
+    prefillLogDir(config.prefill_files);
+  }
+}
+
+BenchResult runSession(QtUtils::LogManager &log_manager, const BenchConfig &config, const ReplayStreams *replay)
+{
+  startSession(log_manager, config);
+
+  const bool measure_e2e = config.measure_e2e && config.enable_file;
+  E2eProbe probe;
+  if (measure_e2e)
+  {
+    probe.attach(log_manager);
+  }
+  RotationProbe rotation;
+  if (config.enable_file)
+  {
+    rotation.attach(log_manager);
+  }
+
+  // The worker is counted from here through the shutdown drain, so every entry it writes is included.
+  const qint64 worker_tid = PerfCounters::findThread(QStringLiteral("LogManager"));
+  ThreadCost worker_cost(config.measure_perf && worker_tid > 0, worker_tid);
+  if (config.measure_perf && worker_tid <= 0)
+  {
+    fprintf(stderr, "perf: LogManager worker thread not found\n");
+  }
+  else if (config.measure_perf && !worker_cost.perf().errorString().isEmpty())
+  {
+    fprintf(stderr, "perf: some events unavailable: %s\n", qPrintable(worker_cost.perf().errorString()));
+  }
+  worker_cost.begin();
+
+  BenchResult result = runBenchmark(
+      config, BenchProbes{measure_e2e ? &probe : nullptr, config.enable_file ? &rotation : nullptr}, replay);
+
+  auto shutdown_begin = std::chrono::steady_clock::now();
+  log_manager.shutdown(config.drain_file_only ? QtUtils::LogManager::DrainMode::FileOnly
+                                              : QtUtils::LogManager::DrainMode::FileAndConsole);
+  result.shutdown_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - shutdown_begin).count();
+  if (worker_tid > 0)
+  {
+    worker_cost.end(result.worker_cost);
+  }
+
+  if (measure_e2e)
+  {
+    probe.detach(log_manager);
+    result.e2e_latency = probe.latency();
+  }
+  if (config.enable_file)
+  {
+    rotation.detach(log_manager);
+    result.rotation = rotation.analyze();
+  }
+  return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "bench_types.h"
+#include "message_corpus.h"
+#include "qtutils/log_manager.h"
+#include <QDebug>
+
+class E2eProbe;
+class RotationProbe;
+
+// Optional instruments for runBenchmark(); null ones are skipped.
+struct BenchProbes
+{
+  E2eProbe *e2e{nullptr};
+  RotationProbe *rotation{nullptr};
+};
+
+// qDebug(), qInfo(), qWarning() or qCritical() for level.
+QDebug logStream(QtMsgType level);
+
+// Runs the producer threads once against the LogManager as currently configured. With replay set, one producer
+// per stream re-issues the recorded messages instead of generated ones.
+BenchResult runBenchmark(const BenchConfig &config, const BenchProbes &probes, const ReplayStreams *replay = nullptr);
+
+// Starts LogManager if it was shut down, applies config and prefills the log directory.
+void startSession(QtUtils::LogManager &log_manager, const BenchConfig &config);
+
+// One isolated run: starts LogManager if it was shut down, applies config, runs the producers and shuts
+// LogManager down again, measuring the drain.
+BenchResult runSession(QtUtils::LogManager &log_manager,
+                       const BenchConfig &config,
+                       const ReplayStreams *replay = nullptr);
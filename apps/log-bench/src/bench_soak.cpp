@@ -0,0 +1,369 @@
+#include "bench_soak.h"
+#include "bench_runner.h"
+#include "message_corpus.h"
+#include "qtutils/common_utils.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+std::atomic<bool> g_interrupted{false};
+
+void onInterrupt(int)
+{
+  g_interrupted.store(true);
+}
+
+struct alignas(64) ProducerCounter
+{
+  std::atomic<quint64> sent{0};
+};
+
+// Sends rate messages per second in 1 ms ticks. After a stall at most one second of backlog is caught up,
+// so a slow logger shows up as a lower send rate instead of an ever-growing burst.
+void soakProducer(int thread_id,
+                  const BenchConfig &config,
+                  double rate,
+                  ProducerCounter &counter,
+                  const std::atomic<bool> &stop)
+{
+  const std::vector<CorpusEntry> corpus = MessageCorpus::generate(config, thread_id);
+  const double per_tick = rate / 1000.0;
+  double credit = 0;
+  size_t index = 0;
+  auto next_tick = std::chrono::steady_clock::now();
+
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    next_tick += std::chrono::milliseconds(1);
+    credit = std::min(credit + per_tick, std::max(rate, 1.0));
+    while (credit >= 1.0)
+    {
+      const CorpusEntry &entry = corpus[index];
+      index = (index + 1) % corpus.size();
+      logStream(entry.level).noquote() << entry.text;
+      counter.sent.fetch_add(1, std::memory_order_relaxed);
+      credit -= 1.0;
+    }
+    std::this_thread::sleep_until(next_tick);
+  }
+}
+
+qint64 residentBytes()
+{
+#if defined(Q_OS_LINUX)
+  QFile statm(QStringLiteral("/proc/self/statm"));
+  if (statm.open(QIODevice::ReadOnly))
+  {
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() > 1)
+    {
+      return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+  }
+#endif
+  return -1;
+}
+
+int openFileDescriptors()
+{
+#if defined(Q_OS_LINUX)
+  // Listing the directory opens one descriptor itself; it is constant across samples.
+  return static_cast<int>(QDir(QStringLiteral("/proc/self/fd"))
+                              .entryList(QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot)
+                              .size());
+#else
+  return -1;
+#endif
+}
+
+qint64 directoryBytes(const QString &path)
+{
+  qint64 total = 0;
+  QDirIterator it(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+  while (it.hasNext())
+  {
+    it.next();
+    total += it.fileInfo().size();
+  }
+  return total;
+}
+
+template <typename Field>
+double medianOf(const std::vector<SoakSample> &samples, size_t begin, size_t end, Field field)
+{
+  std::vector<double> values;
+  for (size_t i = begin; i < end; ++i)
+  {
+    values.push_back(static_cast<double>(field(samples[i])));
+  }
+  std::sort(values.begin(), values.end());
+  return values.empty() ? 0 : values[values.size() / 2];
+}
+
+const char *kSeriesHeader = "elapsed_s,sent,send_rate,write_rate,backlog,max_queue_depth,rss_bytes,open_fds,"
+                            "log_dir_bytes\n";
+
+QByteArray sampleToCsv(const SoakSample &sample)
+{
+  return QString("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+      .arg(sample.elapsed_s, 0, 'f', 1)
+      .arg(sample.sent)
+      .arg(sample.send_rate, 0, 'f', 0)
+      .arg(sample.write_rate, 0, 'f', 0)
+      .arg(sample.backlog)
+      .arg(sample.max_queue_depth)
+      .arg(sample.rss_bytes)
+      .arg(sample.open_fds)
+      .arg(sample.log_dir_bytes)
+      .toUtf8();
+}
+
+} // namespace
+
+std::vector<SoakSample> BenchSoak::run(QtUtils::LogManager &log_manager,
+                                       const BenchConfig &config,
+                                       const SoakSpec &spec)
+{
+  QFile series;
+  if (!spec.series_path.isEmpty())
+  {
+    series.setFileName(spec.series_path);
+    if (series.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+      series.write(kSeriesHeader);
+      series.flush();
+    }
+    else
+    {
+      fprintf(stderr, "Cannot write %s: %s\n", qPrintable(spec.series_path), qPrintable(series.errorString()));
+    }
+  }
+
+  startSession(log_manager, config);
+  const QString log_dir = QtUtils::CommonUtils::getAppLogDirPath();
+
+  g_interrupted = false;
+  auto previous_handler = std::signal(SIGINT, onInterrupt);
+
+  const int thread_count = std::max(1, config.thread_count);
+  std::vector<ProducerCounter> counters(static_cast<size_t>(thread_count));
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < thread_count; ++t)
+  {
+    producers.emplace_back(
+        soakProducer, t, std::cref(config), spec.rate / thread_count, std::ref(counters[t]), std::cref(stop));
+  }
+
+  std::vector<SoakSample> samples;
+  const auto start = std::chrono::steady_clock::now();
+  auto next_sample = start;
+  quint64 last_sent = 0;
+  quint64 last_processed = log_manager.stats().processed;
+  auto last_time = start;
+
+  while (!g_interrupted.load())
+  {
+    next_sample += std::chrono::seconds(1);
+    std::this_thread::sleep_until(next_sample);
+
+    const auto now = std::chrono::steady_clock::now();
+    const double interval_s = std::chrono::duration<double>(now - last_time).count();
+    const QtUtils::LogManager::Stats stats = log_manager.stats();
+
+    SoakSample sample;
+    sample.elapsed_s = std::chrono::duration<double>(now - start).count();
+    for (const ProducerCounter &counter : counters)
+    {
+      sample.sent += counter.sent.load(std::memory_order_relaxed);
+    }
+    sample.send_rate = static_cast<double>(sample.sent - last_sent) / interval_s;
+    sample.write_rate = static_cast<double>(stats.processed - last_processed) / interval_s;
+    sample.backlog = static_cast<qint64>(stats.enqueued - stats.processed - stats.dropped);
+    sample.max_queue_depth = stats.max_queue_depth;
+    sample.rss_bytes = residentBytes();
+    sample.open_fds = openFileDescriptors();
+    sample.log_dir_bytes = directoryBytes(log_dir);
+    samples.push_back(sample);
+
+    last_sent = sample.sent;
+    last_processed = stats.processed;
+    last_time = now;
+
+    if (series.isOpen())
+    {
+      series.write(sampleToCsv(sample));
+      series.flush();
+    }
+    fprintf(stderr,
+            "[%7.0fs] sent %9.0f/s  written %9.0f/s  backlog %8lld  rss %7.1f MB  fds %4d  logs %8.1f MB\n",
+            sample.elapsed_s,
+            sample.send_rate,
+            sample.write_rate,
+            static_cast<long long>(sample.backlog),
+            static_cast<double>(sample.rss_bytes) / 1024.0 / 1024.0,
+            sample.open_fds,
+            static_cast<double>(sample.log_dir_bytes) / 1024.0 / 1024.0);
+
+    if (spec.duration_s > 0 && sample.elapsed_s >= spec.duration_s)
+    {
+      break;
+    }
+  }
+
+  stop = true;
+  for (std::thread &producer : producers)
+  {
+    producer.join();
+  }
+  std::signal(SIGINT, previous_handler);
+  log_manager.shutdown(config.drain_file_only ? QtUtils::LogManager::DrainMode::FileOnly
+                                              : QtUtils::LogManager::DrainMode::FileAndConsole);
+  return samples;
+}
+
+bool BenchSoak::evaluate(const std::vector<SoakSample> &samples, const SoakSpec &spec, std::vector<SoakCheck> &checks)
+{
+  checks.clear();
+  checks.reserve(4);
+
+  size_t steady_begin = 0;
+  while (steady_begin < samples.size() && samples[steady_begin].elapsed_s <= spec.warmup_s)
+  {
+    ++steady_begin;
+  }
+  const size_t steady_count = samples.size() - steady_begin;
+  if (steady_count < 6)
+  {
+    return false;
+  }
+
+  const size_t third = steady_count / 3;
+  const size_t first_end = steady_begin + third;
+  const size_t last_begin = samples.size() - third;
+
+  auto addCheck = [&](const char *name, auto field)
+  {
+    SoakCheck check;
+    check.name = QString::fromLatin1(name);
+    check.first = medianOf(samples, steady_begin, first_end, field);
+    check.last = medianOf(samples, last_begin, samples.size(), field);
+    check.change_percent = check.first > 0 ? (check.last - check.first) / check.first * 100.0 : 0;
+    checks.push_back(check);
+    return &checks.back();
+  };
+
+  if (samples.front().rss_bytes >= 0)
+  {
+    SoakCheck *rss = addCheck("rss_bytes",
+                              [](const SoakSample &sample)
+                              {
+                                return sample.rss_bytes;
+                              });
+    rss->failed = rss->change_percent > spec.max_rss_growth_percent;
+  }
+
+  SoakCheck *throughput = addCheck("write_rate",
+                                   [](const SoakSample &sample)
+                                   {
+                                     return sample.write_rate;
+                                   });
+  throughput->failed = throughput->change_percent < -spec.max_throughput_drop_percent;
+
+  // A worker that keeps up holds the backlog near zero; one second of messages is allowed as jitter.
+  SoakCheck *backlog = addCheck("backlog",
+                                [](const SoakSample &sample)
+                                {
+                                  return sample.backlog;
+                                });
+  backlog->failed = backlog->last > backlog->first * 2 + spec.rate;
+
+  if (samples.front().open_fds >= 0)
+  {
+    SoakCheck *fds = addCheck("open_fds",
+                              [](const SoakSample &sample)
+                              {
+                                return sample.open_fds;
+                              });
+    fds->failed = fds->last > fds->first + 8;
+  }
+  return true;
+}
+
+QJsonObject BenchSoak::sampleToJson(const SoakSample &sample)
+{
+  QJsonObject json;
+  json["elapsed_s"] = sample.elapsed_s;
+  json["sent"] = static_cast<qint64>(sample.sent);
+  json["send_rate"] = sample.send_rate;
+  json["write_rate"] = sample.write_rate;
+  json["backlog"] = sample.backlog;
+  json["max_queue_depth"] = sample.max_queue_depth;
+  json["rss_bytes"] = sample.rss_bytes;
+  json["open_fds"] = sample.open_fds;
+  json["log_dir_bytes"] = sample.log_dir_bytes;
+  return json;
+}
+
+QJsonObject BenchSoak::toJson(const BenchConfig &config,
+                              const SoakSpec &spec,
+                              const std::vector<SoakSample> &samples,
+                              const std::vector<SoakCheck> &checks,
+                              const HostInfo &host)
+{
+  QJsonObject json_spec;
+  json_spec["duration_s"] = spec.duration_s;
+  json_spec["rate"] = spec.rate;
+  json_spec["warmup_s"] = spec.warmup_s;
+  json_spec["max_rss_growth_percent"] = spec.max_rss_growth_percent;
+  json_spec["max_throughput_drop_percent"] = spec.max_throughput_drop_percent;
+
+  QJsonArray json_samples;
+  for (const SoakSample &sample : samples)
+  {
+    json_samples.append(sampleToJson(sample));
+  }
+
+  bool passed = true;
+  QJsonArray json_checks;
+  for (const SoakCheck &check : checks)
+  {
+    QJsonObject json_check;
+    json_check["name"] = check.name;
+    json_check["first"] = check.first;
+    json_check["last"] = check.last;
+    json_check["change_percent"] = check.change_percent;
+    json_check["failed"] = check.failed;
+    json_checks.append(json_check);
+    passed = passed && !check.failed;
+  }
+
+  QJsonObject report;
+  report["tool"] = QCoreApplication::applicationName();
+  report["version"] = QCoreApplication::applicationVersion();
+  report["qt_version"] = QString::fromLatin1(qVersion());
+  report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+  report["host"] = BenchReport::hostToJson(host);
+  report["config"] = BenchReport::configToJson(config);
+  report["soak"] = json_spec;
+  report["samples"] = json_samples;
+  report["checks"] = json_checks;
+  report["passed"] = passed;
+  return report;
+}
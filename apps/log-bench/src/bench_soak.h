@@ -0,0 +1,62 @@
+#pragma once
+
+#include "bench_report.h"
+#include "bench_types.h"
+#include "qtutils/log_manager.h"
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+struct SoakSpec
+{
+  // 0 runs until interrupted.
+  int duration_s{0};
+  double rate{10000};
+  QString series_path;
+  int warmup_s{10};
+  double max_rss_growth_percent{20};
+  double max_throughput_drop_percent{10};
+};
+
+struct SoakSample
+{
+  double elapsed_s{0};
+  quint64 sent{0};
+  double send_rate{0};
+  double write_rate{0};
+  qint64 backlog{0};
+  qint64 max_queue_depth{0};
+  qint64 rss_bytes{-1};
+  int open_fds{-1};
+  qint64 log_dir_bytes{0};
+};
+
+// One trend check: the median of the first third of the steady-state samples against the last third.
+struct SoakCheck
+{
+  QString name;
+  double first{0};
+  double last{0};
+  double change_percent{0};
+  bool failed{false};
+};
+
+// Logs at a fixed total rate for a long time and samples process and LogManager health every second, so slow
+// leaks and queue growth show up as trends rather than as a single number.
+class BenchSoak
+{
+public:
+  BenchSoak() = delete;
+
+  static std::vector<SoakSample> run(QtUtils::LogManager &log_manager, const BenchConfig &config, const SoakSpec &spec);
+
+  // Returns false if there are too few steady-state samples to judge.
+  static bool evaluate(const std::vector<SoakSample> &samples, const SoakSpec &spec, std::vector<SoakCheck> &checks);
+
+  static QJsonObject sampleToJson(const SoakSample &sample);
+  static QJsonObject toJson(const BenchConfig &config,
+                            const SoakSpec &spec,
+                            const std::vector<SoakSample> &samples,
+                            const std::vector<SoakCheck> &checks,
+                            const HostInfo &host);
+};
@@ -0,0 +1,450 @@
+#include "bench_sweep.h"
+#include "bench_runner.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <tuple>
+
+namespace
+{
+
+struct Scenario
+{
+  const char *name;
+  const char *description;
+};
+
+const Scenario kScenarios[] = {
+    {"lidar-burst", "bursty lidar frames at growing burst sizes and thread counts"},
+    {"steady-firehose", "continuous logging as fast as possible"},
+    {"many-idle-threads", "many threads each logging rarely"},
+    {"error-storm", "critical messages from many threads, file and console"},
+    {"rotation-storm", "rotation every 256 KB with thousands of retained files"},
+};
+
+template <typename T>
+T medianOf(std::vector<T> values)
+{
+  if (values.empty())
+  {
+    return T{};
+  }
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+BenchConfig cellConfig(const BenchConfig &base, int threads, int size, const BurstPattern &burst, SinkSet sinks)
+{
+  BenchConfig config = base;
+  config.thread_count = threads;
+  config.message_size = size;
+  config.simulate_lidar = burst.count > 0;
+  if (burst.count > 0)
+  {
+    config.burst_count = burst.count;
+    config.burst_interval_us = burst.interval_us;
+  }
+  config.enable_file = sinks != SinkSet::Console;
+  config.enable_console = sinks != SinkSet::File;
+  config.measure_e2e = base.measure_e2e && config.enable_file;
+  return config;
+}
+
+SinkSet sinkSetOf(const BenchConfig &config)
+{
+  if (config.enable_file && config.enable_console)
+  {
+    return SinkSet::FileAndConsole;
+  }
+  return config.enable_file ? SinkSet::File : SinkSet::Console;
+}
+
+QString burstText(const BenchConfig &config)
+{
+  return config.simulate_lidar ? QString("%1/%2us").arg(config.burst_count).arg(config.burst_interval_us)
+                               : QStringLiteral("steady");
+}
+
+void summarize(SweepCell &cell)
+{
+  std::vector<double> throughput;
+  std::vector<double> mb_per_sec;
+  std::vector<quint64> p50;
+  std::vector<quint64> p99;
+  std::vector<quint64> p999;
+  std::vector<quint64> rotations;
+  std::vector<quint64> stall_p99;
+  std::vector<quint64> near_p99;
+  for (const BenchResult &run : cell.runs)
+  {
+    throughput.push_back(run.throughput_logs_per_sec);
+    mb_per_sec.push_back(run.throughput_mb_per_sec);
+    p50.push_back(run.latency.percentile(50.0));
+    p99.push_back(run.latency.percentile(99.0));
+    p999.push_back(run.latency.percentile(99.9));
+    rotations.push_back(run.rotation.rotations);
+    stall_p99.push_back(run.rotation.worker_stall.percentile(99.0));
+    near_p99.push_back(run.rotation.producer_near.percentile(99.0));
+  }
+
+  cell.median_throughput = medianOf(throughput);
+  cell.median_mb_per_sec = medianOf(mb_per_sec);
+  cell.median_p50_ns = medianOf(p50);
+  cell.median_p99_ns = medianOf(p99);
+  cell.median_p999_ns = medianOf(p999);
+  cell.median_rotations = medianOf(rotations);
+  cell.median_stall_p99_ns = medianOf(stall_p99);
+  cell.median_near_rotation_p99_ns = medianOf(near_p99);
+  if (!throughput.empty())
+  {
+    cell.min_throughput = *std::min_element(throughput.begin(), throughput.end());
+    cell.max_throughput = *std::max_element(throughput.begin(), throughput.end());
+  }
+}
+
+// Scaling is measured along the thread axis only: cells that differ in nothing but thread count form a curve.
+void computeScaling(std::vector<SweepCell> &cells)
+{
+  using GroupKey = std::tuple<int, bool, int, int, int>;
+  std::map<GroupKey, const SweepCell *> base_cells;
+  auto keyOf = [](const BenchConfig &config)
+  {
+    return GroupKey{config.message_size,
+                    config.simulate_lidar,
+                    config.simulate_lidar ? config.burst_count * 1000000 + config.burst_interval_us : 0,
+                    static_cast<int>(sinkSetOf(config)),
+                    static_cast<int>(config.message_level)};
+  };
+
+  for (const SweepCell &cell : cells)
+  {
+    const SweepCell *&base = base_cells[keyOf(cell.config)];
+    if (base == nullptr || cell.config.thread_count < base->config.thread_count)
+    {
+      base = &cell;
+    }
+  }
+
+  for (SweepCell &cell : cells)
+  {
+    const SweepCell *base = base_cells[keyOf(cell.config)];
+    if (base == nullptr || base->median_throughput <= 0)
+    {
+      continue;
+    }
+    cell.speedup = cell.median_throughput / base->median_throughput;
+    const double thread_ratio =
+        static_cast<double>(cell.config.thread_count) / static_cast<double>(base->config.thread_count);
+    cell.efficiency = cell.speedup / thread_ratio;
+  }
+}
+
+} // namespace
+
+QStringList BenchSweep::scenarioNames()
+{
+  QStringList names;
+  for (const Scenario &scenario : kScenarios)
+  {
+    names.append(QString::fromLatin1(scenario.name));
+  }
+  return names;
+}
+
+bool BenchSweep::scenario(const QString &name, const BenchConfig &base, SweepSpec &spec)
+{
+  spec = SweepSpec{};
+  spec.name = name;
+  spec.base = base;
+
+  if (name == "lidar-burst")
+  {
+    spec.base.logs_per_thread = 20000;
+    spec.threads = {1, 2, 4, 8};
+    spec.sizes = {128, 512};
+    spec.bursts = {{10, 1000}, {100, 1000}, {500, 5000}};
+    spec.sinks = {SinkSet::File};
+  }
+  else if (name == "steady-firehose")
+  {
+    spec.base.logs_per_thread = 50000;
+    spec.threads = {1, 2, 4, 8, 16};
+    spec.sizes = {64, 256, 1024};
+    spec.bursts = {{0, 0}};
+    spec.sinks = {SinkSet::File};
+  }
+  else if (name == "many-idle-threads")
+  {
+    spec.base.logs_per_thread = 100;
+    spec.threads = {32, 64, 128};
+    spec.sizes = {128};
+    spec.bursts = {{1, 10000}};
+    spec.sinks = {SinkSet::File};
+  }
+  else if (name == "error-storm")
+  {
+    spec.base.logs_per_thread = 20000;
+    spec.base.message_level = QtCriticalMsg;
+    spec.threads = {4, 8, 16};
+    spec.sizes = {256};
+    spec.bursts = {{0, 0}, {1000, 100}};
+    spec.sinks = {SinkSet::File, SinkSet::FileAndConsole};
+  }
+  else if (name == "rotation-storm")
+  {
+    spec.base.logs_per_thread = 50000;
+    spec.base.max_file_size = 256 * 1024;
+    spec.base.max_file_count = 5000;
+    spec.base.prefill_files = 4000;
+    spec.base.measure_rotation = true;
+    spec.threads = {1, 4, 8};
+    spec.sizes = {256};
+    spec.bursts = {{0, 0}, {100, 1000}};
+    spec.sinks = {SinkSet::File};
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool BenchSweep::parseBursts(const QString &text, std::vector<BurstPattern> &bursts)
+{
+  bursts.clear();
+  for (const QString &item : text.split(',', Qt::SkipEmptyParts))
+  {
+    const QString trimmed = item.trimmed();
+    if (trimmed == "steady")
+    {
+      bursts.push_back({0, 0});
+      continue;
+    }
+
+    const QStringList parts = trimmed.split(':');
+    bool count_ok = false;
+    bool interval_ok = parts.size() == 1;
+    BurstPattern burst;
+    burst.count = parts.value(0).toInt(&count_ok);
+    if (parts.size() == 2)
+    {
+      burst.interval_us = parts[1].toInt(&interval_ok);
+    }
+    if (!count_ok || !interval_ok || parts.size() > 2 || burst.count < 1 || burst.interval_us < 0)
+    {
+      return false;
+    }
+    bursts.push_back(burst);
+  }
+  return !bursts.empty();
+}
+
+bool BenchSweep::parseSinks(const QString &text, std::vector<SinkSet> &sinks)
+{
+  sinks.clear();
+  for (const QString &item : text.split(',', Qt::SkipEmptyParts))
+  {
+    const QString trimmed = item.trimmed();
+    if (trimmed == "file")
+    {
+      sinks.push_back(SinkSet::File);
+    }
+    else if (trimmed == "console")
+    {
+      sinks.push_back(SinkSet::Console);
+    }
+    else if (trimmed == "both")
+    {
+      sinks.push_back(SinkSet::FileAndConsole);
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !sinks.empty();
+}
+
+const char *BenchSweep::sinkName(SinkSet sinks)
+{
+  switch (sinks)
+  {
+  case SinkSet::File:
+    return "file";
+  case SinkSet::Console:
+    return "console";
+  case SinkSet::FileAndConsole:
+    return "both";
+  }
+  return "?";
+}
+
+std::vector<SweepCell> BenchSweep::run(QtUtils::LogManager &log_manager, const SweepSpec &spec)
+{
+  std::vector<SweepCell> cells;
+  for (SinkSet sinks : spec.sinks)
+  {
+    for (const BurstPattern &burst : spec.bursts)
+    {
+      for (int size : spec.sizes)
+      {
+        for (int threads : spec.threads)
+        {
+          SweepCell cell;
+          cell.config = cellConfig(spec.base, threads, size, burst, sinks);
+          cells.push_back(std::move(cell));
+        }
+      }
+    }
+  }
+
+  const int runs_per_cell = std::max(0, spec.warmup_runs) + std::max(1, spec.repetitions);
+  for (size_t i = 0; i < cells.size(); ++i)
+  {
+    SweepCell &cell = cells[i];
+    fprintf(stderr,
+            "[%zu/%zu] threads=%d size=%d burst=%s sinks=%s\n",
+            i + 1,
+            cells.size(),
+            cell.config.thread_count,
+            cell.config.message_size,
+            qPrintable(burstText(cell.config)),
+            sinkName(sinkSetOf(cell.config)));
+
+    for (int run = 0; run < runs_per_cell; ++run)
+    {
+      BenchResult result = runSession(log_manager, cell.config);
+      if (run >= spec.warmup_runs)
+      {
+        cell.runs.push_back(std::move(result));
+      }
+    }
+    summarize(cell);
+  }
+
+  computeScaling(cells);
+  return cells;
+}
+
+void BenchSweep::printTable(const SweepSpec &spec, const std::vector<SweepCell> &cells)
+{
+  fprintf(stderr, "\n========================================\n");
+  fprintf(stderr,
+          "LogManager Sweep: %s (%d runs per cell after %d warm-up)\n",
+          qPrintable(spec.name),
+          spec.repetitions,
+          spec.warmup_runs);
+  fprintf(stderr, "========================================\n");
+  fprintf(stderr,
+          "%7s %6s %12s %8s %13s %13s %9s %7s %6s %9s %9s %9s\n",
+          "threads",
+          "size",
+          "burst",
+          "sinks",
+          "logs/s",
+          "range",
+          "MB/s",
+          "speedup",
+          "eff",
+          "p50 ns",
+          "p99 ns",
+          "p99.9 ns");
+
+  for (const SweepCell &cell : cells)
+  {
+    const QString range = QString("%1-%2k")
+                              .arg(cell.min_throughput / 1000.0, 0, 'f', 0)
+                              .arg(cell.max_throughput / 1000.0, 0, 'f', 0);
+    fprintf(stderr,
+            "%7d %6d %12s %8s %13.0f %13s %9.2f %6.2fx %5.0f%% %9llu %9llu %9llu\n",
+            cell.config.thread_count,
+            cell.config.message_size,
+            qPrintable(burstText(cell.config)),
+            sinkName(sinkSetOf(cell.config)),
+            cell.median_throughput,
+            qPrintable(range),
+            cell.median_mb_per_sec,
+            cell.speedup,
+            cell.efficiency * 100.0,
+            static_cast<unsigned long long>(cell.median_p50_ns),
+            static_cast<unsigned long long>(cell.median_p99_ns),
+            static_cast<unsigned long long>(cell.median_p999_ns));
+  }
+
+  if (spec.base.measure_rotation)
+  {
+    fprintf(stderr,
+            "\n%7s %6s %12s %10s %14s %16s %9s\n",
+            "threads",
+            "size",
+            "burst",
+            "rotations",
+            "stall p99 us",
+            "near-rot p99 ns",
+            "p99 ns");
+    for (const SweepCell &cell : cells)
+    {
+      fprintf(stderr,
+              "%7d %6d %12s %10llu %14.1f %16llu %9llu\n",
+              cell.config.thread_count,
+              cell.config.message_size,
+              qPrintable(burstText(cell.config)),
+              static_cast<unsigned long long>(cell.median_rotations),
+              static_cast<double>(cell.median_stall_p99_ns) / 1000.0,
+              static_cast<unsigned long long>(cell.median_near_rotation_p99_ns),
+              static_cast<unsigned long long>(cell.median_p99_ns));
+    }
+  }
+  fprintf(stderr, "========================================\n\n");
+}
+
+QJsonObject BenchSweep::toJson(const SweepSpec &spec, const std::vector<SweepCell> &cells, const HostInfo &host)
+{
+  QJsonArray json_cells;
+  for (const SweepCell &cell : cells)
+  {
+    QJsonObject json_cell;
+    json_cell["config"] = BenchReport::configToJson(cell.config);
+    json_cell["median_throughput_logs_per_sec"] = cell.median_throughput;
+    json_cell["min_throughput_logs_per_sec"] = cell.min_throughput;
+    json_cell["max_throughput_logs_per_sec"] = cell.max_throughput;
+    json_cell["median_throughput_mb_per_sec"] = cell.median_mb_per_sec;
+    json_cell["median_p50_ns"] = static_cast<qint64>(cell.median_p50_ns);
+    json_cell["median_p99_ns"] = static_cast<qint64>(cell.median_p99_ns);
+    json_cell["median_p999_ns"] = static_cast<qint64>(cell.median_p999_ns);
+    if (cell.config.enable_file)
+    {
+      json_cell["median_rotations"] = static_cast<qint64>(cell.median_rotations);
+      json_cell["median_rotation_stall_p99_ns"] = static_cast<qint64>(cell.median_stall_p99_ns);
+    }
+    if (cell.config.measure_rotation)
+    {
+      json_cell["median_near_rotation_p99_ns"] = static_cast<qint64>(cell.median_near_rotation_p99_ns);
+    }
+    json_cell["speedup"] = cell.speedup;
+    json_cell["efficiency"] = cell.efficiency;
+
+    QJsonArray runs;
+    for (const BenchResult &run : cell.runs)
+    {
+      runs.append(run.throughput_logs_per_sec);
+    }
+    json_cell["runs_throughput_logs_per_sec"] = runs;
+    json_cells.append(json_cell);
+  }
+
+  QJsonObject report;
+  report["tool"] = QCoreApplication::applicationName();
+  report["version"] = QCoreApplication::applicationVersion();
+  report["qt_version"] = QString::fromLatin1(qVersion());
+  report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+  report["host"] = BenchReport::hostToJson(host);
+  report["scenario"] = spec.name;
+  report["repetitions"] = spec.repetitions;
+  report["warmup_runs"] = spec.warmup_runs;
+  report["cells"] = json_cells;
+  return report;
+}
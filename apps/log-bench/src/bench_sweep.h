@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bench_report.h"
+#include "bench_types.h"
+#include "qtutils/log_manager.h"
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// count == 0 means a steady stream without bursts (lidar simulation off).
+struct BurstPattern
+{
+  int count{0};
+  int interval_us{0};
+};
+
+enum class SinkSet
+{
+  File,
+  Console,
+  FileAndConsole
+};
+
+struct SweepSpec
+{
+  QString name{"custom"};
+  BenchConfig base;
+  std::vector<int> threads;
+  std::vector<int> sizes;
+  std::vector<BurstPattern> bursts;
+  std::vector<SinkSet> sinks;
+  int repetitions{3};
+  int warmup_runs{1};
+};
+
+struct SweepCell
+{
+  BenchConfig config;
+  std::vector<BenchResult> runs;
+  double median_throughput{0};
+  double min_throughput{0};
+  double max_throughput{0};
+  double median_mb_per_sec{0};
+  quint64 median_p50_ns{0};
+  quint64 median_p99_ns{0};
+  quint64 median_p999_ns{0};
+  quint64 median_rotations{0};
+  quint64 median_stall_p99_ns{0};
+  quint64 median_near_rotation_p99_ns{0};
+  // Relative to the cell with the fewest threads and otherwise identical parameters.
+  double speedup{1.0};
+  double efficiency{1.0};
+};
+
+// Runs the cross product of a SweepSpec, restarting LogManager for every run so cells do not share a queue,
+// a log file or a warmed-up worker.
+class BenchSweep
+{
+public:
+  BenchSweep() = delete;
+
+  static QStringList scenarioNames();
+  static bool scenario(const QString &name, const BenchConfig &base, SweepSpec &spec);
+
+  static bool parseBursts(const QString &text, std::vector<BurstPattern> &bursts);
+  static bool parseSinks(const QString &text, std::vector<SinkSet> &sinks);
+  static const char *sinkName(SinkSet sinks);
+
+  static std::vector<SweepCell> run(QtUtils::LogManager &log_manager, const SweepSpec &spec);
+
+  static void printTable(const SweepSpec &spec, const std::vector<SweepCell> &cells);
+  static QJsonObject toJson(const SweepSpec &spec, const std::vector<SweepCell> &cells, const HostInfo &host);
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <QString>
+#include <QtGlobal>
+
+struct BenchConfig
+{
+  int thread_count{4};
+  int logs_per_thread{50000};
+  int message_size{128};
+  int warmup_logs{1000};
+  bool enable_file{true};
+  bool enable_console{true};
+  bool simulate_lidar{true};
+  int burst_count{10};
+  int burst_interval_us{1000};
+  int shutdown_budget_ms{3000};
+  bool drain_file_only{false};
+  quint32 debug_sample_rate{1};
+  bool json_output{false};
+  bool measure_e2e{false};
+  bool measure_perf{false};
+  qint64 flush_size{8 * 1024};
+  int flush_timeout_ms{200};
+  QtMsgType message_level{QtDebugMsg};
+  QString replay_file;
+  // Divides the recorded inter-arrival gaps; 0 replays as fast as possible.
+  double replay_speed{1.0};
+  // LogManager's defaults; applied to every session.
+  qint64 max_file_size{10 * 1024 * 1024};
+  int max_file_count{100};
+  // Tops the log directory up to this many *.log files before each session, so pruning has real work to do.
+  int prefill_files{0};
+  // Keeps every enqueue sample to split producer latency around rotations from the rest.
+  bool measure_rotation{false};
+};
+
+// Totals over a run; -1 where a counter could not be read.
+struct CostCounters
+{
+  qint64 cycles{-1};
+  qint64 instructions{-1};
+  qint64 cache_misses{-1};
+  qint64 context_switches{-1};
+  qint64 page_faults{-1};
+  qint64 allocations{-1};
+  qint64 frees{-1};
+};
+
+struct EnqueueSample
+{
+  // Offset from the start of the run.
+  quint64 at_ns{0};
+  quint64 latency_ns{0};
+};
+
+struct RotationStats
+{
+  quint64 rotations{0};
+  // Per rotation: closing, renaming, pruning old files and opening the next one, during which nothing is written.
+  LatencyHistogram worker_stall;
+  // Producer enqueue latency around a rotation and everywhere else; only with measure_rotation.
+  LatencyHistogram producer_near;
+  LatencyHistogram producer_away;
+};
+
+struct BenchResult
+{
+  qint64 total_logs{0};
+  qint64 total_bytes{0};
+  qint64 elapsed_ms{0};
+  double throughput_logs_per_sec{0};
+  double throughput_mb_per_sec{0};
+  double avg_enqueue_latency_us{0};
+  LatencyHistogram latency;
+  LatencyHistogram e2e_latency;
+  qint64 startup_handler_us{0};
+  qint64 startup_storage_us{0};
+  qint64 shutdown_ms{0};
+  CostCounters producer_cost;
+  CostCounters worker_cost;
+  RotationStats rotation;
+};
@@ -0,0 +1,93 @@
+#include "e2e_probe.h"
+#include "bench_clock.h"
+#include <charconv>
+
+namespace
+{
+
+const char *parseNumber(const char *p, const char *end, quint64 &value)
+{
+  value = 0;
+  const char *begin = p;
+  while (p < end && *p >= '0' && *p <= '9')
+  {
+    value = value * 10 + static_cast<quint64>(*p - '0');
+    ++p;
+  }
+  return p > begin ? p : nullptr;
+}
+
+} // namespace
+
+const char *E2eProbe::formatTag(char (&buffer)[kTagCapacity], quint64 send_ticks, int thread_id)
+{
+  char *p = buffer;
+  char *const end = buffer + kTagCapacity - 1;
+  *p++ = 'e';
+  *p++ = '2';
+  *p++ = 'e';
+  *p++ = '=';
+  p = std::to_chars(p, end, send_ticks).ptr;
+  *p++ = ':';
+  p = std::to_chars(p, end, thread_id).ptr;
+  *p = '\0';
+  return buffer;
+}
+
+E2eProbe::E2eProbe()
+    : matcher_(QByteArrayLiteral("e2e="))
+{
+}
+
+void E2eProbe::attach(QtUtils::LogManager &log_manager)
+{
+  latency_.clear();
+  log_manager.setWriteObserver(
+      [this](const QByteArray &data)
+      {
+        observe(data);
+      });
+}
+
+void E2eProbe::detach(QtUtils::LogManager &log_manager)
+{
+  log_manager.setWriteObserver(nullptr);
+}
+
+void E2eProbe::setStartTicks(quint64 ticks)
+{
+  start_ticks_.store(ticks, std::memory_order_relaxed);
+}
+
+const LatencyHistogram &E2eProbe::latency() const
+{
+  return latency_;
+}
+
+void E2eProbe::observe(const QByteArray &data)
+{
+  // Everything in the block became visible at the same moment.
+  const quint64 visible_ticks = BenchClock::now();
+  const quint64 start_ticks = start_ticks_.load(std::memory_order_relaxed);
+  const char *const begin = data.constData();
+  const char *const end = begin + data.size();
+
+  for (qsizetype pos = matcher_.indexIn(data); pos >= 0; pos = matcher_.indexIn(data, pos + 4))
+  {
+    quint64 send_ticks = 0;
+    quint64 thread_id = 0;
+    const char *p = parseNumber(begin + pos + 4, end, send_ticks);
+    if (p == nullptr || p >= end || *p != ':' || parseNumber(p + 1, end, thread_id) == nullptr)
+    {
+      continue;
+    }
+    if (send_ticks < start_ticks || send_ticks > visible_ticks)
+    {
+      continue;
+    }
+
+    latency_.record(BenchClock::toNanos(visible_ticks - send_ticks),
+                    BenchClock::toNanos(send_ticks - start_ticks),
+                    static_cast<int>(thread_id));
+  }
+}
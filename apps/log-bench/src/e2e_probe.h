@@ -0,0 +1,36 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include "qtutils/log_manager.h"
+#include <QByteArray>
+#include <QByteArrayMatcher>
+#include <atomic>
+
+// Measures enqueue-to-disk latency. Producers prefix messages with a tag holding their send time; a LogManager
+// write observer parses the tags out of every block right after it has been written and flushed to the log file.
+class E2eProbe
+{
+public:
+  static constexpr int kTagCapacity = 48;
+
+  // Writes "e2e=<ticks>:<thread>" into buffer and returns it.
+  static const char *formatTag(char (&buffer)[kTagCapacity], quint64 send_ticks, int thread_id);
+
+  E2eProbe();
+
+  void attach(QtUtils::LogManager &log_manager);
+  // Call after LogManager::shutdown() so the worker has written everything it is going to.
+  void detach(QtUtils::LogManager &log_manager);
+
+  void setStartTicks(quint64 ticks);
+
+  // Only valid after detach().
+  const LatencyHistogram &latency() const;
+
+private:
+  void observe(const QByteArray &data);
+
+  LatencyHistogram latency_;
+  std::atomic<quint64> start_ticks_{0};
+  const QByteArrayMatcher matcher_;
+};
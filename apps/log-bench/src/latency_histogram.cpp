@@ -0,0 +1,120 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(kBucketCount, 0),
+      min_(std::numeric_limits<quint64>::max())
+{
+  stalls_.reserve(kStallCount + 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+  for (int i = 0; i < kBucketCount; ++i)
+  {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  for (const LatencyStall &stall : other.stalls_)
+  {
+    if (stall.latency_ns > stall_threshold_)
+    {
+      recordStall(stall);
+    }
+  }
+}
+
+void LatencyHistogram::clear()
+{
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  sum_ = 0;
+  min_ = std::numeric_limits<quint64>::max();
+  max_ = 0;
+  stalls_.clear();
+  stall_threshold_ = 0;
+}
+
+quint64 LatencyHistogram::count() const
+{
+  return count_;
+}
+
+quint64 LatencyHistogram::min() const
+{
+  return count_ > 0 ? min_ : 0;
+}
+
+quint64 LatencyHistogram::max() const
+{
+  return max_;
+}
+
+double LatencyHistogram::mean() const
+{
+  return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+}
+
+quint64 LatencyHistogram::percentile(double percent) const
+{
+  if (count_ == 0)
+  {
+    return 0;
+  }
+
+  const double clamped = std::min(100.0, std::max(0.0, percent));
+  const quint64 rank = std::max<quint64>(1, static_cast<quint64>(clamped / 100.0 * static_cast<double>(count_) + 0.5));
+  if (rank >= count_)
+  {
+    return max_;
+  }
+
+  quint64 seen = 0;
+  for (int i = 0; i < kBucketCount; ++i)
+  {
+    seen += counts_[i];
+    if (seen >= rank)
+    {
+      return std::min(std::max(bucketMidpoint(i), min()), max_);
+    }
+  }
+  return max_;
+}
+
+const std::vector<LatencyStall> &LatencyHistogram::worstStalls() const
+{
+  return stalls_;
+}
+
+quint64 LatencyHistogram::bucketMidpoint(int index)
+{
+  if (index < 128)
+  {
+    return static_cast<quint64>(index);
+  }
+  const int exponent = (index >> 6) - 1;
+  const quint64 mantissa = static_cast<quint64>(index - (exponent << 6));
+  return (mantissa << exponent) + (quint64{1} << exponent) / 2;
+}
+
+void LatencyHistogram::recordStall(const LatencyStall &stall)
+{
+  auto position = std::upper_bound(stalls_.begin(),
+                                   stalls_.end(),
+                                   stall,
+                                   [](const LatencyStall &a, const LatencyStall &b)
+                                   { return a.latency_ns > b.latency_ns; });
+  stalls_.insert(position, stall);
+  if (stalls_.size() > static_cast<size_t>(kStallCount))
+  {
+    stalls_.pop_back();
+  }
+  if (stalls_.size() == static_cast<size_t>(kStallCount))
+  {
+    stall_threshold_ = stalls_.back().latency_ns;
+  }
+}
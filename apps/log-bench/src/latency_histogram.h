@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QtAlgorithms>
+#include <QtGlobal>
+#include <vector>
+
+struct LatencyStall
+{
+  quint64 latency_ns{0};
+  // Offset from the start of the run.
+  quint64 at_ns{0};
+  int thread_id{0};
+};
+
+// Log-linear (HDR-style) histogram of nanosecond latencies: exact below 128 ns, then 64 sub-buckets per power of
+// two, i.e. within 1.6% everywhere. Each producer thread records into its own instance; they are merged at the end.
+class LatencyHistogram
+{
+public:
+  static constexpr int kStallCount = 10;
+
+  LatencyHistogram();
+
+  void record(quint64 latency_ns, quint64 at_ns, int thread_id)
+  {
+    ++counts_[bucketIndex(latency_ns)];
+    ++count_;
+    sum_ += latency_ns;
+    min_ = latency_ns < min_ ? latency_ns : min_;
+    max_ = latency_ns > max_ ? latency_ns : max_;
+    if (latency_ns > stall_threshold_)
+    {
+      recordStall({latency_ns, at_ns, thread_id});
+    }
+  }
+
+  void merge(const LatencyHistogram &other);
+  void clear();
+
+  quint64 count() const;
+  quint64 min() const;
+  quint64 max() const;
+  double mean() const;
+  quint64 percentile(double percent) const;
+
+  // Slowest calls, slowest first.
+  const std::vector<LatencyStall> &worstStalls() const;
+
+private:
+  static constexpr int kBucketCount = 64 * 59;
+
+  // Values below 128 map to themselves; above that, index = 64 * e + (value >> e) where e keeps 7 significant bits.
+  static int bucketIndex(quint64 value)
+  {
+    if (value < 128)
+    {
+      return static_cast<int>(value);
+    }
+    const int exponent = 63 - static_cast<int>(qCountLeadingZeroBits(value)) - 6;
+    return (exponent << 6) + static_cast<int>(value >> exponent);
+  }
+
+  static quint64 bucketMidpoint(int index);
+  void recordStall(const LatencyStall &stall);
+
+  std::vector<quint64> counts_;
+  quint64 count_{0};
+  quint64 sum_{0};
+  quint64 min_;
+  quint64 max_{0};
+  std::vector<LatencyStall> stalls_;
+  quint64 stall_threshold_{0};
+};
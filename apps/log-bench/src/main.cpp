@@ -1,229 +1,126 @@
+#include "bench_report.h"
+#include "bench_runner.h"
+#include "bench_soak.h"
+#include "bench_sweep.h"
+#include "bench_types.h"
+#include "latency_histogram.h"
+#include "message_corpus.h"
+#include "qtutils/common_utils.h"
 #include "qtutils/log_manager.h"
 #include <QCommandLineParser>
 #include <QCoreApplication>
-#include <QDebug>
 #include <QFile>
+#include <QJsonDocument>
 #include <QTextStream>
-#include <atomic>
 #include <chrono>
 #include <thread>
+#include <utility>
 #include <vector>
 
-struct BenchConfig
+void printLatency(const char *title, const LatencyHistogram &latency)
 {
-  int thread_count{4};
-  int logs_per_thread{50000};
-  int message_size{128};
-  int warmup_logs{1000};
-  bool enable_file{true};
-  bool enable_console{true};
-  bool simulate_lidar{true};
-  int burst_count{10};
-  int burst_interval_us{1000};
-};
-
-struct BenchResult
-{
-  qint64 total_logs{0};
-  qint64 total_bytes{0};
-  qint64 elapsed_ms{0};
-  double throughput_logs_per_sec{0};
-  double throughput_mb_per_sec{0};
-  double avg_enqueue_latency_us{0};
-};
-
-QString generateLidarPointData(int point_count)
-{
-  QString data;
-  data.reserve(point_count * 32);
-  for (int i = 0; i < point_count; ++i)
-  {
-    double angle = i * 0.36;
-    double distance = 5.0 + (i % 100) * 0.1;
-    double intensity = 50 + (i % 50);
-    data += QString("[%1,%2,%3] ").arg(angle, 0, 'f', 2).arg(distance, 0, 'f', 2).arg(intensity, 0, 'f', 1);
-    if (i > 0 && i % 10 == 0)
-    {
-      data += "\n  ";
-    }
-  }
-  return data;
-}
-
-QString generateMessage(int size, int thread_id, int msg_id)
-{
-  if (size <= 0)
-  {
-    return QString("T%1 M%2").arg(thread_id).arg(msg_id);
-  }
-
-  QString msg = QString("LidarData T%1 M%2: ").arg(thread_id, 3, 10, QChar('0')).arg(msg_id, 6, 10, QChar('0'));
-
-  if (msg.length() < size)
+  fprintf(stderr, "\n[%s]\n", title);
+  fprintf(stderr, "  Samples:          %llu\n", static_cast<unsigned long long>(latency.count()));
+  fprintf(stderr, "  p50:              %llu ns\n", static_cast<unsigned long long>(latency.percentile(50.0)));
+  fprintf(stderr, "  p90:              %llu ns\n", static_cast<unsigned long long>(latency.percentile(90.0)));
+  fprintf(stderr, "  p99:              %llu ns\n", static_cast<unsigned long long>(latency.percentile(99.0)));
+  fprintf(stderr, "  p99.9:            %llu ns\n", static_cast<unsigned long long>(latency.percentile(99.9)));
+  fprintf(stderr, "  Max:              %llu ns\n", static_cast<unsigned long long>(latency.max()));
+  fprintf(stderr, "  Worst stalls:\n");
+  for (const LatencyStall &stall : latency.worstStalls())
   {
-    int remaining = size - msg.length();
-    QString payload(remaining, QChar('X'));
-    int midpoint = remaining / 2;
-    payload[midpoint] = ' ';
-    msg += payload;
+    fprintf(stderr,
+            "    %10.1f us at +%.3f ms (thread %d)\n",
+            static_cast<double>(stall.latency_ns) / 1000.0,
+            static_cast<double>(stall.at_ns) / 1e6,
+            stall.thread_id);
   }
-
-  return msg;
 }
 
-void lidarSimulatorThread(int thread_id,
-                          int logs_count,
-                          int message_size,
-                          int burst_count,
-                          int burst_interval_us,
-                          std::atomic<int> &counter,
-                          std::atomic<qint64> &total_bytes,
-                          std::atomic<qint64> &total_latency_us,
-                          std::atomic<bool> &start_flag)
+void printCost(const BenchResult &result)
 {
-  while (!start_flag.load(std::memory_order_acquire))
+  struct Row
   {
-    std::this_thread::yield();
-  }
-
-  int remaining = logs_count;
-  int burst_size = burst_count;
-
-  while (remaining > 0)
+    const char *name;
+    qint64 producer;
+    qint64 worker;
+  };
+  const Row rows[] = {
+      {"Cycles", result.producer_cost.cycles, result.worker_cost.cycles},
+      {"Instructions", result.producer_cost.instructions, result.worker_cost.instructions},
+      {"Cache misses", result.producer_cost.cache_misses, result.worker_cost.cache_misses},
+      {"Context switches", result.producer_cost.context_switches, result.worker_cost.context_switches},
+      {"Page faults", result.producer_cost.page_faults, result.worker_cost.page_faults},
+      {"Allocations", result.producer_cost.allocations, result.worker_cost.allocations},
+      {"Frees", result.producer_cost.frees, result.worker_cost.frees},
+  };
+
+  bool header = false;
+  for (const Row &row : rows)
   {
-    int batch = std::min(burst_size, remaining);
-
-    for (int i = 0; i < batch; ++i)
+    if ((row.producer < 0 && row.worker < 0) || result.total_logs <= 0)
     {
-      auto t1 = std::chrono::steady_clock::now();
-
-      QString msg;
-      if (remaining % 100 == 0)
-      {
-        msg = QString("Frame %1: %2").arg(logs_count - remaining).arg(generateLidarPointData(50));
-      }
-      else
-      {
-        msg = generateMessage(message_size, thread_id, logs_count - remaining);
-      }
-
-      total_bytes += msg.toUtf8().size();
-      qDebug() << msg;
-      ++counter;
-
-      auto t2 = std::chrono::steady_clock::now();
-      total_latency_us += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+      continue;
     }
-
-    remaining -= batch;
-
-    if (remaining > 0 && burst_interval_us > 0)
+    if (!header)
     {
-      std::this_thread::sleep_for(std::chrono::microseconds(burst_interval_us));
+      fprintf(stderr, "\n[Cost per Message]  %14s %14s\n", "producer", "worker");
+      header = true;
     }
+    char producer[32] = "n/a";
+    char worker[32] = "n/a";
+    if (row.producer >= 0)
+    {
+      snprintf(producer, sizeof(producer), "%.3f", static_cast<double>(row.producer) / result.total_logs);
+    }
+    if (row.worker >= 0)
+    {
+      snprintf(worker, sizeof(worker), "%.3f", static_cast<double>(row.worker) / result.total_logs);
+    }
+    fprintf(stderr, "  %-17s %14s %14s\n", row.name, producer, worker);
   }
 }
 
-void standardBenchThread(int thread_id,
-                         int logs_count,
-                         int message_size,
-                         std::atomic<int> &counter,
-                         std::atomic<qint64> &total_bytes,
-                         std::atomic<qint64> &total_latency_us,
-                         std::atomic<bool> &start_flag)
-{
-  while (!start_flag.load(std::memory_order_acquire))
-  {
-    std::this_thread::yield();
-  }
-
-  for (int i = 0; i < logs_count; ++i)
-  {
-    auto t1 = std::chrono::steady_clock::now();
-
-    QString msg = generateMessage(message_size, thread_id, i);
-    total_bytes += msg.toUtf8().size();
-    qDebug() << msg;
-    ++counter;
-
-    auto t2 = std::chrono::steady_clock::now();
-    total_latency_us += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
-  }
-}
-
-void warmup(int count)
+void printRotation(const BenchConfig &config, const RotationStats &rotation)
 {
-  for (int i = 0; i < count; ++i)
+  fprintf(stderr, "\n[Rotation]\n");
+  fprintf(stderr, "  Rotations:        %llu\n", static_cast<unsigned long long>(rotation.rotations));
+  if (rotation.rotations == 0)
   {
-    qDebug() << "Warmup message" << i;
+    return;
   }
-  std::this_thread::sleep_for(std::chrono::milliseconds(100));
-}
-
-BenchResult runBenchmark(const BenchConfig &config)
-{
-  BenchResult result;
-  result.total_logs = static_cast<qint64>(config.thread_count) * config.logs_per_thread;
-
-  std::atomic<int> counter{0};
-  std::atomic<qint64> total_bytes{0};
-  std::atomic<qint64> total_latency_us{0};
-  std::atomic<bool> start_flag{false};
-
-  warmup(config.warmup_logs);
-
-  std::vector<std::thread> threads;
-  threads.reserve(config.thread_count);
-
-  for (int t = 0; t < config.thread_count; ++t)
+  fprintf(stderr,
+          "  Worker stall:     mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+          rotation.worker_stall.mean() / 1000.0,
+          static_cast<double>(rotation.worker_stall.percentile(50.0)) / 1000.0,
+          static_cast<double>(rotation.worker_stall.percentile(99.0)) / 1000.0,
+          static_cast<double>(rotation.worker_stall.max()) / 1000.0);
+  if (!config.measure_rotation)
   {
-    if (config.simulate_lidar)
-    {
-      threads.emplace_back(lidarSimulatorThread,
-                           t,
-                           config.logs_per_thread,
-                           config.message_size,
-                           config.burst_count,
-                           config.burst_interval_us,
-                           std::ref(counter),
-                           std::ref(total_bytes),
-                           std::ref(total_latency_us),
-                           std::ref(start_flag));
-    }
-    else
-    {
-      threads.emplace_back(standardBenchThread,
-                           t,
-                           config.logs_per_thread,
-                           config.message_size,
-                           std::ref(counter),
-                           std::ref(total_bytes),
-                           std::ref(total_latency_us),
-                           std::ref(start_flag));
-    }
+    return;
   }
-
-  auto bench_start = std::chrono::steady_clock::now();
-  start_flag.store(true, std::memory_order_release);
-
-  for (auto &th : threads)
+  fprintf(stderr,
+          "  Producer enqueue  %12s %12s %12s %12s %12s\n",
+          "samples",
+          "p50 ns",
+          "p99 ns",
+          "p99.9 ns",
+          "max ns");
+  const std::pair<const char *, const LatencyHistogram *> rows[] = {
+      {"near rotation", &rotation.producer_near},
+      {"elsewhere", &rotation.producer_away},
+  };
+  for (const auto &row : rows)
   {
-    th.join();
+    fprintf(stderr,
+            "    %-15s %12llu %12llu %12llu %12llu %12llu\n",
+            row.first,
+            static_cast<unsigned long long>(row.second->count()),
+            static_cast<unsigned long long>(row.second->percentile(50.0)),
+            static_cast<unsigned long long>(row.second->percentile(99.0)),
+            static_cast<unsigned long long>(row.second->percentile(99.9)),
+            static_cast<unsigned long long>(row.second->max()));
   }
-
-  auto bench_end = std::chrono::steady_clock::now();
-  result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(bench_end - bench_start).count();
-  result.total_bytes = total_bytes.load();
-  result.avg_enqueue_latency_us =
-      counter.load() > 0 ? static_cast<double>(total_latency_us.load()) / counter.load() : 0;
-
-  result.throughput_logs_per_sec =
-      result.elapsed_ms > 0 ? static_cast<double>(result.total_logs) * 1000.0 / result.elapsed_ms : 0;
-  result.throughput_mb_per_sec =
-      result.elapsed_ms > 0 ? static_cast<double>(result.total_bytes) / 1024.0 / 1024.0 * 1000.0 / result.elapsed_ms
-                            : 0;
-
-  return result;
 }
 
 void printResult(const BenchConfig &config, const BenchResult &result)
@@ -239,11 +136,26 @@ void printResult(const BenchConfig &config, const BenchResult &result)
   fprintf(stderr, "  File logging:     %s\n", config.enable_file ? "enabled" : "disabled");
   fprintf(stderr, "  Console logging:  %s\n", config.enable_console ? "enabled" : "disabled");
   fprintf(stderr, "  Lidar simulation: %s\n", config.simulate_lidar ? "enabled" : "disabled");
+  fprintf(stderr, "  Debug sampling:   1/%u\n", config.debug_sample_rate);
+  fprintf(stderr, "  Output format:    %s\n", config.json_output ? "json-lines" : "text");
+  fprintf(stderr, "  Flush size:       %lld bytes\n", static_cast<long long>(config.flush_size));
+  fprintf(stderr, "  Flush timeout:    %d ms\n", config.flush_timeout_ms);
+  fprintf(stderr,
+          "  File rotation:    every %lld bytes, keeping %d files\n",
+          static_cast<long long>(config.max_file_size),
+          config.max_file_count);
+  if (!config.replay_file.isEmpty())
+  {
+    fprintf(stderr, "  Replay:           %s at %.2fx\n", qPrintable(config.replay_file), config.replay_speed);
+  }
   if (config.simulate_lidar)
   {
     fprintf(stderr, "  Burst count:      %d\n", config.burst_count);
     fprintf(stderr, "  Burst interval:   %d us\n", config.burst_interval_us);
   }
+  fprintf(stderr, "\n[Startup]\n");
+  fprintf(stderr, "  Handler ready:    %lld us\n", result.startup_handler_us);
+  fprintf(stderr, "  Storage ready:    %lld us\n", result.startup_storage_us);
   fprintf(stderr, "\n[Results]\n");
   fprintf(stderr, "  Total logs:       %lld\n", result.total_logs);
   fprintf(stderr, "  App data:         %.2f MB\n", static_cast<double>(result.total_bytes) / 1024.0 / 1024.0);
@@ -251,9 +163,85 @@ void printResult(const BenchConfig &config, const BenchResult &result)
   fprintf(stderr, "  Throughput:       %.0f logs/sec\n", result.throughput_logs_per_sec);
   fprintf(stderr, "  App throughput:   %.2f MB/sec\n", result.throughput_mb_per_sec);
   fprintf(stderr, "  Avg enqueue:      %.2f us\n", result.avg_enqueue_latency_us);
+  printLatency("Enqueue Latency", result.latency);
+  if (config.measure_e2e)
+  {
+    printLatency("End-to-End Latency (enqueue to file write)", result.e2e_latency);
+  }
+  printCost(result);
+  if (config.enable_file)
+  {
+    printRotation(config, result.rotation);
+  }
+  fprintf(stderr, "\n[Shutdown]\n");
+  fprintf(stderr, "  Drain budget:     %d ms\n", config.shutdown_budget_ms);
+  fprintf(stderr, "  Drain mode:       %s\n", config.drain_file_only ? "file only" : "file and console");
+  fprintf(stderr, "  Shutdown time:    %lld ms\n", result.shutdown_ms);
   fprintf(stderr, "========================================\n\n");
 }
 
+bool writeReport(const QByteArray &data, const QString &path)
+{
+  QFile output;
+  bool opened = false;
+  if (!path.isEmpty())
+  {
+    output.setFileName(path);
+    opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+  }
+  else
+  {
+    opened = output.open(stdout, QIODevice::WriteOnly);
+  }
+  if (!opened || output.write(data) != data.size())
+  {
+    fprintf(stderr, "Failed to write report: %s\n", qPrintable(output.errorString()));
+    return false;
+  }
+  return true;
+}
+
+bool parseIntList(const QString &text, std::vector<int> &values)
+{
+  values.clear();
+  for (const QString &item : text.split(',', Qt::SkipEmptyParts))
+  {
+    bool ok = false;
+    const int value = item.trimmed().toInt(&ok);
+    if (!ok || value < 0)
+    {
+      return false;
+    }
+    values.push_back(value);
+  }
+  return !values.empty();
+}
+
+bool parseLevel(const QString &text, QtMsgType &level)
+{
+  if (text == "debug")
+  {
+    level = QtDebugMsg;
+  }
+  else if (text == "info")
+  {
+    level = QtInfoMsg;
+  }
+  else if (text == "warning")
+  {
+    level = QtWarningMsg;
+  }
+  else if (text == "critical")
+  {
+    level = QtCriticalMsg;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char **argv)
 {
   QCoreApplication app(argc, argv);
@@ -273,6 +261,53 @@ int main(int argc, char **argv)
   QCommandLineOption noLidarOption("no-lidar", "Disable lidar simulation mode");
   QCommandLineOption burstOption("burst", "Logs per burst in lidar mode (default: 10)", "count", "10");
   QCommandLineOption intervalOption("interval", "Burst interval in microseconds (default: 1000)", "us", "1000");
+  QCommandLineOption shutdownBudgetOption(
+      "shutdown-budget", "Shutdown drain time budget in ms, 0 for unlimited (default: 3000)", "ms", "3000");
+  QCommandLineOption drainFileOnlyOption("drain-file-only", "Skip console output when draining on shutdown");
+  QCommandLineOption jsonOption("json-lines", "Write log output as JSON lines");
+  QCommandLineOption sampleDebugOption("sample-debug", "Keep one in N debug messages (default: 1)", "n", "1");
+  QCommandLineOption e2eOption("e2e", "Measure enqueue-to-file latency with send-time tags in each message");
+  QCommandLineOption perfOption(
+      "perf", "Count cycles, instructions, cache misses, context switches and page faults per message");
+  QCommandLineOption flushSizeOption("flush-size", "Worker write batch size in bytes (default: 8192)", "bytes", "8192");
+  QCommandLineOption flushTimeoutOption("flush-timeout", "Worker wake-up interval in ms (default: 200)", "ms", "200");
+  QCommandLineOption maxFileSizeOption(
+      "max-file-size", "Rotate the log file at this size (default: 10485760)", "bytes", "10485760");
+  QCommandLineOption maxFilesOption("max-files", "Log files kept after rotation (default: 100)", "count", "100");
+  QCommandLineOption prefillFilesOption(
+      "prefill-files", "Fill the log directory up to this many files before each run (default: 0)", "count", "0");
+  QCommandLineOption formatOption("format", "Machine-readable report: json or csv (default: none)", "format");
+  QCommandLineOption outputOption("output", "Write the machine-readable report here instead of stdout", "file");
+  QCommandLineOption baselineOption("baseline", "JSON report of a previous run to compare against", "file");
+  QCommandLineOption thresholdOption(
+      "threshold", "Allowed regression against the baseline in percent (default: 10)", "percent", "10");
+  QCommandLineOption levelOption(
+      "level", "Message level: debug, info, warning or critical (default: debug)", "level", "debug");
+  QCommandLineOption scenarioOption(
+      "scenario", "Run a built-in sweep: " + BenchSweep::scenarioNames().join(", "), "name");
+  QCommandLineOption sweepThreadsOption("sweep-threads", "Sweep over thread counts, e.g. 1,2,4,8", "list");
+  QCommandLineOption sweepSizesOption("sweep-sizes", "Sweep over message sizes, e.g. 64,256,1024", "list");
+  QCommandLineOption sweepBurstsOption(
+      "sweep-bursts", "Sweep over burst patterns count:interval_us or steady, e.g. 10:1000,steady", "list");
+  QCommandLineOption sweepSinksOption("sweep-sinks", "Sweep over sinks: file, console, both", "list");
+  QCommandLineOption repeatOption("repeat", "Measured runs per sweep cell (default: 3)", "count", "3");
+  QCommandLineOption warmupRunsOption("warmup-runs", "Discarded runs per sweep cell (default: 1)", "count", "1");
+  QCommandLineOption replayOption("replay",
+                                  "Re-issue the messages of a LogManager log with their original timing, "
+                                  "one producer per original thread up to --threads",
+                                  "logfile");
+  QCommandLineOption replaySpeedOption(
+      "replay-speed", "Replay time scale, 2 = twice as fast, 0 = no delays (default: 1)", "factor", "1");
+  QCommandLineOption durationOption(
+      "duration", "Soak mode: log at --rate for this many seconds, 0 until interrupted", "seconds");
+  QCommandLineOption rateOption("rate", "Soak mode total messages per second (default: 10000)", "count", "10000");
+  QCommandLineOption seriesOption("series", "Soak mode: append one CSV sample per second to this file", "file");
+  QCommandLineOption soakWarmupOption(
+      "soak-warmup", "Soak mode: seconds excluded from trend checks (default: 10)", "seconds", "10");
+  QCommandLineOption maxRssGrowthOption(
+      "max-rss-growth", "Soak mode: allowed RSS growth in percent (default: 20)", "percent", "20");
+  QCommandLineOption maxThroughputDropOption(
+      "max-throughput-drop", "Soak mode: allowed write rate drop in percent (default: 10)", "percent", "10");
 
   parser.addOption(threadsOption);
   parser.addOption(logsOption);
@@ -282,9 +317,47 @@ int main(int argc, char **argv)
   parser.addOption(noLidarOption);
   parser.addOption(burstOption);
   parser.addOption(intervalOption);
+  parser.addOption(shutdownBudgetOption);
+  parser.addOption(drainFileOnlyOption);
+  parser.addOption(sampleDebugOption);
+  parser.addOption(jsonOption);
+  parser.addOption(e2eOption);
+  parser.addOption(perfOption);
+  parser.addOption(flushSizeOption);
+  parser.addOption(flushTimeoutOption);
+  parser.addOption(maxFileSizeOption);
+  parser.addOption(maxFilesOption);
+  parser.addOption(prefillFilesOption);
+  parser.addOption(formatOption);
+  parser.addOption(outputOption);
+  parser.addOption(baselineOption);
+  parser.addOption(thresholdOption);
+  parser.addOption(levelOption);
+  parser.addOption(scenarioOption);
+  parser.addOption(sweepThreadsOption);
+  parser.addOption(sweepSizesOption);
+  parser.addOption(sweepBurstsOption);
+  parser.addOption(sweepSinksOption);
+  parser.addOption(repeatOption);
+  parser.addOption(warmupRunsOption);
+  parser.addOption(replayOption);
+  parser.addOption(replaySpeedOption);
+  parser.addOption(durationOption);
+  parser.addOption(rateOption);
+  parser.addOption(seriesOption);
+  parser.addOption(soakWarmupOption);
+  parser.addOption(maxRssGrowthOption);
+  parser.addOption(maxThroughputDropOption);
 
   parser.process(app);
 
+  const QString report_format = parser.value(formatOption).toLower();
+  if (!report_format.isEmpty() && report_format != "json" && report_format != "csv")
+  {
+    fprintf(stderr, "Invalid --format: %s\n", qPrintable(report_format));
+    return 1;
+  }
+
   BenchConfig config;
   config.thread_count = parser.value(threadsOption).toInt();
   config.logs_per_thread = parser.value(logsOption).toInt();
@@ -294,22 +367,245 @@ int main(int argc, char **argv)
   config.simulate_lidar = !parser.isSet(noLidarOption);
   config.burst_count = parser.value(burstOption).toInt();
   config.burst_interval_us = parser.value(intervalOption).toInt();
+  config.shutdown_budget_ms = parser.value(shutdownBudgetOption).toInt();
+  config.drain_file_only = parser.isSet(drainFileOnlyOption);
+  config.debug_sample_rate = std::max(1u, parser.value(sampleDebugOption).toUInt());
+  config.json_output = parser.isSet(jsonOption);
+  config.measure_e2e = parser.isSet(e2eOption);
+  config.measure_perf = parser.isSet(perfOption);
+  config.flush_size = std::max<qint64>(1, parser.value(flushSizeOption).toLongLong());
+  config.flush_timeout_ms = std::max(1, parser.value(flushTimeoutOption).toInt());
+  config.max_file_size = std::max<qint64>(1, parser.value(maxFileSizeOption).toLongLong());
+  config.max_file_count = std::max(1, parser.value(maxFilesOption).toInt());
+  config.prefill_files = std::max(0, parser.value(prefillFilesOption).toInt());
+  config.measure_rotation = parser.isSet(maxFileSizeOption) || parser.isSet(maxFilesOption);
 
   config.thread_count = std::max(1, config.thread_count);
   config.logs_per_thread = std::max(1, config.logs_per_thread);
   config.message_size = std::max(0, config.message_size);
   config.burst_count = std::max(1, config.burst_count);
   config.burst_interval_us = std::max(0, config.burst_interval_us);
+  config.shutdown_budget_ms = std::max(0, config.shutdown_budget_ms);
 
-  QtUtils::LogManager::instance().configure(QtDebugMsg, config.enable_console, config.enable_file);
+  if (!parseLevel(parser.value(levelOption).toLower(), config.message_level))
+  {
+    fprintf(stderr, "Invalid --level: %s\n", qPrintable(parser.value(levelOption)));
+    return 1;
+  }
 
-  fprintf(stderr, "Starting benchmark...\n");
+  const bool sweep_mode = parser.isSet(scenarioOption) || parser.isSet(sweepThreadsOption) ||
+                          parser.isSet(sweepSizesOption) || parser.isSet(sweepBurstsOption) ||
+                          parser.isSet(sweepSinksOption);
+  const bool soak_mode = parser.isSet(durationOption);
+  if ((sweep_mode && parser.isSet(replayOption)) || (soak_mode && (sweep_mode || parser.isSet(replayOption))))
+  {
+    fprintf(stderr, "--duration, --replay and sweeps cannot be combined\n");
+    return 1;
+  }
+
+  SoakSpec soak;
+  if (soak_mode)
+  {
+    soak.duration_s = std::max(0, parser.value(durationOption).toInt());
+    soak.rate = std::max(1.0, parser.value(rateOption).toDouble());
+    soak.series_path = parser.value(seriesOption);
+    soak.warmup_s = std::max(0, parser.value(soakWarmupOption).toInt());
+    soak.max_rss_growth_percent = parser.value(maxRssGrowthOption).toDouble();
+    soak.max_throughput_drop_percent = parser.value(maxThroughputDropOption).toDouble();
+  }
+
+  ReplayStreams replay;
+  if (parser.isSet(replayOption))
+  {
+    QString error;
+    config.replay_file = parser.value(replayOption);
+    config.replay_speed = std::max(0.0, parser.value(replaySpeedOption).toDouble());
+    if (!MessageCorpus::loadReplay(config.replay_file, config.thread_count, replay, error))
+    {
+      fprintf(stderr, "%s\n", qPrintable(error));
+      return 1;
+    }
+    config.thread_count = static_cast<int>(replay.size());
+  }
+
+  SweepSpec spec;
+  if (sweep_mode)
+  {
+    if (parser.isSet(scenarioOption))
+    {
+      if (!BenchSweep::scenario(parser.value(scenarioOption), config, spec))
+      {
+        fprintf(stderr,
+                "Unknown --scenario: %s (available: %s)\n",
+                qPrintable(parser.value(scenarioOption)),
+                qPrintable(BenchSweep::scenarioNames().join(", ")));
+        return 1;
+      }
+    }
+    else
+    {
+      spec.base = config;
+      spec.threads = {config.thread_count};
+      spec.sizes = {config.message_size};
+      spec.bursts = {config.simulate_lidar ? BurstPattern{config.burst_count, config.burst_interval_us}
+                                           : BurstPattern{}};
+      if (config.enable_file && config.enable_console)
+      {
+        spec.sinks = {SinkSet::FileAndConsole};
+      }
+      else
+      {
+        spec.sinks = {config.enable_file ? SinkSet::File : SinkSet::Console};
+      }
+    }
+
+    // Explicit axes override the scenario's own.
+    if ((parser.isSet(sweepThreadsOption) && !parseIntList(parser.value(sweepThreadsOption), spec.threads)) ||
+        (parser.isSet(sweepSizesOption) && !parseIntList(parser.value(sweepSizesOption), spec.sizes)) ||
+        (parser.isSet(sweepBurstsOption) && !BenchSweep::parseBursts(parser.value(sweepBurstsOption), spec.bursts)) ||
+        (parser.isSet(sweepSinksOption) && !BenchSweep::parseSinks(parser.value(sweepSinksOption), spec.sinks)))
+    {
+      fprintf(stderr, "Invalid sweep axis\n");
+      return 1;
+    }
+    for (int &threads : spec.threads)
+    {
+      threads = std::max(1, threads);
+    }
+    spec.repetitions = std::max(1, parser.value(repeatOption).toInt());
+    spec.warmup_runs = std::max(0, parser.value(warmupRunsOption).toInt());
+
+    if (parser.isSet(baselineOption))
+    {
+      fprintf(stderr, "--baseline is not supported in sweep mode; ignoring it\n");
+    }
+  }
+
+  auto startup_begin = std::chrono::steady_clock::now();
+  QtUtils::LogManager &log_manager = QtUtils::LogManager::instance();
+  auto handler_ready = std::chrono::steady_clock::now();
+  while (!log_manager.isStorageReady())
+  {
+    std::this_thread::yield();
+  }
+  auto storage_ready = std::chrono::steady_clock::now();
+
+  if (config.measure_e2e && !config.enable_file)
+  {
+    fprintf(stderr, "--e2e needs file logging; ignoring it\n");
+    config.measure_e2e = false;
+  }
+
+  if (soak_mode)
+  {
+    fprintf(stderr,
+            "Starting soak at %.0f msgs/s for %s...\n",
+            soak.rate,
+            soak.duration_s > 0 ? qPrintable(QString("%1 s").arg(soak.duration_s)) : "until interrupted");
+    const std::vector<SoakSample> samples = BenchSoak::run(log_manager, config, soak);
+
+    std::vector<SoakCheck> checks;
+    const bool conclusive = BenchSoak::evaluate(samples, soak, checks);
+    bool failed = false;
+    fprintf(stderr, "\n[Soak] %zu samples\n", samples.size());
+    if (!conclusive)
+    {
+      fprintf(stderr, "  Too few samples after the %d s warm-up to judge trends\n", soak.warmup_s);
+    }
+    for (const SoakCheck &check : checks)
+    {
+      fprintf(stderr,
+              "  %-12s %16.1f -> %16.1f  %+8.2f%%  %s\n",
+              qPrintable(check.name),
+              check.first,
+              check.last,
+              check.change_percent,
+              check.failed ? "FAIL" : "ok");
+      failed = failed || check.failed;
+    }
+
+    if (!report_format.isEmpty())
+    {
+      const QJsonObject report = BenchSoak::toJson(
+          config, soak, samples, checks, BenchReport::collectHostInfo(QtUtils::CommonUtils::getAppLogDirPath()));
+      const QByteArray data = report_format == "csv" ? BenchReport::toCsv(report.value("samples").toArray())
+                                                     : QJsonDocument(report).toJson(QJsonDocument::Indented);
+      if (!writeReport(data, parser.value(outputOption)))
+      {
+        return 1;
+      }
+    }
+    return failed ? 2 : 0;
+  }
 
-  BenchResult result = runBenchmark(config);
+  if (sweep_mode)
+  {
+    fprintf(stderr, "Starting sweep %s...\n", qPrintable(spec.name));
+    const std::vector<SweepCell> cells = BenchSweep::run(log_manager, spec);
+    BenchSweep::printTable(spec, cells);
+    if (report_format.isEmpty())
+    {
+      return 0;
+    }
 
-  QtUtils::LogManager::instance().shutdown();
+    const QJsonObject report =
+        BenchSweep::toJson(spec, cells, BenchReport::collectHostInfo(QtUtils::CommonUtils::getAppLogDirPath()));
+    const QByteArray data = report_format == "csv" ? BenchReport::toCsv(report.value("cells").toArray())
+                                                   : QJsonDocument(report).toJson(QJsonDocument::Indented);
+    return writeReport(data, parser.value(outputOption)) ? 0 : 1;
+  }
+
+  fprintf(stderr, "Starting benchmark...\n");
+
+  BenchResult result = runSession(log_manager, config, replay.empty() ? nullptr : &replay);
+  result.startup_handler_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(handler_ready - startup_begin).count();
+  result.startup_storage_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(storage_ready - startup_begin).count();
 
   printResult(config, result);
 
+  const QJsonObject report =
+      BenchReport::toJson(config, result, BenchReport::collectHostInfo(QtUtils::CommonUtils::getAppLogDirPath()));
+  if (!report_format.isEmpty())
+  {
+    const QByteArray data = report_format == "csv" ? BenchReport::toCsv(report)
+                                                   : QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (!writeReport(data, parser.value(outputOption)))
+    {
+      return 1;
+    }
+  }
+
+  if (parser.isSet(baselineOption))
+  {
+    const double threshold = parser.value(thresholdOption).toDouble();
+    std::vector<MetricComparison> comparisons;
+    QString error;
+    if (!BenchReport::compareWithBaseline(report, parser.value(baselineOption), threshold, comparisons, error))
+    {
+      fprintf(stderr, "%s\n", qPrintable(error));
+      return 1;
+    }
+
+    bool regressed = false;
+    fprintf(stderr, "[Baseline] %s (threshold %.1f%%)\n", qPrintable(parser.value(baselineOption)), threshold);
+    for (const MetricComparison &comparison : comparisons)
+    {
+      fprintf(stderr,
+              "  %-36s %14.1f -> %14.1f  %+7.2f%%  %s\n",
+              qPrintable(comparison.metric),
+              comparison.baseline,
+              comparison.current,
+              comparison.change_percent,
+              comparison.regressed ? "REGRESSION" : "ok");
+      regressed = regressed || comparison.regressed;
+    }
+    if (regressed)
+    {
+      return 2;
+    }
+  }
+
   return 0;
 }
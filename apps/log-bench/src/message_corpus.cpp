@@ -0,0 +1,226 @@
+#include "message_corpus.h"
+#include "qtutils/log_line.h"
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+namespace
+{
+
+QString generateLidarPointData(int point_count)
+{
+  QString data;
+  data.reserve(point_count * 32);
+  for (int i = 0; i < point_count; ++i)
+  {
+    double angle = i * 0.36;
+    double distance = 5.0 + (i % 100) * 0.1;
+    double intensity = 50 + (i % 50);
+    data += QString("[%1,%2,%3] ").arg(angle, 0, 'f', 2).arg(distance, 0, 'f', 2).arg(intensity, 0, 'f', 1);
+    if (i > 0 && i % 10 == 0)
+    {
+      data += "\n  ";
+    }
+  }
+  return data;
+}
+
+QString generateMessage(int size, int thread_id, int msg_id)
+{
+  if (size <= 0)
+  {
+    return QString("T%1 M%2").arg(thread_id).arg(msg_id);
+  }
+
+  QString msg = QString("LidarData T%1 M%2: ").arg(thread_id, 3, 10, QChar('0')).arg(msg_id, 6, 10, QChar('0'));
+
+  if (msg.length() < size)
+  {
+    int remaining = size - msg.length();
+    QString payload(remaining, QChar('X'));
+    int midpoint = remaining / 2;
+    payload[midpoint] = ' ';
+    msg += payload;
+  }
+
+  return msg;
+}
+
+QtMsgType levelFromIndex(int index)
+{
+  switch (index)
+  {
+  case 1:
+    return QtInfoMsg;
+  case 2:
+    return QtWarningMsg;
+  case 3:
+  case 4:
+    // Fatal entries are replayed as critical so the replay does not abort.
+    return QtCriticalMsg;
+  default:
+    return QtDebugMsg;
+  }
+}
+
+struct ParsedLine
+{
+  qint64 timestamp_ms{0};
+  QtMsgType level{QtDebugMsg};
+  QByteArray thread;
+  QByteArray message;
+};
+
+// [yyyy-MM-dd hh:mm:ss.zzz] [LEVEL] [file:line] [tid] [sample 1/N] message
+bool parseTextLine(const QByteArray &line, ParsedLine &parsed)
+{
+  qsizetype pos = 0;
+  for (int field = 0; field < 4; ++field)
+  {
+    const qsizetype close = line.indexOf("] ", pos);
+    if (pos >= line.size() || line.at(pos) != '[' || close < 0)
+    {
+      return false;
+    }
+    if (field == 3)
+    {
+      parsed.thread = line.mid(pos + 1, close - pos - 1);
+    }
+    pos = close + 2;
+  }
+  if (line.mid(pos, 10) == "[sample 1/")
+  {
+    const qsizetype close = line.indexOf("] ", pos);
+    pos = close < 0 ? pos : close + 2;
+  }
+
+  const QDateTime timestamp = QDateTime::fromString(
+      QString::fromLatin1(line.constData() + 1, QtUtils::LogLine::kTimestampLength), "yyyy-MM-dd hh:mm:ss.zzz");
+  if (!timestamp.isValid())
+  {
+    return false;
+  }
+  parsed.timestamp_ms = timestamp.toMSecsSinceEpoch();
+  parsed.level = levelFromIndex(QtUtils::LogLine::levelIndex(line.constData(), line.size()));
+  parsed.message = line.mid(pos);
+  return true;
+}
+
+bool parseJsonLine(const QByteArray &line, ParsedLine &parsed)
+{
+  const QJsonObject object = QJsonDocument::fromJson(line).object();
+  if (!object.contains("ts_ms") || !object.contains("msg"))
+  {
+    return false;
+  }
+  parsed.timestamp_ms = static_cast<qint64>(object.value("ts_ms").toDouble());
+  parsed.level = levelFromIndex(QtUtils::LogLine::levelIndex(object.value("level").toString()));
+  parsed.thread = object.value("tid").toString().toUtf8();
+  parsed.message = object.value("msg").toString().toUtf8();
+  return true;
+}
+
+} // namespace
+
+std::vector<CorpusEntry> MessageCorpus::generate(const BenchConfig &config, int thread_id)
+{
+  const int count = std::min(config.logs_per_thread, kMaxGenerated);
+  std::vector<CorpusEntry> corpus;
+  corpus.reserve(static_cast<size_t>(count));
+  for (int i = 0; i < count; ++i)
+  {
+    CorpusEntry entry;
+    if (config.simulate_lidar && i % 100 == 0)
+    {
+      entry.text = QString("Frame %1: %2").arg(i).arg(generateLidarPointData(50));
+    }
+    else
+    {
+      entry.text = generateMessage(config.message_size, thread_id, i);
+    }
+    entry.bytes = entry.text.toUtf8().size();
+    entry.level = config.message_level;
+    corpus.push_back(std::move(entry));
+  }
+  return corpus;
+}
+
+bool MessageCorpus::loadReplay(const QString &path, int thread_count, ReplayStreams &streams, QString &error)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    error = QString("Cannot open %1: %2").arg(path, file.errorString());
+    return false;
+  }
+
+  thread_count = std::max(1, thread_count);
+  streams.assign(static_cast<size_t>(thread_count), {});
+  QHash<QByteArray, int> thread_slots;
+  qint64 first_ms = -1;
+  std::vector<CorpusEntry> *current_stream = nullptr;
+
+  while (!file.atEnd())
+  {
+    QByteArray line = file.readLine();
+    while (line.endsWith('\n') || line.endsWith('\r'))
+    {
+      line.chop(1);
+    }
+    if (line.isEmpty())
+    {
+      continue;
+    }
+
+    ParsedLine parsed;
+    const bool is_entry = QtUtils::LogLine::findTimestamp(line.constData(), line.size()) != nullptr &&
+                          (line.startsWith('{') ? parseJsonLine(line, parsed) : parseTextLine(line, parsed));
+    if (!is_entry)
+    {
+      if (current_stream != nullptr && !current_stream->empty())
+      {
+        CorpusEntry &previous = current_stream->back();
+        previous.text += '\n' + QString::fromUtf8(line);
+        previous.bytes += line.size() + 1;
+      }
+      continue;
+    }
+
+    if (first_ms < 0)
+    {
+      first_ms = parsed.timestamp_ms;
+    }
+    auto slot = thread_slots.find(parsed.thread);
+    if (slot == thread_slots.end())
+    {
+      slot = thread_slots.insert(parsed.thread, thread_slots.size() % thread_count);
+    }
+    current_stream = &streams[static_cast<size_t>(slot.value())];
+
+    CorpusEntry entry;
+    entry.text = QString::fromUtf8(parsed.message);
+    entry.bytes = parsed.message.size();
+    entry.level = parsed.level;
+    // Entries of one thread can be written slightly out of order; a stream never goes back in time.
+    const qint64 previous_ns = current_stream->empty() ? 0 : current_stream->back().offset_ns;
+    entry.offset_ns = std::max(previous_ns, (parsed.timestamp_ms - first_ms) * 1000000);
+    current_stream->push_back(std::move(entry));
+  }
+
+  streams.erase(std::remove_if(streams.begin(),
+                               streams.end(),
+                               [](const std::vector<CorpusEntry> &stream)
+                               {
+                                 return stream.empty();
+                               }),
+                streams.end());
+  if (streams.empty())
+  {
+    error = QString("No log entries found in %1").arg(path);
+    return false;
+  }
+  return true;
+}
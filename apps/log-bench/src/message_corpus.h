@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bench_types.h"
+#include <QString>
+#include <vector>
+
+struct CorpusEntry
+{
+  QString text;
+  qint64 bytes{0};
+  QtMsgType level{QtDebugMsg};
+  // Replay only: send time relative to the first entry of the replayed log.
+  qint64 offset_ns{0};
+};
+
+using ReplayStreams = std::vector<std::vector<CorpusEntry>>;
+
+// Messages are built before the timed region so producers only pay for logging them.
+class MessageCorpus
+{
+public:
+  MessageCorpus() = delete;
+
+  // Multiple of the lidar frame cadence (every 100th message), so cycling the corpus keeps the mix intact.
+  static constexpr int kMaxGenerated = 4000;
+
+  // Up to kMaxGenerated messages for one producer thread; producers cycle through them.
+  static std::vector<CorpusEntry> generate(const BenchConfig &config, int thread_id);
+
+  // Splits a LogManager log (text or JSON lines) into per-thread streams by original thread id, folding the
+  // original threads onto thread_count producers. Continuation lines stay with their entry.
+  static bool loadReplay(const QString &path, int thread_count, ReplayStreams &streams, QString &error);
+};
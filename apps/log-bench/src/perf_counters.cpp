@@ -0,0 +1,197 @@
+#include "perf_counters.h"
+#include <QDir>
+#include <QFile>
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#if defined(Q_OS_LINUX)
+
+struct EventSpec
+{
+  quint32 type;
+  quint64 config;
+};
+
+const EventSpec kEvents[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+int openEvent(const EventSpec &spec, qint64 tid)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Context switches and page faults are accounted in the kernel; excluding it would always read 0.
+  if (spec.type == PERF_TYPE_SOFTWARE)
+  {
+    attr.exclude_kernel = 0;
+  }
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, static_cast<pid_t>(tid), -1, -1, 0));
+}
+
+qint64 readScaled(int fd)
+{
+  quint64 values[3] = {0, 0, 0};
+  if (fd < 0 || read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+  {
+    return -1;
+  }
+  if (values[2] == 0)
+  {
+    return 0;
+  }
+  return static_cast<qint64>(static_cast<double>(values[0]) * values[1] / values[2]);
+}
+
+#endif
+
+void addCount(qint64 &field, qint64 value)
+{
+  if (value < 0)
+  {
+    return;
+  }
+  field = (field < 0 ? 0 : field) + value;
+}
+
+} // namespace
+
+PerfCounters::PerfCounters()
+{
+  for (int &fd : fds_)
+  {
+    fd = -1;
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(Q_OS_LINUX)
+  for (int fd : fds_)
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+  }
+#endif
+}
+
+bool PerfCounters::open(qint64 tid)
+{
+#if defined(Q_OS_LINUX)
+  bool any = false;
+  for (int event = 0; event < kEventCount; ++event)
+  {
+    fds_[event] = openEvent(kEvents[event], tid);
+    if (fds_[event] >= 0)
+    {
+      any = true;
+    }
+    else if (error_.isEmpty())
+    {
+      error_ = QString::fromLocal8Bit(std::strerror(errno));
+      if (errno == EACCES || errno == EPERM)
+      {
+        error_ += QStringLiteral(" (see /proc/sys/kernel/perf_event_paranoid)");
+      }
+    }
+  }
+  return any;
+#else
+  Q_UNUSED(tid);
+  error_ = QStringLiteral("perf events are only supported on Linux");
+  return false;
+#endif
+}
+
+void PerfCounters::start()
+{
+#if defined(Q_OS_LINUX)
+  for (int fd : fds_)
+  {
+    if (fd >= 0)
+    {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+void PerfCounters::stop()
+{
+#if defined(Q_OS_LINUX)
+  for (int fd : fds_)
+  {
+    if (fd >= 0)
+    {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+#endif
+}
+
+void PerfCounters::addTo(CostCounters &costs) const
+{
+#if defined(Q_OS_LINUX)
+  addCount(costs.cycles, readScaled(fds_[Cycles]));
+  addCount(costs.instructions, readScaled(fds_[Instructions]));
+  addCount(costs.cache_misses, readScaled(fds_[CacheMisses]));
+  addCount(costs.context_switches, readScaled(fds_[ContextSwitches]));
+  addCount(costs.page_faults, readScaled(fds_[PageFaults]));
+#else
+  Q_UNUSED(costs);
+#endif
+}
+
+QString PerfCounters::errorString() const
+{
+  return error_;
+}
+
+qint64 PerfCounters::currentThreadId()
+{
+#if defined(Q_OS_LINUX)
+  return static_cast<qint64>(syscall(SYS_gettid));
+#else
+  return -1;
+#endif
+}
+
+qint64 PerfCounters::findThread(const QString &name)
+{
+#if defined(Q_OS_LINUX)
+  const QDir tasks(QStringLiteral("/proc/self/task"));
+  for (const QString &task : tasks.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+  {
+    QFile comm(tasks.filePath(task + QStringLiteral("/comm")));
+    if (comm.open(QIODevice::ReadOnly) && QString::fromUtf8(comm.readAll().trimmed()) == name)
+    {
+      return task.toLongLong();
+    }
+  }
+#else
+  Q_UNUSED(name);
+#endif
+  return -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "bench_types.h"
+#include <QString>
+
+// Hardware and software counters of one thread through perf_event_open (Linux only). Events the kernel refuses,
+// e.g. under a strict perf_event_paranoid or in a VM without a PMU, are left out and reported as unavailable.
+class PerfCounters
+{
+public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  // tid 0 is the calling thread. Returns false if no event could be opened; errorString() tells why.
+  bool open(qint64 tid = 0);
+  void start();
+  void stop();
+  // Adds the counts, scaled up if the kernel multiplexed the events, to the matching fields of costs.
+  void addTo(CostCounters &costs) const;
+  QString errorString() const;
+
+  static qint64 currentThreadId();
+  // Kernel id of the thread with this name in the current process, or -1.
+  static qint64 findThread(const QString &name);
+
+private:
+  enum Event
+  {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    ContextSwitches,
+    PageFaults,
+    kEventCount
+  };
+
+  int fds_[kEventCount];
+  QString error_;
+};
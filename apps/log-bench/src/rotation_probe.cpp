@@ -0,0 +1,79 @@
+#include "rotation_probe.h"
+#include "bench_clock.h"
+
+void RotationProbe::attach(QtUtils::LogManager &log_manager)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stalls_.clear();
+    windows_.clear();
+    samples_.clear();
+  }
+  log_manager.setRotationObserver(
+      [this](qint64 duration_ns)
+      {
+        observe(duration_ns);
+      });
+}
+
+void RotationProbe::detach(QtUtils::LogManager &log_manager)
+{
+  log_manager.setRotationObserver(nullptr);
+}
+
+void RotationProbe::setStartTicks(quint64 ticks)
+{
+  start_ticks_.store(ticks, std::memory_order_relaxed);
+}
+
+void RotationProbe::addSamples(int thread_id, std::vector<EnqueueSample> samples)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  samples_.emplace_back(thread_id, std::move(samples));
+}
+
+RotationStats RotationProbe::analyze() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  RotationStats stats;
+  stats.rotations = stalls_.count();
+  stats.worker_stall = stalls_;
+
+  // The worker rotates one file at a time, so windows are ordered and disjoint; each producer's samples are ordered
+  // too, and one pass over both classifies them.
+  for (const auto &thread_samples : samples_)
+  {
+    size_t window = 0;
+    for (const EnqueueSample &sample : thread_samples.second)
+    {
+      while (window < windows_.size() && windows_[window].end_ns + kMarginNs < sample.at_ns)
+      {
+        ++window;
+      }
+      const bool near = window < windows_.size() &&
+                        sample.at_ns + sample.latency_ns + kMarginNs >= windows_[window].begin_ns;
+      LatencyHistogram &target = near ? stats.producer_near : stats.producer_away;
+      target.record(sample.latency_ns, sample.at_ns, thread_samples.first);
+    }
+  }
+  return stats;
+}
+
+void RotationProbe::observe(qint64 duration_ns)
+{
+  const quint64 end_ticks = BenchClock::now();
+  const quint64 start_ticks = start_ticks_.load(std::memory_order_relaxed);
+  const quint64 duration = duration_ns > 0 ? static_cast<quint64>(duration_ns) : 0;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Rotations during warm-up still cost the worker but cannot overlap a measured call.
+  if (start_ticks == 0 || end_ticks < start_ticks)
+  {
+    stalls_.record(duration, 0, 0);
+    return;
+  }
+  const quint64 end_ns = BenchClock::toNanos(end_ticks - start_ticks);
+  const quint64 begin_ns = end_ns > duration ? end_ns - duration : 0;
+  stalls_.record(duration, begin_ns, 0);
+  windows_.push_back({begin_ns, end_ns});
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "bench_types.h"
+#include "qtutils/log_manager.h"
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Times every log file rotation on the worker and, given the producers' enqueue samples, splits their latency into
+// calls made around a rotation and all others, so a rotation that stalls producers as well as the worker shows up.
+class RotationProbe
+{
+public:
+  // An enqueue call within this distance of a rotation counts as around it.
+  static constexpr quint64 kMarginNs = 1000000;
+
+  void attach(QtUtils::LogManager &log_manager);
+  // Call after LogManager::shutdown() so the worker has rotated everything it is going to.
+  void detach(QtUtils::LogManager &log_manager);
+
+  void setStartTicks(quint64 ticks);
+
+  // One call per producer, with its samples in the order they were taken.
+  void addSamples(int thread_id, std::vector<EnqueueSample> samples);
+
+  // Only valid after detach().
+  RotationStats analyze() const;
+
+private:
+  struct Window
+  {
+    quint64 begin_ns;
+    quint64 end_ns;
+  };
+
+  void observe(qint64 duration_ns);
+
+  mutable std::mutex mutex_;
+  LatencyHistogram stalls_;
+  std::vector<Window> windows_;
+  std::vector<std::pair<int, std::vector<EnqueueSample>>> samples_;
+  std::atomic<quint64> start_ticks_{0};
+};
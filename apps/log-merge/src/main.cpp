@@ -0,0 +1,121 @@
+#include "qtutils/common_utils.h"
+#include "qtutils/log_merger.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <chrono>
+#include <cstdio>
+
+QStringList collectLogFiles(const QStringList &paths)
+{
+  QStringList files;
+  for (const QString &path : paths)
+  {
+    QFileInfo info(path);
+    if (info.isDir())
+    {
+      files.append(QtUtils::LogMerger::findLogFiles(path));
+    }
+    else if (info.isFile())
+    {
+      files.append(info.absoluteFilePath());
+    }
+    else
+    {
+      fprintf(stderr, "Skipping missing path: %s\n", qPrintable(path));
+    }
+  }
+  return files;
+}
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationVersion("1.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Merge LogManager files (plain, .gz or .zst) into one stream ordered by timestamp");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("paths", "Log files or directories (default: the log directory of --app)", "[paths...]");
+
+  QCommandLineOption appOption("app", "Application whose log directory is merged (default: app)", "name", "app");
+  QCommandLineOption outputOption(QStringList{"o", "output"}, "Write to this file instead of stdout", "file");
+  QCommandLineOption readAheadOption("read-ahead", "Read-ahead window per input in MB (default: 8)", "mb", "8");
+  QCommandLineOption bufferOption("buffer", "Output buffer in MB (default: 4)", "mb", "4");
+
+  parser.addOption(appOption);
+  parser.addOption(outputOption);
+  parser.addOption(readAheadOption);
+  parser.addOption(bufferOption);
+
+  parser.process(app);
+
+  QStringList paths = parser.positionalArguments();
+  if (paths.isEmpty())
+  {
+    QCoreApplication::setApplicationName(parser.value(appOption));
+    paths.append(QtUtils::CommonUtils::getAppLogDirPath());
+  }
+
+  const QStringList files = collectLogFiles(paths);
+  const QString output_path = parser.value(outputOption);
+  if (!output_path.isEmpty() && files.contains(QFileInfo(output_path).absoluteFilePath()))
+  {
+    fprintf(stderr, "Output file is also an input: %s\n", qPrintable(output_path));
+    return 1;
+  }
+
+  QtUtils::LogMerger merger;
+  merger.setReadAheadBytes(parser.value(readAheadOption).toLongLong() * 1024 * 1024);
+  merger.setOutputBufferBytes(parser.value(bufferOption).toLongLong() * 1024 * 1024);
+  for (const QString &file : files)
+  {
+    if (!merger.addInput(file))
+    {
+      fprintf(stderr, "%s\n", qPrintable(merger.errorString()));
+      return 1;
+    }
+  }
+
+  QFile output;
+  bool opened = false;
+  if (output_path.isEmpty())
+  {
+    opened = output.open(stdout, QIODevice::WriteOnly);
+  }
+  else
+  {
+    output.setFileName(output_path);
+    opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+  }
+  if (!opened)
+  {
+    fprintf(stderr, "Failed to open output: %s\n", qPrintable(output.errorString()));
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  const bool merged = merger.merge(output);
+  output.close();
+
+  if (!merged)
+  {
+    fprintf(stderr, "Merge failed: %s\n", qPrintable(merger.errorString()));
+    return 1;
+  }
+
+  auto elapsed_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  const double megabytes = static_cast<double>(merger.bytesWritten()) / 1024.0 / 1024.0;
+  fprintf(stderr,
+          "%lld entries from %lld files, %.2f MB in %lld ms (%.1f MB/s)\n",
+          static_cast<long long>(merger.entriesWritten()),
+          static_cast<long long>(files.size()),
+          megabytes,
+          static_cast<long long>(elapsed_ms),
+          elapsed_ms > 0 ? megabytes * 1000.0 / static_cast<double>(elapsed_ms) : 0.0);
+
+  return 0;
+}
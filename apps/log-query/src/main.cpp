@@ -0,0 +1,326 @@
+#include "qtutils/common_utils.h"
+#include "qtutils/log_index.h"
+#include "qtutils/log_line.h"
+#include <QByteArrayMatcher>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+struct QueryConfig
+{
+  qint64 from_ms{std::numeric_limits<qint64>::min()};
+  qint64 to_ms{std::numeric_limits<qint64>::max()};
+  qint64 from_key{0};
+  qint64 to_key{std::numeric_limits<qint64>::max()};
+  int min_level{0};
+  QByteArray needle;
+  bool with_filename{false};
+  bool use_index{true};
+};
+
+struct FileResult
+{
+  QByteArray output;
+  qint64 file_size{0};
+  qint64 scanned_bytes{0};
+  qint64 matched_entries{0};
+  bool indexed{false};
+};
+
+QDateTime parseTime(const QString &text)
+{
+  static const char *const formats[] = {
+      "yyyy-MM-dd hh:mm:ss.zzz",
+      "yyyy-MM-dd hh:mm:ss",
+      "yyyy-MM-ddThh:mm:ss.zzz",
+      "yyyy-MM-ddThh:mm:ss",
+      "yyyy-MM-dd hh:mm",
+  };
+  for (const char *format : formats)
+  {
+    QDateTime datetime = QDateTime::fromString(text, QString::fromLatin1(format));
+    if (datetime.isValid())
+    {
+      return datetime;
+    }
+  }
+
+  for (const char *format : {"hh:mm:ss.zzz", "hh:mm:ss", "hh:mm"})
+  {
+    QTime time = QTime::fromString(text, QString::fromLatin1(format));
+    if (time.isValid())
+    {
+      return QDateTime(QDate::currentDate(), time);
+    }
+  }
+  return {};
+}
+
+// An entry is a timestamped line plus any following continuation lines of a multi-line message.
+void scanRange(const char *data,
+               qint64 size,
+               const QueryConfig &config,
+               const QByteArrayMatcher &matcher,
+               const QByteArray &prefix,
+               FileResult &result)
+{
+  qint64 entry_begin = -1;
+  qint64 pos = 0;
+
+  auto finishEntry = [&](qint64 entry_end)
+  {
+    if (entry_begin < 0)
+    {
+      return;
+    }
+
+    const char *entry = data + entry_begin;
+    const qint64 length = entry_end - entry_begin;
+    const qint64 key = QtUtils::LogLine::timestampKey(entry, length);
+    const int level = QtUtils::LogLine::levelIndex(entry, length);
+    if (key >= config.from_key && key <= config.to_key && level >= config.min_level &&
+        (config.needle.isEmpty() || matcher.indexIn(entry, static_cast<int>(length)) >= 0))
+    {
+      result.output.append(prefix);
+      result.output.append(entry, static_cast<int>(length));
+      ++result.matched_entries;
+    }
+    entry_begin = -1;
+  };
+
+  while (pos < size)
+  {
+    const void *newline = std::memchr(data + pos, '\n', static_cast<size_t>(size - pos));
+    const qint64 line_end = newline != nullptr ? static_cast<const char *>(newline) - data + 1 : size;
+
+    if (QtUtils::LogLine::findTimestamp(data + pos, line_end - pos) != nullptr)
+    {
+      finishEntry(pos);
+      entry_begin = pos;
+    }
+    pos = line_end;
+  }
+  finishEntry(size);
+}
+
+FileResult queryFile(const QString &path, const QueryConfig &config)
+{
+  FileResult result;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    fprintf(stderr, "Cannot open %s\n", qPrintable(path));
+    return result;
+  }
+  result.file_size = file.size();
+  if (result.file_size == 0)
+  {
+    return result;
+  }
+
+  QVector<QtUtils::LogIndex::ByteRange> ranges;
+  QVector<QtUtils::LogIndex::Block> blocks;
+  if (config.use_index && QtUtils::LogIndex::read(QtUtils::LogIndex::indexPathFor(path), blocks))
+  {
+    result.indexed = true;
+    ranges = QtUtils::LogIndex::selectRanges(blocks, result.file_size, config.from_ms, config.to_ms, config.min_level);
+  }
+  else
+  {
+    ranges.append({0, result.file_size});
+  }
+
+  const QByteArray prefix = config.with_filename ? QFileInfo(path).fileName().toUtf8() + ": " : QByteArray();
+  const QByteArrayMatcher matcher(config.needle);
+
+  uchar *mapped = file.map(0, result.file_size);
+  for (const QtUtils::LogIndex::ByteRange &range : ranges)
+  {
+    result.scanned_bytes += range.end - range.begin;
+    if (mapped != nullptr)
+    {
+      scanRange(reinterpret_cast<const char *>(mapped) + range.begin,
+                range.end - range.begin,
+                config,
+                matcher,
+                prefix,
+                result);
+    }
+    else
+    {
+      file.seek(range.begin);
+      const QByteArray chunk = file.read(range.end - range.begin);
+      scanRange(chunk.constData(), chunk.size(), config, matcher, prefix, result);
+    }
+  }
+
+  if (mapped != nullptr)
+  {
+    file.unmap(mapped);
+  }
+  return result;
+}
+
+QStringList collectLogFiles(const QStringList &paths)
+{
+  QStringList files;
+  for (const QString &path : paths)
+  {
+    QFileInfo info(path);
+    if (info.isDir())
+    {
+      QDir dir(path);
+      for (const QFileInfo &entry : dir.entryInfoList(QStringList{"*.log"}, QDir::Files, QDir::Time | QDir::Reversed))
+      {
+        files.append(entry.absoluteFilePath());
+      }
+    }
+    else if (info.isFile())
+    {
+      files.append(info.absoluteFilePath());
+    }
+    else
+    {
+      fprintf(stderr, "Skipping missing path: %s\n", qPrintable(path));
+    }
+  }
+  return files;
+}
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationVersion("1.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Query LogManager files by time range, level and substring using sidecar indexes");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("paths", "Log files or directories (default: the log directory of --app)", "[paths...]");
+
+  QCommandLineOption appOption("app", "Application whose log directory is searched (default: app)", "name", "app");
+  QCommandLineOption fromOption("from", "Start time, e.g. \"2026-10-18 14:02:10\" or \"14:02:10\"", "time");
+  QCommandLineOption toOption("to", "End time (inclusive)", "time");
+  QCommandLineOption levelOption("level", "Minimum level: debug, info, warning, error, fatal", "level", "debug");
+  QCommandLineOption grepOption("grep", "Only entries containing this substring", "text");
+  QCommandLineOption threadsOption("threads", "Files scanned in parallel (default: all cores)", "count");
+  QCommandLineOption noIndexOption("no-index", "Ignore sidecar indexes and scan whole files");
+  QCommandLineOption filenameOption("with-filename", "Prefix each entry with its file name");
+
+  parser.addOption(appOption);
+  parser.addOption(fromOption);
+  parser.addOption(toOption);
+  parser.addOption(levelOption);
+  parser.addOption(grepOption);
+  parser.addOption(threadsOption);
+  parser.addOption(noIndexOption);
+  parser.addOption(filenameOption);
+
+  parser.process(app);
+
+  QueryConfig config;
+  if (parser.isSet(fromOption))
+  {
+    QDateTime from = parseTime(parser.value(fromOption));
+    if (!from.isValid())
+    {
+      fprintf(stderr, "Invalid --from time: %s\n", qPrintable(parser.value(fromOption)));
+      return 1;
+    }
+    config.from_ms = from.toMSecsSinceEpoch();
+    config.from_key = QtUtils::LogLine::timestampKey(from);
+  }
+  if (parser.isSet(toOption))
+  {
+    QDateTime to = parseTime(parser.value(toOption));
+    if (!to.isValid())
+    {
+      fprintf(stderr, "Invalid --to time: %s\n", qPrintable(parser.value(toOption)));
+      return 1;
+    }
+    config.to_ms = to.toMSecsSinceEpoch();
+    config.to_key = QtUtils::LogLine::timestampKey(to);
+  }
+
+  config.min_level = QtUtils::LogLine::levelIndex(parser.value(levelOption));
+  if (config.min_level < 0)
+  {
+    fprintf(stderr, "Invalid --level: %s\n", qPrintable(parser.value(levelOption)));
+    return 1;
+  }
+  config.needle = parser.value(grepOption).toUtf8();
+  config.with_filename = parser.isSet(filenameOption);
+  config.use_index = !parser.isSet(noIndexOption);
+
+  QStringList paths = parser.positionalArguments();
+  if (paths.isEmpty())
+  {
+    QCoreApplication::setApplicationName(parser.value(appOption));
+    paths.append(QtUtils::CommonUtils::getAppLogDirPath());
+  }
+
+  const QStringList files = collectLogFiles(paths);
+  int thread_count = parser.isSet(threadsOption) ? parser.value(threadsOption).toInt() : QThread::idealThreadCount();
+  thread_count = std::max(1, std::min(thread_count, static_cast<int>(files.size())));
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<FileResult> results(static_cast<size_t>(files.size()));
+  std::atomic<int> next_file{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < thread_count; ++t)
+  {
+    workers.emplace_back(
+        [&]()
+        {
+          for (int i = next_file.fetch_add(1); i < files.size(); i = next_file.fetch_add(1))
+          {
+            results[static_cast<size_t>(i)] = queryFile(files[i], config);
+          }
+        });
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  qint64 total_bytes = 0;
+  qint64 scanned_bytes = 0;
+  qint64 matched = 0;
+  int indexed_files = 0;
+  for (const FileResult &result : results)
+  {
+    fwrite(result.output.constData(), 1, static_cast<size_t>(result.output.size()), stdout);
+    total_bytes += result.file_size;
+    scanned_bytes += result.scanned_bytes;
+    matched += result.matched_entries;
+    indexed_files += result.indexed ? 1 : 0;
+  }
+  fflush(stdout);
+
+  auto elapsed_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr,
+          "%lld entries from %lld files (%d indexed), scanned %.2f of %.2f MB in %lld ms\n",
+          static_cast<long long>(matched),
+          static_cast<long long>(files.size()),
+          indexed_files,
+          static_cast<double>(scanned_bytes) / 1024.0 / 1024.0,
+          static_cast<double>(total_bytes) / 1024.0 / 1024.0,
+          static_cast<long long>(elapsed_ms));
+
+  return 0;
+}
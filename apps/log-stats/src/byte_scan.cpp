@@ -0,0 +1,132 @@
+#include "byte_scan.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTE_SCAN_SSE2
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define BYTE_SCAN_AVX2
+#endif
+#endif
+
+namespace ByteScan
+{
+
+namespace
+{
+
+using ScanFunction = void (*)(const char *, qsizetype, std::vector<quint32> &);
+
+void scanTail(const char *data, qsizetype from, qsizetype size, std::vector<quint32> &positions)
+{
+  const char *end = data + size;
+  const char *p = data + from;
+  while (p < end)
+  {
+    const void *found = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    if (found == nullptr)
+    {
+      break;
+    }
+    p = static_cast<const char *>(found);
+    positions.push_back(static_cast<quint32>(p - data));
+    ++p;
+  }
+}
+
+#ifndef BYTE_SCAN_SSE2
+void findNewlinesScalar(const char *data, qsizetype size, std::vector<quint32> &positions)
+{
+  scanTail(data, 0, size, positions);
+}
+#endif
+
+template <typename Mask>
+inline void appendMask(Mask mask, qsizetype base, std::vector<quint32> &positions)
+{
+  while (mask != 0)
+  {
+    positions.push_back(static_cast<quint32>(base + qCountTrailingZeroBits(mask)));
+    mask &= mask - 1;
+  }
+}
+
+#ifdef BYTE_SCAN_SSE2
+void findNewlinesSse2(const char *data, qsizetype size, std::vector<quint32> &positions)
+{
+  const __m128i newline = _mm_set1_epi8('\n');
+  qsizetype i = 0;
+  for (; i + 32 <= size; i += 32)
+  {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16));
+    const quint32 mask = static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, newline))) |
+                         (static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, newline))) << 16);
+    appendMask(mask, i, positions);
+  }
+  scanTail(data, i, size, positions);
+}
+#endif
+
+#ifdef BYTE_SCAN_AVX2
+__attribute__((target("avx2"))) void findNewlinesAvx2(const char *data, qsizetype size,
+                                                       std::vector<quint32> &positions)
+{
+  const __m256i newline = _mm256_set1_epi8('\n');
+  qsizetype i = 0;
+  for (; i + 64 <= size; i += 64)
+  {
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 32));
+    const quint64 mask = static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline))) |
+                         (static_cast<quint64>(static_cast<quint32>(
+                              _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline))))
+                          << 32);
+    appendMask(mask, i, positions);
+  }
+  scanTail(data, i, size, positions);
+}
+#endif
+
+struct Implementation
+{
+  ScanFunction scan;
+  const char *name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef BYTE_SCAN_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return {findNewlinesAvx2, "avx2"};
+  }
+#endif
+#ifdef BYTE_SCAN_SSE2
+  return {findNewlinesSse2, "sse2"};
+#else
+  return {findNewlinesScalar, "scalar"};
+#endif
+}
+
+const Implementation &implementation()
+{
+  static const Implementation selected = selectImplementation();
+  return selected;
+}
+
+} // namespace
+
+void findNewlines(const char *data, qsizetype size, std::vector<quint32> &positions)
+{
+  implementation().scan(data, size, positions);
+}
+
+const char *implementationName()
+{
+  return implementation().name;
+}
+
+} // namespace ByteScan
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+
+namespace ByteScan
+{
+
+// Appends the offset of every '\n' in [data, data + size) to positions. size must be below 4 GB; callers scan
+// large files in slices. The implementation is picked once for the running CPU.
+void findNewlines(const char *data, qsizetype size, std::vector<quint32> &positions);
+
+// "avx2", "sse2" or "scalar".
+const char *implementationName();
+
+} // namespace ByteScan
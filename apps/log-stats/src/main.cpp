@@ -0,0 +1,541 @@
+#include "byte_scan.h"
+#include "qtutils/common_utils.h"
+#include "qtutils/log_line.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+constexpr int kLevelCount = 5;
+constexpr qint64 kSliceBytes = 1024 * 1024;
+
+using LevelCounts = std::array<quint64, kLevelCount>;
+
+const char *const kLevelNames[kLevelCount] = {"DEBUG", "INFO", "WARNING", "ERROR", "FATAL"};
+
+struct SiteStats
+{
+  LevelCounts levels{};
+  quint64 total{0};
+};
+
+struct ChunkResult
+{
+  quint64 entries{0};
+  quint64 continuation_lines{0};
+  LevelCounts levels{};
+  QHash<QByteArray, SiteStats> sites;
+  // Keyed by second, yyyyMMddhhmmss.
+  QHash<qint64, LevelCounts> seconds;
+};
+
+struct MappedFile
+{
+  std::unique_ptr<QFile> file;
+  const char *data{nullptr};
+  qint64 size{0};
+};
+
+struct Chunk
+{
+  const char *data;
+  qint64 size;
+};
+
+// Per-chunk accumulator. Consecutive lines usually share a second and often a call site, so both are cached
+// to skip most hash lookups.
+class LineAnalyzer
+{
+public:
+  explicit LineAnalyzer(ChunkResult &result)
+      : result_(result)
+  {
+  }
+
+  void analyze(const char *line, qint64 length)
+  {
+    const qint64 key = QtUtils::LogLine::timestampKey(line, length);
+    if (key < 0)
+    {
+      ++result_.continuation_lines;
+      return;
+    }
+
+    ++result_.entries;
+    const int level = QtUtils::LogLine::levelIndex(line, length);
+    if (level >= 0)
+    {
+      ++result_.levels[level];
+    }
+    countSecond(key / 1000, level);
+    countSite(line, length, level);
+  }
+
+  void finish()
+  {
+    flushSecond();
+  }
+
+private:
+  void countSecond(qint64 second, int level)
+  {
+    if (second != current_second_)
+    {
+      flushSecond();
+      current_second_ = second;
+    }
+    ++current_second_total_;
+    if (level >= 0)
+    {
+      ++current_second_levels_[level];
+    }
+  }
+
+  void flushSecond()
+  {
+    if (current_second_total_ == 0)
+    {
+      return;
+    }
+
+    LevelCounts &counts = result_.seconds[current_second_];
+    for (int i = 0; i < kLevelCount; ++i)
+    {
+      counts[i] += current_second_levels_[i];
+    }
+    current_second_levels_ = {};
+    current_second_total_ = 0;
+  }
+
+  void countSite(const char *line, qint64 length, int level)
+  {
+    std::string_view site = findSite(line, length);
+    if (site.empty())
+    {
+      return;
+    }
+
+    if (current_site_ == nullptr || site != std::string_view(current_site_key_.constData(), current_site_key_.size()))
+    {
+      const QByteArray raw = QByteArray::fromRawData(site.data(), static_cast<int>(site.size()));
+      auto it = result_.sites.find(raw);
+      if (it == result_.sites.end())
+      {
+        it = result_.sites.insert(QByteArray(site.data(), static_cast<int>(site.size())), SiteStats{});
+      }
+      current_site_key_ = it.key();
+      current_site_ = &it.value();
+    }
+
+    ++current_site_->total;
+    if (level >= 0)
+    {
+      ++current_site_->levels[level];
+    }
+  }
+
+  // "file:line" for text lines ("[ts] [LEVEL] [file:line] ..."); for JSON lines it is rebuilt from the "file"
+  // and "line" members into a reusable buffer.
+  std::string_view findSite(const char *line, qint64 length)
+  {
+    const std::string_view view(line, static_cast<size_t>(length));
+    if (line[0] == '[')
+    {
+      const size_t level_end = view.find(']', QtUtils::LogLine::kTimestampLength + 4);
+      if (level_end == std::string_view::npos || level_end + 3 >= view.size() || view[level_end + 2] != '[')
+      {
+        return {};
+      }
+      const size_t site_begin = level_end + 3;
+      const size_t site_end = view.find(']', site_begin);
+      return site_end == std::string_view::npos ? std::string_view() : view.substr(site_begin, site_end - site_begin);
+    }
+
+    const size_t file_key = view.find("\"file\":\"");
+    const size_t line_key = view.find("\"line\":");
+    if (file_key == std::string_view::npos || line_key == std::string_view::npos)
+    {
+      return {};
+    }
+    const size_t file_begin = file_key + 8;
+    const size_t file_end = view.find('"', file_begin);
+    size_t digits_end = line_key + 7;
+    while (digits_end < view.size() && view[digits_end] >= '0' && view[digits_end] <= '9')
+    {
+      ++digits_end;
+    }
+    if (file_end == std::string_view::npos)
+    {
+      return {};
+    }
+
+    json_site_.resize(0);
+    json_site_.append(line + file_begin, static_cast<int>(file_end - file_begin));
+    json_site_.append(':');
+    json_site_.append(line + line_key + 7, static_cast<int>(digits_end - line_key - 7));
+    return std::string_view(json_site_.constData(), static_cast<size_t>(json_site_.size()));
+  }
+
+  ChunkResult &result_;
+  qint64 current_second_{-1};
+  quint64 current_second_total_{0};
+  LevelCounts current_second_levels_{};
+  QByteArray current_site_key_;
+  SiteStats *current_site_{nullptr};
+  QByteArray json_site_;
+};
+
+void analyzeChunk(const Chunk &chunk, ChunkResult &result)
+{
+  LineAnalyzer analyzer(result);
+  std::vector<quint32> newlines;
+  newlines.reserve(kSliceBytes / 64);
+
+  const char *data = chunk.data;
+  const qint64 size = chunk.size;
+  qint64 pos = 0;
+  while (pos < size)
+  {
+    const qint64 slice_end = std::min(size, pos + kSliceBytes);
+    newlines.clear();
+    ByteScan::findNewlines(data + pos, slice_end - pos, newlines);
+
+    qint64 line_begin = pos;
+    for (quint32 offset : newlines)
+    {
+      const qint64 line_end = pos + offset;
+      if (line_end > line_begin)
+      {
+        analyzer.analyze(data + line_begin, line_end - line_begin);
+      }
+      line_begin = line_end + 1;
+    }
+
+    if (slice_end == size)
+    {
+      if (line_begin < size)
+      {
+        analyzer.analyze(data + line_begin, size - line_begin);
+      }
+      break;
+    }
+
+    if (line_begin == pos)
+    {
+      // One line longer than the slice.
+      const void *newline = std::memchr(data + slice_end, '\n', static_cast<size_t>(size - slice_end));
+      const qint64 line_end = newline != nullptr ? static_cast<const char *>(newline) - data : size;
+      analyzer.analyze(data + pos, line_end - pos);
+      line_begin = line_end + 1;
+    }
+    pos = line_begin;
+  }
+
+  analyzer.finish();
+}
+
+// Splits a mapped file into chunks of roughly chunk_bytes that start and end on line boundaries.
+void splitFile(const MappedFile &file, qint64 chunk_bytes, std::vector<Chunk> &chunks)
+{
+  qint64 begin = 0;
+  while (begin < file.size)
+  {
+    qint64 end = std::min(file.size, begin + chunk_bytes);
+    if (end < file.size)
+    {
+      const void *newline = std::memchr(file.data + end, '\n', static_cast<size_t>(file.size - end));
+      end = newline != nullptr ? static_cast<const char *>(newline) - file.data + 1 : file.size;
+    }
+    chunks.push_back({file.data + begin, end - begin});
+    begin = end;
+  }
+}
+
+void mergeResult(ChunkResult &total, const ChunkResult &part)
+{
+  total.entries += part.entries;
+  total.continuation_lines += part.continuation_lines;
+  for (int i = 0; i < kLevelCount; ++i)
+  {
+    total.levels[i] += part.levels[i];
+  }
+
+  for (auto it = part.sites.constBegin(); it != part.sites.constEnd(); ++it)
+  {
+    SiteStats &site = total.sites[it.key()];
+    site.total += it.value().total;
+    for (int i = 0; i < kLevelCount; ++i)
+    {
+      site.levels[i] += it.value().levels[i];
+    }
+  }
+
+  for (auto it = part.seconds.constBegin(); it != part.seconds.constEnd(); ++it)
+  {
+    LevelCounts &counts = total.seconds[it.key()];
+    for (int i = 0; i < kLevelCount; ++i)
+    {
+      counts[i] += it.value()[i];
+    }
+  }
+}
+
+qint64 secondKeyToEpoch(qint64 key)
+{
+  const QDate date(static_cast<int>(key / 10000000000LL),
+                   static_cast<int>(key / 100000000LL % 100),
+                   static_cast<int>(key / 1000000LL % 100));
+  const QTime time(static_cast<int>(key / 10000 % 100), static_cast<int>(key / 100 % 100), static_cast<int>(key % 100));
+  return QDateTime(date, time).toSecsSinceEpoch();
+}
+
+QStringList collectLogFiles(const QStringList &paths)
+{
+  QStringList files;
+  for (const QString &path : paths)
+  {
+    QFileInfo info(path);
+    if (info.isDir())
+    {
+      QDir dir(path);
+      for (const QFileInfo &entry : dir.entryInfoList(QStringList{"*.log"}, QDir::Files, QDir::Name))
+      {
+        files.append(entry.absoluteFilePath());
+      }
+    }
+    else if (info.isFile())
+    {
+      files.append(info.absoluteFilePath());
+    }
+    else
+    {
+      fprintf(stderr, "Skipping missing path: %s\n", qPrintable(path));
+    }
+  }
+  return files;
+}
+
+void printReport(const ChunkResult &total, int top_count, qint64 bucket_seconds)
+{
+  printf("Entries: %llu (+%llu continuation lines)\n",
+         static_cast<unsigned long long>(total.entries),
+         static_cast<unsigned long long>(total.continuation_lines));
+
+  printf("\nLevels:\n");
+  for (int i = 0; i < kLevelCount; ++i)
+  {
+    const double percent =
+        total.entries > 0 ? 100.0 * static_cast<double>(total.levels[i]) / static_cast<double>(total.entries) : 0.0;
+    printf("  %-8s %12llu  %6.2f%%\n", kLevelNames[i], static_cast<unsigned long long>(total.levels[i]), percent);
+  }
+
+  std::vector<std::pair<QByteArray, SiteStats>> sites;
+  sites.reserve(static_cast<size_t>(total.sites.size()));
+  for (auto it = total.sites.constBegin(); it != total.sites.constEnd(); ++it)
+  {
+    sites.emplace_back(it.key(), it.value());
+  }
+  const size_t shown = std::min(sites.size(), static_cast<size_t>(std::max(0, top_count)));
+  std::partial_sort(sites.begin(),
+                    sites.begin() + static_cast<std::ptrdiff_t>(shown),
+                    sites.end(),
+                    [](const auto &a, const auto &b)
+                    {
+                      return a.second.total > b.second.total;
+                    });
+
+  printf("\nTop %zu of %zu call sites:\n", shown, sites.size());
+  printf("  %12s %10s %10s %10s %10s %10s  %s\n", "total", "debug", "info", "warning", "error", "fatal", "site");
+  for (size_t i = 0; i < shown; ++i)
+  {
+    const SiteStats &site = sites[i].second;
+    printf("  %12llu %10llu %10llu %10llu %10llu %10llu  %s\n",
+           static_cast<unsigned long long>(site.total),
+           static_cast<unsigned long long>(site.levels[0]),
+           static_cast<unsigned long long>(site.levels[1]),
+           static_cast<unsigned long long>(site.levels[2]),
+           static_cast<unsigned long long>(site.levels[3]),
+           static_cast<unsigned long long>(site.levels[4]),
+           sites[i].first.constData());
+  }
+
+  std::map<qint64, LevelCounts> buckets;
+  for (auto it = total.seconds.constBegin(); it != total.seconds.constEnd(); ++it)
+  {
+    const qint64 epoch = secondKeyToEpoch(it.key());
+    LevelCounts &counts = buckets[epoch - epoch % bucket_seconds];
+    for (int i = 0; i < kLevelCount; ++i)
+    {
+      counts[i] += it.value()[i];
+    }
+  }
+
+  printf("\nTimeline (%lld s buckets):\n", static_cast<long long>(bucket_seconds));
+  printf("  %-19s %12s %10s %10s %10s %10s %10s %10s\n",
+         "start",
+         "total",
+         "msg/s",
+         "debug",
+         "info",
+         "warning",
+         "error",
+         "fatal");
+  for (const auto &[start, counts] : buckets)
+  {
+    quint64 bucket_total = 0;
+    for (quint64 count : counts)
+    {
+      bucket_total += count;
+    }
+    printf("  %-19s %12llu %10.1f %10llu %10llu %10llu %10llu %10llu\n",
+           qPrintable(QDateTime::fromSecsSinceEpoch(start).toString("yyyy-MM-dd hh:mm:ss")),
+           static_cast<unsigned long long>(bucket_total),
+           static_cast<double>(bucket_total) / static_cast<double>(bucket_seconds),
+           static_cast<unsigned long long>(counts[0]),
+           static_cast<unsigned long long>(counts[1]),
+           static_cast<unsigned long long>(counts[2]),
+           static_cast<unsigned long long>(counts[3]),
+           static_cast<unsigned long long>(counts[4]));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationVersion("1.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Summarize LogManager files: level counts, call-site hotspots and message rates");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("paths", "Log files or directories (default: the log directory of --app)", "[paths...]");
+
+  QCommandLineOption appOption("app", "Application whose log directory is analyzed (default: app)", "name", "app");
+  QCommandLineOption threadsOption("threads", "Worker threads (default: all cores)", "count");
+  QCommandLineOption topOption("top", "Number of call sites listed (default: 20)", "count", "20");
+  QCommandLineOption bucketOption("bucket", "Timeline bucket width in seconds (default: 60)", "seconds", "60");
+  QCommandLineOption chunkOption("chunk", "Work unit size in MB; large files are split (default: 64)", "mb", "64");
+
+  parser.addOption(appOption);
+  parser.addOption(threadsOption);
+  parser.addOption(topOption);
+  parser.addOption(bucketOption);
+  parser.addOption(chunkOption);
+
+  parser.process(app);
+
+  QStringList paths = parser.positionalArguments();
+  if (paths.isEmpty())
+  {
+    QCoreApplication::setApplicationName(parser.value(appOption));
+    paths.append(QtUtils::CommonUtils::getAppLogDirPath());
+  }
+
+  const qint64 bucket_seconds = std::max<qint64>(1, parser.value(bucketOption).toLongLong());
+  const qint64 chunk_bytes = std::max<qint64>(1, parser.value(chunkOption).toLongLong()) * 1024 * 1024;
+
+  auto start = std::chrono::steady_clock::now();
+
+  const QStringList file_paths = collectLogFiles(paths);
+  std::vector<MappedFile> files;
+  std::vector<Chunk> chunks;
+  qint64 total_bytes = 0;
+  for (const QString &path : file_paths)
+  {
+    MappedFile mapped;
+    mapped.file = std::make_unique<QFile>(path);
+    if (!mapped.file->open(QIODevice::ReadOnly))
+    {
+      fprintf(stderr, "Cannot open %s\n", qPrintable(path));
+      continue;
+    }
+    mapped.size = mapped.file->size();
+    if (mapped.size == 0)
+    {
+      continue;
+    }
+    mapped.data = reinterpret_cast<const char *>(mapped.file->map(0, mapped.size));
+    if (mapped.data == nullptr)
+    {
+      fprintf(stderr, "Cannot map %s\n", qPrintable(path));
+      continue;
+    }
+
+    total_bytes += mapped.size;
+    splitFile(mapped, chunk_bytes, chunks);
+    files.push_back(std::move(mapped));
+  }
+
+  int thread_count = parser.isSet(threadsOption) ? parser.value(threadsOption).toInt() : QThread::idealThreadCount();
+  thread_count = std::max(1, std::min(thread_count, static_cast<int>(chunks.size())));
+
+  // Each worker accumulates into its own result; chunks are handed out largest first for better balance.
+  std::sort(chunks.begin(),
+            chunks.end(),
+            [](const Chunk &a, const Chunk &b)
+            {
+              return a.size > b.size;
+            });
+  std::vector<ChunkResult> partials(static_cast<size_t>(thread_count));
+  std::atomic<size_t> next_chunk{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < thread_count; ++t)
+  {
+    workers.emplace_back(
+        [&, t]()
+        {
+          for (size_t i = next_chunk.fetch_add(1); i < chunks.size(); i = next_chunk.fetch_add(1))
+          {
+            analyzeChunk(chunks[i], partials[static_cast<size_t>(t)]);
+          }
+        });
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  ChunkResult total;
+  for (const ChunkResult &partial : partials)
+  {
+    mergeResult(total, partial);
+  }
+
+  auto elapsed_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+  for (MappedFile &file : files)
+  {
+    file.file->unmap(reinterpret_cast<uchar *>(const_cast<char *>(file.data)));
+  }
+
+  printReport(total, parser.value(topOption).toInt(), bucket_seconds);
+
+  const double megabytes = static_cast<double>(total_bytes) / 1024.0 / 1024.0;
+  fprintf(stderr,
+          "Scanned %.2f MB in %zu files (%zu chunks, %d threads, %s) in %lld ms: %.2f GB/s\n",
+          megabytes,
+          files.size(),
+          chunks.size(),
+          thread_count,
+          ByteScan::implementationName(),
+          static_cast<long long>(elapsed_ms),
+          elapsed_ms > 0 ? megabytes / 1024.0 * 1000.0 / static_cast<double>(elapsed_ms) : 0.0);
+
+  return 0;
+}
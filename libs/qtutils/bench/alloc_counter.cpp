@@ -0,0 +1,227 @@
+#include "alloc_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#if defined(__GLIBC__)
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+constexpr int kSlotCount = 1024;
+
+struct alignas(64) Slot
+{
+  std::atomic<qint64> tid{0};
+  std::atomic<quint64> allocations{0};
+  std::atomic<quint64> frees{0};
+};
+
+// Constant-initialized, so malloc can use it before any constructor has run.
+Slot g_slots[kSlotCount];
+std::atomic<int> g_next_slot{0};
+thread_local int t_slot = -1;
+
+// Threads that find no slot, and exiting threads after theirs is released, share the last slot, which then needs
+// atomic increments.
+constexpr int kSharedSlot = kSlotCount - 1;
+
+#if defined(__GLIBC__)
+
+// Slots of exited threads, reused oldest first so a finished thread's counts stay readable for as long as possible.
+std::atomic_flag g_free_lock = ATOMIC_FLAG_INIT;
+int g_free_slots[kSlotCount];
+int g_free_head = 0;
+int g_free_count = 0;
+
+pthread_key_t g_release_key;
+pthread_once_t g_release_once = PTHREAD_ONCE_INIT;
+
+void lockFreeSlots()
+{
+  while (g_free_lock.test_and_set(std::memory_order_acquire))
+  {
+  }
+}
+
+void unlockFreeSlots()
+{
+  g_free_lock.clear(std::memory_order_release);
+}
+
+// Runs at thread exit. The slot keeps its tid and counts until it is handed to a new thread.
+void releaseSlot(void *)
+{
+  const int slot = t_slot;
+  t_slot = kSharedSlot;
+  if (slot < 0 || slot == kSharedSlot)
+  {
+    return;
+  }
+  lockFreeSlots();
+  g_free_slots[(g_free_head + g_free_count) % kSlotCount] = slot;
+  ++g_free_count;
+  unlockFreeSlots();
+}
+
+void createReleaseKey()
+{
+  pthread_key_create(&g_release_key, releaseSlot);
+}
+
+int acquireSlot()
+{
+  int next = g_next_slot.load(std::memory_order_relaxed);
+  while (next < kSharedSlot && !g_next_slot.compare_exchange_weak(next, next + 1, std::memory_order_relaxed))
+  {
+  }
+  if (next < kSharedSlot)
+  {
+    return next;
+  }
+
+  int slot = kSharedSlot;
+  lockFreeSlots();
+  if (g_free_count > 0)
+  {
+    slot = g_free_slots[g_free_head];
+    g_free_head = (g_free_head + 1) % kSlotCount;
+    --g_free_count;
+  }
+  unlockFreeSlots();
+  return slot;
+}
+
+Slot &threadSlot()
+{
+  if (t_slot < 0)
+  {
+    // Set before anything below can allocate, so a nested malloc finds it.
+    t_slot = acquireSlot();
+    Slot &slot = g_slots[t_slot];
+    if (t_slot == kSharedSlot)
+    {
+      slot.tid.store(-1, std::memory_order_relaxed);
+      return slot;
+    }
+    // The kernel reuses thread ids; forget an exited thread's slot so forThread() finds this one.
+    const qint64 tid = static_cast<qint64>(syscall(SYS_gettid));
+    const int used = std::min(g_next_slot.load(std::memory_order_relaxed), kSharedSlot);
+    for (int i = 0; i < used; ++i)
+    {
+      qint64 expected = tid;
+      g_slots[i].tid.compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+    }
+    slot.allocations.store(0, std::memory_order_relaxed);
+    slot.frees.store(0, std::memory_order_relaxed);
+    slot.tid.store(tid, std::memory_order_relaxed);
+    pthread_once(&g_release_once, createReleaseKey);
+    pthread_setspecific(g_release_key, &g_slots[t_slot]);
+  }
+  return g_slots[t_slot];
+}
+
+void bump(std::atomic<quint64> &counter)
+{
+  if (t_slot == kSharedSlot)
+  {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}
+
+#endif
+
+AllocCounts countsOf(const Slot &slot)
+{
+  return {slot.allocations.load(std::memory_order_relaxed), slot.frees.load(std::memory_order_relaxed)};
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+  void __libc_free(void *ptr);
+
+  void *malloc(size_t size)
+  {
+    bump(threadSlot().allocations);
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t count, size_t size)
+  {
+    bump(threadSlot().allocations);
+    return __libc_calloc(count, size);
+  }
+
+  void *realloc(void *ptr, size_t size)
+  {
+    Slot &slot = threadSlot();
+    bump(slot.allocations);
+    if (ptr != nullptr)
+    {
+      bump(slot.frees);
+    }
+    return __libc_realloc(ptr, size);
+  }
+
+  void free(void *ptr)
+  {
+    if (ptr != nullptr)
+    {
+      bump(threadSlot().frees);
+    }
+    __libc_free(ptr);
+  }
+}
+
+bool AllocCounter::isAvailable()
+{
+  return true;
+}
+
+AllocCounts AllocCounter::current()
+{
+  AllocCounts counts = countsOf(threadSlot());
+  counts.exact = t_slot != kSharedSlot;
+  return counts;
+}
+
+#else
+
+bool AllocCounter::isAvailable()
+{
+  return false;
+}
+
+AllocCounts AllocCounter::current()
+{
+  return {};
+}
+
+#endif
+
+AllocCounts AllocCounter::forThread(qint64 tid)
+{
+  const int used = std::min(g_next_slot.load(std::memory_order_relaxed), kSharedSlot);
+  for (int i = used - 1; i >= 0; --i)
+  {
+    if (g_slots[i].tid.load(std::memory_order_relaxed) == tid)
+    {
+      return countsOf(g_slots[i]);
+    }
+  }
+  return {0, 0, false};
+}
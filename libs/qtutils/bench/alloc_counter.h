@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QtGlobal>
+
+struct AllocCounts
+{
+  quint64 allocations{0};
+  quint64 frees{0};
+  // False when the counts are not the thread's own: it shares the overflow slot or was not found.
+  bool exact{true};
+
+  AllocCounts operator-(const AllocCounts &other) const
+  {
+    return {allocations - other.allocations, frees - other.frees, exact && other.exact};
+  }
+};
+
+// Counts malloc/calloc/realloc and free calls per thread by interposing them in this executable, which covers
+// operator new and Qt containers alike. Every thread owns a cache-line sized slot keyed by its kernel thread id,
+// so counting adds no contention and other threads' counts can be read. Slots are recycled when their thread
+// exits; only with more live threads than slots do the rest share one. Only available on glibc.
+// Built as an object library that qtutils-bench and log-bench link directly: the interposed functions must be
+// part of the executable, never of the shared qtutils library.
+class AllocCounter
+{
+public:
+  AllocCounter() = delete;
+
+  static bool isAvailable();
+  static AllocCounts current();
+  // Counts of the most recent thread with this kernel id. They stay readable after the thread exits until its
+  // slot is reused.
+  static AllocCounts forThread(qint64 tid);
+};
@@ -0,0 +1,132 @@
+#include "bench_harness.h"
+#include "alloc_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct ThreadSample
+{
+  qint64 elapsed_ns{0};
+  quint64 allocations{0};
+};
+
+ThreadSample measure(const BenchHarness::Body &body, quint64 iterations)
+{
+  const quint64 allocs_before = AllocCounter::current().allocations;
+  const Clock::time_point begin = Clock::now();
+  body(iterations);
+  const Clock::time_point end = Clock::now();
+  const quint64 allocs_after = AllocCounter::current().allocations;
+
+  ThreadSample sample;
+  sample.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  sample.allocations = allocs_after - allocs_before;
+  return sample;
+}
+
+} // namespace
+
+BenchHarness::BenchHarness(std::chrono::milliseconds min_time)
+    : min_time_(std::max(min_time, std::chrono::milliseconds(1)))
+{
+}
+
+quint64 BenchHarness::calibrate(const Body &body) const
+{
+  const qint64 target_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(min_time_).count();
+  quint64 iterations = 1;
+  while (true)
+  {
+    const ThreadSample sample = measure(body, iterations);
+    if (sample.elapsed_ns >= target_ns / 10 || iterations >= (quint64(1) << 40))
+    {
+      const double ns_per_op = std::max(1.0, static_cast<double>(sample.elapsed_ns) / iterations);
+      return std::max<quint64>(1, static_cast<quint64>(target_ns / ns_per_op));
+    }
+    iterations *= 2;
+  }
+}
+
+BenchStats BenchHarness::run(const QString &name, int threads, const Body &body)
+{
+  threads = std::max(1, threads);
+  const quint64 iterations = calibrate(body);
+
+  std::vector<ThreadSample> samples(threads);
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (int i = 0; i < threads; ++i)
+  {
+    workers.emplace_back(
+        [&, i]()
+        {
+          ready.fetch_add(1);
+          while (!go.load(std::memory_order_acquire))
+          {
+            std::this_thread::yield();
+          }
+          samples[i] = measure(body, iterations);
+        });
+  }
+  while (ready.load() < threads)
+  {
+    std::this_thread::yield();
+  }
+  const Clock::time_point start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+  const qint64 wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+  BenchStats stats;
+  stats.name = name;
+  stats.threads = threads;
+  stats.ops = iterations * static_cast<quint64>(threads);
+
+  double ns_sum = 0;
+  quint64 allocations = 0;
+  for (const ThreadSample &sample : samples)
+  {
+    ns_sum += static_cast<double>(sample.elapsed_ns) / static_cast<double>(iterations);
+    allocations += sample.allocations;
+  }
+  stats.ns_per_op = ns_sum / threads;
+  stats.allocs_per_op = AllocCounter::isAvailable() ? static_cast<double>(allocations) / stats.ops : -1.0;
+  stats.mops_per_sec = wall_ns > 0 ? static_cast<double>(stats.ops) * 1000.0 / static_cast<double>(wall_ns) : 0;
+  return stats;
+}
+
+void BenchHarness::printHeader()
+{
+  printf("%-36s %7s %12s %11s %10s\n", "benchmark", "threads", "ns/op", "allocs/op", "Mops/s");
+}
+
+void BenchHarness::print(const BenchStats &stats)
+{
+  char allocs[32];
+  if (stats.allocs_per_op < 0)
+  {
+    snprintf(allocs, sizeof(allocs), "n/a");
+  }
+  else
+  {
+    snprintf(allocs, sizeof(allocs), "%.2f", stats.allocs_per_op);
+  }
+  printf("%-36s %7d %12.1f %11s %10.2f\n",
+         qPrintable(stats.name),
+         stats.threads,
+         stats.ns_per_op,
+         allocs,
+         stats.mops_per_sec);
+  fflush(stdout);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T>
+inline void keepAlive(const T &value)
+{
+  asm volatile("" : : "r"(&value) : "memory");
+}
+#else
+template <typename T>
+inline void keepAlive(const T &value)
+{
+  static volatile const void *sink;
+  sink = &value;
+}
+#endif
+
+struct BenchStats
+{
+  QString name;
+  int threads{1};
+  quint64 ops{0};
+  // Mean time per call as seen by one thread; under contention this includes waiting.
+  double ns_per_op{0};
+  double allocs_per_op{0};
+  double mops_per_sec{0};
+};
+
+// Runs a body that performs `iterations` calls of the measured operation. The iteration count is calibrated on
+// one thread so that each run lasts about min_time; every thread then performs that many calls after a common
+// start signal.
+class BenchHarness
+{
+public:
+  using Body = std::function<void(quint64 iterations)>;
+
+  explicit BenchHarness(std::chrono::milliseconds min_time);
+
+  BenchStats run(const QString &name, int threads, const Body &body);
+
+  static void printHeader();
+  static void print(const BenchStats &stats);
+
+private:
+  quint64 calibrate(const Body &body) const;
+
+  std::chrono::milliseconds min_time_;
+};
@@ -0,0 +1,321 @@
+#include "alloc_counter.h"
+#include "bench_harness.h"
+#include "qtutils/common_utils.h"
+#include "qtutils/config_cache.h"
+#include "qtutils/config_key.h"
+#include "qtutils/config_manager.h"
+#include "qtutils/log_manager.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+
+namespace QtUtils
+{
+
+// Reaches the private formatting and handler entry points so they can be timed without the queue or the worker.
+class LogManagerBench
+{
+public:
+  LogManagerBench() = delete;
+
+  static const char *levelToString(QtMsgType type)
+  {
+    return LogManager::levelToString(type);
+  }
+
+  static const char *extractFileName(const char *path)
+  {
+    return LogManager::extractFileName(path);
+  }
+
+  // Appends to a reused batch that is reset at the worker's default flush size, as the worker does.
+  static void formatLogEntries(quint64 iterations)
+  {
+    const LogManager::LogEntry entry{1700000000123,
+                                     QtDebugMsg,
+                                     QByteArray("lidar_driver.cpp"),
+                                     214,
+                                     QByteArray("void LidarDriver::onFrame(const Frame &)"),
+                                     QByteArray("frame 48213 received: 28800 points, 3 dropped, 10.02 ms"),
+                                     reinterpret_cast<quintptr>(QThread::currentThreadId()),
+                                     1};
+    QByteArray batch;
+    for (quint64 i = 0; i < iterations; ++i)
+    {
+      LogManager::formatLogEntry(entry, batch);
+      if (batch.size() >= 8 * 1024)
+      {
+        batch.truncate(0);
+      }
+    }
+    keepAlive(batch);
+  }
+
+  static void handleMessage(QtMsgType type, const QMessageLogContext &context, const QString &message)
+  {
+    LogManager::qtMessageHandler(type, context, message);
+  }
+};
+
+} // namespace QtUtils
+
+using QtUtils::LogManagerBench;
+
+namespace
+{
+
+struct BenchCase
+{
+  const char *name;
+  BenchHarness::Body body;
+};
+
+// An INI file shaped like a large product config, with its cache, shared by the startup load cases.
+const QString &startupConfigFile()
+{
+  static QTemporaryDir dir;
+  static const QString path = [&]()
+  {
+    const QString file = dir.filePath(QStringLiteral("config.ini"));
+    {
+      QSettings settings(file, QSettings::IniFormat);
+      for (int device = 0; device < 64; ++device)
+      {
+        for (int field = 0; field < 32; ++field)
+        {
+          settings.setValue(QStringLiteral("sensors/lidar%1/param%2").arg(device).arg(field), device * 100 + field);
+        }
+      }
+    }
+    QtUtils::ConfigCache::Stamp stamp{};
+    QtUtils::ConfigCache::stampOf(file, stamp);
+    QSettings settings(file, QSettings::IniFormat);
+    QHash<QString, QVariant> values;
+    for (const QString &key : settings.allKeys())
+    {
+      values.insert(key, settings.value(key));
+    }
+    QtUtils::ConfigCache::write(file, stamp, values);
+    return file;
+  }();
+  return path;
+}
+
+std::vector<BenchCase> makeCases()
+{
+  std::vector<BenchCase> cases;
+
+  cases.push_back({"LogManager::levelToString",
+                   [](quint64 iterations)
+                   {
+                     static const QtMsgType levels[] = {QtDebugMsg, QtInfoMsg, QtWarningMsg, QtCriticalMsg};
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const char *name = LogManagerBench::levelToString(levels[i & 3]);
+                       keepAlive(name);
+                     }
+                   }});
+
+  cases.push_back({"LogManager::extractFileName",
+                   [](quint64 iterations)
+                   {
+                     const char *path = "/home/build/workspace/robot/src/drivers/lidar/lidar_driver.cpp";
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       keepAlive(path);
+                       const char *name = LogManagerBench::extractFileName(path);
+                       keepAlive(name);
+                     }
+                   }});
+
+  cases.push_back({"LogManager::formatLogEntry",
+                   [](quint64 iterations)
+                   {
+                     LogManagerBench::formatLogEntries(iterations);
+                   }});
+
+  cases.push_back({"LogManager::qtMessageHandler",
+                   [](quint64 iterations)
+                   {
+                     const QMessageLogContext context(__FILE__, __LINE__, Q_FUNC_INFO, "default");
+                     const QString message = QStringLiteral("frame 48213 received: 28800 points, 3 dropped, 10.02 ms");
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       LogManagerBench::handleMessage(QtDebugMsg, context, message);
+                     }
+                   }});
+
+  cases.push_back({"ConfigManager::value",
+                   [](quint64 iterations)
+                   {
+                     const QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+                     const QString key = QStringLiteral("bench/value");
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const QVariant value = config.value(key);
+                       keepAlive(value);
+                     }
+                   }});
+
+  cases.push_back({"ConfigManager::intValue",
+                   [](quint64 iterations)
+                   {
+                     const QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+                     const QString key = QStringLiteral("bench/value");
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const int value = config.intValue(key);
+                       keepAlive(value);
+                     }
+                   }});
+
+  cases.push_back({"ConfigKey::get",
+                   [](quint64 iterations)
+                   {
+                     static const QtUtils::ConfigKey<int> key(QStringLiteral("bench/value"), 0);
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const int value = key.get();
+                       keepAlive(value);
+                     }
+                   }});
+
+  cases.push_back({"ConfigManager::group (per-device reads)",
+                   [](quint64 iterations)
+                   {
+                     const QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+                     const QString prefix = QStringLiteral("bench/sensors/lidar%1/");
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const auto device = config.group(prefix.arg(i & 63));
+                       const QMap<QString, int> params = device.toMap<int>();
+                       keepAlive(params);
+                     }
+                   }});
+
+  cases.push_back({"config startup: INI parse (2048 keys)",
+                   [](quint64 iterations)
+                   {
+                     const QString &file = startupConfigFile();
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       QSettings settings(file, QSettings::IniFormat);
+                       QHash<QString, QVariant> values;
+                       for (const QString &key : settings.allKeys())
+                       {
+                         values.insert(key, settings.value(key));
+                       }
+                       keepAlive(values);
+                     }
+                   }});
+
+  cases.push_back({"config startup: ConfigCache::read (2048 keys)",
+                   [](quint64 iterations)
+                   {
+                     const QString &file = startupConfigFile();
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       QHash<QString, QVariant> values;
+                       QtUtils::ConfigCache::read(file, values);
+                       keepAlive(values);
+                     }
+                   }});
+
+  cases.push_back({"CommonUtils::getAvailableDiskSpaceInMB",
+                   [](quint64 iterations)
+                   {
+                     const QString &path = QtUtils::CommonUtils::getAppLogDirPath();
+                     for (quint64 i = 0; i < iterations; ++i)
+                     {
+                       const qint64 space = QtUtils::CommonUtils::getAvailableDiskSpaceInMB(path);
+                       keepAlive(space);
+                     }
+                   }});
+
+  return cases;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("qtutils-bench");
+  QCoreApplication::setApplicationVersion("1.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Microbenchmarks for qtutils internals, in ns/op and allocations/op");
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  const int cores = std::max(2, QThread::idealThreadCount());
+  QCommandLineOption threadsOption("threads",
+                                   QString("Comma-separated thread counts (default: 1,%1)").arg(cores),
+                                   "list",
+                                   QString("1,%1").arg(cores));
+  QCommandLineOption minTimeOption("min-time", "Target duration of each run in ms (default: 300)", "ms", "300");
+  QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text", "text");
+  parser.addOption(threadsOption);
+  parser.addOption(minTimeOption);
+  parser.addOption(filterOption);
+  parser.process(app);
+
+  std::vector<int> thread_counts;
+  for (const QString &item : parser.value(threadsOption).split(',', Qt::SkipEmptyParts))
+  {
+    bool ok = false;
+    const int count = item.trimmed().toInt(&ok);
+    if (!ok || count < 1)
+    {
+      fprintf(stderr, "Invalid --threads: %s\n", qPrintable(parser.value(threadsOption)));
+      return 1;
+    }
+    thread_counts.push_back(count);
+  }
+
+  // Keep the handler benchmark to the enqueue path: the worker still drains the queue but writes nothing.
+  QtUtils::LogManager &log_manager = QtUtils::LogManager::instance();
+  log_manager.configure(QtDebugMsg, false, false);
+
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.setValue("bench/value", 42);
+  auto sensors = config.begin();
+  for (int device = 0; device < 64; ++device)
+  {
+    for (int field = 0; field < 32; ++field)
+    {
+      sensors.set(QStringLiteral("bench/sensors/lidar%1/param%2").arg(device).arg(field), field);
+    }
+  }
+  sensors.commit();
+
+  if (!AllocCounter::isAvailable())
+  {
+    fprintf(stderr, "Allocation counting needs glibc; allocs/op is reported as n/a\n");
+  }
+
+  BenchHarness harness(std::chrono::milliseconds(std::max(1, parser.value(minTimeOption).toInt())));
+  const QString filter = parser.value(filterOption);
+  BenchHarness::printHeader();
+  for (const BenchCase &bench_case : makeCases())
+  {
+    const QString name = QString::fromLatin1(bench_case.name);
+    if (!filter.isEmpty() && !name.contains(filter, Qt::CaseInsensitive))
+    {
+      continue;
+    }
+    for (int threads : thread_counts)
+    {
+      BenchHarness::print(harness.run(name, threads, bench_case.body));
+    }
+  }
+
+  config.remove("bench");
+  config.save();
+  log_manager.shutdown();
+  return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+
+namespace QtUtils
+{
+
+// Binary copy of a QSettings INI file written next to it as "<file>.cache": a header, a table of fixed-size entries
+// sorted by key and a blob of UTF-16 keys and typed values, read through a memory map. The header records the
+// size, mtime and content hash of the INI it was built from; a cache that does not match the INI is never read.
+// The INI stays the source of truth and the cache can be deleted at any time.
+class ConfigCache
+{
+public:
+  ConfigCache() = delete;
+
+  struct Stamp
+  {
+    qint64 size;
+    qint64 mtime_ms;
+    quint64 hash;
+
+    bool operator==(const Stamp &other) const
+    {
+      return size == other.size && mtime_ms == other.mtime_ms && hash == other.hash;
+    }
+  };
+
+  static QString cachePathFor(const QString &ini_file);
+  static bool stampOf(const QString &ini_file, Stamp &stamp);
+
+  // Fails unless the cache was built from the INI file as it is now.
+  static bool read(const QString &ini_file, QHash<QString, QVariant> &values);
+  static bool isFresh(const QString &ini_file, const Stamp &stamp);
+  // values must be what QSettings parsed from the INI file while it had this stamp; nothing is written if the
+  // file has changed since.
+  static bool write(const QString &ini_file, const Stamp &stamp, const QHash<QString, QVariant> &values);
+};
+
+} // namespace QtUtils
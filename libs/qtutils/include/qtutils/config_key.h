@@ -0,0 +1,167 @@
+#pragma once
+
+#include "qtutils/config_manager.h"
+#include "qtutils/config_schema.h"
+#include <QString>
+#include <QVariant>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace QtUtils
+{
+
+// Typed handle to one ConfigManager key. Construct once (e.g. as a static) and reuse: the key is resolved on the
+// first get(), after which get() returns a parsed and validated T cached per thread, refreshed only when this key's
+// value changes. A value that is missing or does not convert to T yields default_value.
+template <typename T>
+class ConfigKey
+{
+public:
+  using Validator = std::function<T(const T &value)>;
+
+  ConfigKey(const QString &key, const T &default_value, Validator validator = Validator())
+      : key_(key), default_value_(default_value), validator_(std::move(validator)), id_(next_id_.fetch_add(1))
+  {
+  }
+
+  // The spec's range, if any, becomes a clamp.
+  explicit ConfigKey(const ConfigSpec<T> &spec)
+      : ConfigKey(QString::fromUtf8(spec.key),
+                  ConfigSpec<T>::toValue(spec.default_value),
+                  spec.has_range ? clamp(ConfigSpec<T>::toValue(spec.min), ConfigSpec<T>::toValue(spec.max))
+                                 : Validator())
+  {
+  }
+
+  ConfigKey(const ConfigKey &) = delete;
+  ConfigKey &operator=(const ConfigKey &) = delete;
+
+  static Validator clamp(const T &min, const T &max)
+  {
+    return [min, max](const T &value)
+    {
+      return std::clamp(value, min, max);
+    };
+  }
+
+  const QString &key() const
+  {
+    return key_;
+  }
+
+  QVariant defaultValue() const
+  {
+    return QVariant::fromValue(default_value_);
+  }
+
+  // The reference stays valid until this thread calls get() on this handle again.
+  const T &get() const;
+
+private:
+  struct Cached
+  {
+    quint64 generation{0};
+    T value{};
+  };
+
+  T load() const;
+  static bool convert(const QVariant &variant, T &value);
+
+  static inline std::atomic<size_t> next_id_{0};
+
+  const QString key_;
+  const T default_value_;
+  const Validator validator_;
+  const size_t id_;
+  mutable std::atomic<const ConfigManager::KeySlot *> slot_{nullptr};
+};
+
+template <typename T>
+const T &ConfigKey<T>::get() const
+{
+  const ConfigManager::KeySlot *slot = slot_.load(std::memory_order_acquire);
+  if (slot == nullptr)
+  {
+    slot = ConfigManager::instance().resolveKey(key_);
+    slot_.store(slot, std::memory_order_release);
+  }
+
+  // One cache per thread and value type, indexed by handle; a deque keeps references stable as it grows.
+  thread_local std::deque<Cached> cache;
+  if (cache.size() <= id_)
+  {
+    cache.resize(id_ + 1);
+  }
+  Cached &cached = cache[id_];
+
+  ConfigManager::instance().checkShared();
+  const quint64 generation = slot->generation.load(std::memory_order_acquire);
+  if (cached.generation != generation)
+  {
+    cached.value = load();
+    cached.generation = generation;
+  }
+  return cached.value;
+}
+
+template <typename T>
+T ConfigKey<T>::load() const
+{
+  T value = default_value_;
+  if (!convert(ConfigManager::instance().value(key_), value))
+  {
+    value = default_value_;
+  }
+  return validator_ ? validator_(value) : value;
+}
+
+template <typename T>
+bool ConfigKey<T>::convert(const QVariant &variant, T &value)
+{
+  if (!variant.isValid())
+  {
+    return false;
+  }
+
+  bool ok = true;
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    value = variant.toBool();
+  }
+  else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+  {
+    const qlonglong number = variant.toLongLong(&ok);
+    ok = ok && number >= std::numeric_limits<T>::min() && number <= std::numeric_limits<T>::max();
+    value = static_cast<T>(number);
+  }
+  else if constexpr (std::is_integral_v<T>)
+  {
+    const qulonglong number = variant.toULongLong(&ok);
+    ok = ok && number <= std::numeric_limits<T>::max();
+    value = static_cast<T>(number);
+  }
+  else if constexpr (std::is_floating_point_v<T>)
+  {
+    value = static_cast<T>(variant.toDouble(&ok));
+  }
+  else if constexpr (std::is_same_v<T, QString>)
+  {
+    value = variant.toString();
+  }
+  else
+  {
+    ok = variant.canConvert<T>();
+    if (ok)
+    {
+      value = variant.value<T>();
+    }
+  }
+  return ok;
+}
+
+} // namespace QtUtils
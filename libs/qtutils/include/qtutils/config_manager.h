@@ -1,14 +1,35 @@
 #pragma once
 
+#include <QHash>
 #include <QMap>
 #include <QScopedPointer>
 #include <QSettings>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class QThread;
 
 namespace QtUtils
 {
 
+class ConfigShm;
+
+template <typename T>
+class ConfigKey;
+
+// Reads are served from an immutable snapshot of all effective values, registered defaults overlaid by the
+// settings file. Writers rebuild and publish a new snapshot; a reader only touches shared state when the snapshot
+// version it cached has changed, so reads are wait-free and never contend with writers.
 class ConfigManager final
 {
 public:
@@ -17,12 +38,48 @@ public:
 
   static ConfigManager &instance();
 
+  // Collects changes and applies them on commit() as one step: readers see all of them or none, each subscriber
+  // is notified once and the file is written once. Changes that are never committed are discarded.
+  class Transaction
+  {
+  public:
+    Transaction(Transaction &&) = default;
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+
+    void set(const QString &key, const QVariant &value);
+    void remove(const QString &key);
+    // Applied in the order they were made. Returns false if the file could not be written; the changes are
+    // applied in memory regardless.
+    bool commit();
+
+  private:
+    friend class ConfigManager;
+
+    explicit Transaction(ConfigManager &manager);
+
+    struct Change
+    {
+      QString key;
+      QVariant value;
+      bool remove;
+    };
+
+    ConfigManager *manager_;
+    std::vector<Change> changes_;
+  };
+
+  Transaction begin();
+
   void registerDefaults(const QMap<QString, QVariant> &defaults);
 
   QVariant value(const QString &key, const QVariant &default_value = QVariant()) const;
   void setValue(const QString &key, const QVariant &value);
   void remove(const QString &key);
+  // Writes all pending changes before returning, also in write-behind mode.
   bool save();
+  // Picks up changes made to the config file by other processes or QSettings instances.
+  bool reload();
 
   QString stringValue(const QString &key, const QString &default_value = QString()) const;
   int intValue(const QString &key, int default_value = 0) const;
@@ -31,12 +88,225 @@ public:
 
   QString configFilePath() const;
 
+  class Group;
+  // View of every key starting with prefix, e.g. "sensors/lidar3/" for one group or "sensors/lidar" for all
+  // lidar groups. The view reads one snapshot, so it stays consistent while config changes; call again for new
+  // values.
+  Group group(const QString &prefix) const;
+  // Values of all keys from one snapshot, in the same order; missing keys give an invalid QVariant.
+  QVariantList values(const QStringList &keys) const;
+
+  // Called with the subscribed keys whose effective value changed, on the thread that made the change; for
+  // reloads of a watched file that is the watcher thread. A key ending in '/' subscribes to its whole group and
+  // an empty list to every key. Callbacks run outside the manager's lock and may read or write config.
+  using ChangeCallback = std::function<void(const QStringList &changed_keys)>;
+  int subscribe(const QStringList &keys, ChangeCallback callback);
+  // Once this returns the callback is not called again: a call in progress on another thread is waited for, so a
+  // subscriber may unsubscribe in its destructor. Calling it from inside the callback itself is allowed.
+  void unsubscribe(int id);
+
+  // Reloads the config file on a background thread whenever it changes on disk, once it has been quiet for
+  // debounce_ms, so a burst of writes by another process causes a single reload.
+  bool startWatching(int debounce_ms = 250);
+  void stopWatching();
+  bool isWatching() const;
+
+  // Write-behind: changes are flushed by a background thread once none has been made for quiet_ms, and when
+  // write-behind is turned off or the manager is destroyed. 0 (the default) leaves writing to save(). The file is
+  // replaced atomically either way, so a crash leaves the old or the new config.ini, never a torn one.
+  void setWriteBehind(int quiet_ms);
+  int writeBehind() const;
+
+  // Multi-process mode, POSIX only, set up once at startup. One process shares its effective config in a
+  // shared-memory table that it rewrites on every change; the others follow it, serving reads from that table and
+  // seeing a new version on their next read, without touching the file. A follower's own writes still go to its
+  // config file and are replaced by the next shared version. An empty name derives one from the config file path.
+  bool shareConfig(const QString &name = QString(), qint64 capacity = 4 * 1024 * 1024);
+  bool followSharedConfig(const QString &name = QString());
+
 private:
+  template <typename T>
+  friend class ConfigKey;
+
   explicit ConfigManager();
-  ~ConfigManager() = default;
+  ~ConfigManager();
+
+  struct Entry
+  {
+    QVariant value;
+    // Only registered, not in the settings file; an explicit default_value takes precedence.
+    bool is_default{false};
+
+    bool operator==(const Entry &other) const
+    {
+      return is_default == other.is_default && value == other.value;
+    }
+  };
+  using Snapshot = QHash<QString, Entry>;
+
+  // Bumped after every publish that changes the key's entry; starts at 1 so 0 can mean "never read".
+  struct KeySlot
+  {
+    explicit KeySlot(const QString &name) : key(name)
+    {
+    }
+
+    const QString key;
+    std::atomic<quint64> generation{1};
+  };
+
+  // The slot lives as long as the manager; resolving the same key again returns the same slot.
+  const KeySlot *resolveKey(const QString &key);
+
+  // Follower only: picks up a newer shared table; cheap enough for every read.
+  void checkShared() const
+  {
+    const std::atomic<quint64> *sequence = shared_sequence_.load(std::memory_order_acquire);
+    if (sequence != nullptr &&
+        sequence->load(std::memory_order_acquire) != shared_seen_.load(std::memory_order_acquire))
+    {
+      refreshShared();
+    }
+  }
+  void refreshShared() const;
+  // Called with mutex_ held once the followed segment is retired; true once a new one of that name is open.
+  bool followReplacement();
+  // Called with mutex_ held.
+  bool shareSnapshot(const Snapshot &snapshot);
+
+  // The snapshot is owned by a thread-local cache; the reference stays valid until this thread calls it again.
+  const Snapshot &snapshot() const;
+  void rebuildSnapshot();
+  static QHash<QString, QVariant> fileValues(const Snapshot &snapshot);
+  void publish(std::shared_ptr<const Snapshot> snapshot);
+  static QStringList changedKeys(const Snapshot *before, const Snapshot &after);
+  // Runs the callbacks queued by publish(); call without holding mutex_.
+  void notifySubscribers();
+
+  bool apply(const std::vector<Transaction::Change> &changes);
 
+  // Keys of one snapshot in sorted order, built on first use by a group query and shared until the next publish.
+  struct KeyIndex
+  {
+    quint64 version;
+    std::shared_ptr<const Snapshot> snapshot;
+    // Entries point into snapshot.
+    std::vector<std::pair<QString, const Entry *>> entries;
+  };
+  std::shared_ptr<const KeyIndex> keyIndex() const;
+
+  // Creates settings_ on first use; until then reads may be served from the cache. Called with mutex_ held.
+  bool ensureSettings();
+  // Rebuilds the cache next to the config file unless it already matches it.
+  void updateCache() const;
+
+  // Both are called with mutex_ held. deferWrite() returns false if write-behind is off.
+  bool deferWrite();
+  bool syncLocked();
+  void persistLoop();
+
+  struct Subscription
+  {
+    int id{0};
+    QStringList keys;
+    ChangeCallback callback;
+    // Held around each call; unsubscribe() takes it to clear active, which waits out a call in progress.
+    mutable std::recursive_mutex call_mutex;
+    mutable bool active{true};
+  };
+
+  struct Notification
+  {
+    std::shared_ptr<const Subscription> subscription;
+    QStringList keys;
+  };
+
+  QString config_file_path_;
   QScopedPointer<QSettings> settings_;
   QMap<QString, QVariant> defaults_;
+
+  std::mutex mutex_;
+  std::shared_ptr<const Snapshot> snapshot_;
+  std::atomic<quint64> version_{0};
+  mutable std::shared_ptr<const KeyIndex> key_index_;
+  std::deque<KeySlot> key_slots_;
+  QHash<QString, KeySlot *> key_slot_index_;
+
+  std::vector<std::shared_ptr<const Subscription>> subscriptions_;
+  std::vector<Notification> pending_notifications_;
+  int next_subscription_id_{1};
+
+  // Set once by shareConfig() or followSharedConfig(); a follower replaces it only when the segment is removed.
+  std::unique_ptr<ConfigShm> shared_;
+  std::vector<std::unique_ptr<ConfigShm>> retired_shared_;
+  std::atomic<const std::atomic<quint64> *> shared_sequence_{nullptr};
+  std::atomic<quint64> shared_seen_{0};
+  std::chrono::steady_clock::time_point shared_retry_at_{};
+  bool shared_retired_warned_{false};
+
+  mutable std::mutex watch_mutex_;
+  QThread *watch_thread_{nullptr};
+
+  // Lock order: mutex_, then persist_mutex_.
+  mutable std::mutex persist_mutex_;
+  std::condition_variable persist_cond_;
+  QThread *persist_thread_{nullptr};
+  bool persist_running_{false};
+  bool dirty_{false};
+  int write_behind_ms_{0};
+  std::chrono::steady_clock::time_point last_change_;
+};
+
+class ConfigManager::Group
+{
+public:
+  const QString &prefix() const
+  {
+    return prefix_;
+  }
+
+  int size() const
+  {
+    return static_cast<int>(end_ - begin_);
+  }
+
+  bool isEmpty() const
+  {
+    return begin_ == end_;
+  }
+
+  // Keys below the prefix, with the prefix removed, in sorted order.
+  QStringList keys() const;
+  // Distinct first path segments below the prefix, e.g. "lidar0", "lidar1" for "sensors/".
+  QStringList childGroups() const;
+  bool contains(const QString &key) const;
+  QVariant value(const QString &key, const QVariant &default_value = QVariant()) const;
+  Group group(const QString &prefix) const;
+
+  void forEach(const std::function<void(const QString &key, const QVariant &value)> &visit) const;
+
+  // Every value converted to T, keyed like keys().
+  template <typename T>
+  QMap<QString, T> toMap() const
+  {
+    QMap<QString, T> map;
+    for (size_t i = begin_; i < end_; ++i)
+    {
+      const auto &entry = index_->entries[i];
+      map.insert(entry.first.mid(prefix_.size()), entry.second->value.template value<T>());
+    }
+    return map;
+  }
+
+private:
+  friend class ConfigManager;
+
+  Group(std::shared_ptr<const KeyIndex> index, const QString &prefix);
+
+  std::shared_ptr<const KeyIndex> index_;
+  QString prefix_;
+  size_t begin_{0};
+  size_t end_{0};
 };
 
 } // namespace QtUtils
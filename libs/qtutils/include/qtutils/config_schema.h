@@ -0,0 +1,181 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <cstddef>
+#include <type_traits>
+
+namespace QtUtils
+{
+
+// One config key declared at compile time: key, type, default, optional range and a doc string. T is bool, an
+// integer type, a floating point type or QString; QString defaults are UTF-8 literals.
+template <typename T>
+struct ConfigSpec
+{
+  using Stored = std::conditional_t<std::is_same_v<T, QString>, const char *, T>;
+
+  const char *key;
+  Stored default_value;
+  bool has_range;
+  Stored min;
+  Stored max;
+  const char *doc;
+
+  static T toValue(Stored stored)
+  {
+    if constexpr (std::is_same_v<T, QString>)
+    {
+      return QString::fromUtf8(stored);
+    }
+    else
+    {
+      return stored;
+    }
+  }
+};
+
+template <typename T>
+constexpr ConfigSpec<T> configSpec(const char *key, T default_value, const char *doc)
+{
+  return {key, default_value, false, default_value, default_value, doc};
+}
+
+template <typename T>
+constexpr ConfigSpec<T> configSpec(const char *key, T default_value, T min, T max, const char *doc)
+{
+  return {key, default_value, true, min, max, doc};
+}
+
+inline constexpr ConfigSpec<QString> configSpec(const char *key, const char *default_value, const char *doc)
+{
+  return {key, default_value, false, default_value, default_value, doc};
+}
+
+// Type-erased ConfigSpec, so the specs of all types form one constexpr table.
+struct ConfigField
+{
+  enum class Type
+  {
+    Bool,
+    Int,
+    Double,
+    String
+  };
+
+  const char *key;
+  Type type;
+  bool has_range;
+  double min;
+  double max;
+  // Only the member matching type is set.
+  bool default_bool;
+  qint64 default_int;
+  double default_double;
+  const char *default_string;
+  const char *doc;
+
+  template <typename T>
+  static constexpr ConfigField of(const ConfigSpec<T> &spec)
+  {
+    ConfigField field{spec.key, Type::String, spec.has_range, 0.0, 0.0, false, 0, 0.0, "", spec.doc};
+    if constexpr (std::is_same_v<T, bool>)
+    {
+      field.type = Type::Bool;
+      field.default_bool = spec.default_value;
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+      field.type = Type::Int;
+      field.default_int = spec.default_value;
+      field.min = static_cast<double>(spec.min);
+      field.max = static_cast<double>(spec.max);
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+      field.type = Type::Double;
+      field.default_double = spec.default_value;
+      field.min = spec.min;
+      field.max = spec.max;
+    }
+    else
+    {
+      static_assert(std::is_same_v<T, QString>, "config values are bool, integer, floating point or QString");
+      field.default_string = spec.default_value;
+    }
+    return field;
+  }
+};
+
+// Checks, registration, load-time validation and documentation for a table of ConfigFields.
+class ConfigSchema
+{
+public:
+  ConfigSchema() = delete;
+
+  // For static_assert: every key is set, unique and documented, and every range holds its default.
+  template <size_t N>
+  static constexpr bool isValid(const ConfigField (&fields)[N])
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      const ConfigField &field = fields[i];
+      if (field.key == nullptr || field.key[0] == '\0' || field.doc == nullptr || field.doc[0] == '\0')
+      {
+        return false;
+      }
+      const double value = field.type == ConfigField::Type::Int ? static_cast<double>(field.default_int)
+                                                                : field.default_double;
+      if (field.has_range && (field.min > field.max || value < field.min || value > field.max))
+      {
+        return false;
+      }
+      for (size_t j = 0; j < i; ++j)
+      {
+        if (sameKey(field.key, fields[j].key))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  template <size_t N>
+  static void registerDefaults(const ConfigField (&fields)[N])
+  {
+    registerDefaults(fields, N);
+  }
+
+  template <size_t N>
+  static int validate(const ConfigField (&fields)[N])
+  {
+    return validate(fields, N);
+  }
+
+  template <size_t N>
+  static QString dump(const ConfigField (&fields)[N])
+  {
+    return dump(fields, N);
+  }
+
+  static void registerDefaults(const ConfigField *fields, size_t count);
+  // Replaces stored values that do not parse as their type with the default and clamps those out of range, in one
+  // commit, warning about each. Returns how many were replaced. Run once after loading so reads need no checks.
+  static int validate(const ConfigField *fields, size_t count);
+  // An INI file with every key at its default, each preceded by its doc, type and range as comments.
+  static QString dump(const ConfigField *fields, size_t count);
+
+private:
+  static constexpr bool sameKey(const char *a, const char *b)
+  {
+    while (*a != '\0' && *a == *b)
+    {
+      ++a;
+      ++b;
+    }
+    return *a == *b;
+  }
+};
+
+} // namespace QtUtils
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+namespace QtUtils
+{
+
+// A table of config entries in a POSIX shared-memory segment, written by one process and mapped read-only by any
+// number of others. The table is guarded by a sequence counter (a seqlock): the writer makes it odd while copying a
+// new table in and even again when done, and a reader retries until it copies a table with the same even sequence
+// before and after. Readers never block the writer and never call into another process.
+//
+// The segment outlives its writers, so followers keep working across a writer restart; a new writer that needs more
+// room grows it and readers remap on their next read. The header stays mapped at a fixed address meanwhile.
+class ConfigShm
+{
+public:
+  struct Item
+  {
+    QString key;
+    QVariant value;
+    bool is_default;
+  };
+
+  ConfigShm() = default;
+  ~ConfigShm();
+
+  ConfigShm(const ConfigShm &) = delete;
+  ConfigShm &operator=(const ConfigShm &) = delete;
+
+  // Segment name shared by every process using this config file.
+  static QString nameFor(const QString &config_file);
+
+  // Creates or takes over the segment as its only writer; fails while another process holds it. capacity bounds
+  // the encoded table.
+  bool create(const QString &name, qint64 capacity);
+  // Maps an existing segment read-only.
+  bool open(const QString &name);
+  // Unmaps the segment but leaves its name for the next writer and for followers.
+  void close();
+  // Deletes the named segment, for uninstalling or tests. Mappings of it are flagged retired first and see one
+  // more sequence change, so followers notice and can open whatever segment takes the name next.
+  static bool remove(const QString &name);
+  bool isOpen() const;
+  bool isWriter() const;
+  bool isRetired() const;
+  QString name() const;
+  QString errorString() const;
+
+  // Writer only. Fails, leaving the previous table in place, if the table does not fit.
+  bool write(const std::vector<Item> &items);
+  // Copies out a consistent table and the sequence it was written under. Remaps first if the segment has grown.
+  bool read(std::vector<Item> &items, quint64 &sequence);
+  // Changes on every write; valid until close().
+  const std::atomic<quint64> *sequence() const;
+
+private:
+  struct Header;
+
+  bool mapHeader(bool writable);
+  // Maps the whole segment again at size, replacing any previous payload mapping.
+  bool mapPayload(qint64 size, bool writable);
+  bool remapIfGrown();
+
+  Header *header_{nullptr};
+  void *payload_map_{nullptr};
+  uchar *payload_{nullptr};
+  quint64 capacity_{0};
+  qint64 map_size_{0};
+  int fd_{-1};
+  bool writer_{false};
+  QString name_;
+  QString error_;
+};
+
+} // namespace QtUtils
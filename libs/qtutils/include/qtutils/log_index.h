@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+namespace QtUtils
+{
+
+// Sidecar index written next to each log file as "<file>.idx": a small header followed by one fixed-size record
+// per block of roughly blockBytes() bytes, giving the byte range, timestamp range and per-level entry counts.
+class LogIndex
+{
+public:
+  LogIndex() = delete;
+
+  static constexpr int kLevelCount = 5;
+
+  struct Block
+  {
+    qint64 offset;
+    qint64 length;
+    qint64 min_ts_ms;
+    qint64 max_ts_ms;
+    quint32 level_counts[kLevelCount];
+    quint32 reserved;
+  };
+
+  struct ByteRange
+  {
+    qint64 begin;
+    qint64 end;
+  };
+
+  static QString indexPathFor(const QString &log_file);
+  static bool read(const QString &index_file, QVector<Block> &blocks);
+
+  // Sorted, non-overlapping byte ranges of a file_size byte log that can hold entries between from_ms and to_ms
+  // (inclusive) at min_level or above. Bytes no block covers are always included.
+  static QVector<ByteRange> selectRanges(const QVector<Block> &blocks,
+                                         qint64 file_size,
+                                         qint64 from_ms,
+                                         qint64 to_ms,
+                                         int min_level);
+};
+
+class LogIndexWriter
+{
+public:
+  LogIndexWriter() = default;
+  ~LogIndexWriter();
+
+  LogIndexWriter(const LogIndexWriter &) = delete;
+  LogIndexWriter &operator=(const LogIndexWriter &) = delete;
+
+  bool open(const QString &log_file, qint64 block_bytes);
+  void close();
+  bool isOpen() const;
+
+  void addEntry(qint64 offset, qint64 length, qint64 timestamp_ms, int level_index);
+  void flush();
+
+private:
+  void emitBlock();
+
+  QFile file_;
+  qint64 block_bytes_{64 * 1024};
+  LogIndex::Block block_{};
+  bool block_open_{false};
+};
+
+} // namespace QtUtils
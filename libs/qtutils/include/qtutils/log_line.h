@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QDateTime>
+#include <QtGlobal>
+
+namespace QtUtils
+{
+
+// Parses the fixed prefix of lines written by LogManager, in either text or JSON-lines format, without
+// allocating. Timestamps are returned as sortable keys of the form yyyyMMddhhmmsszzz (local time).
+class LogLine
+{
+public:
+  LogLine() = delete;
+
+  static constexpr int kTimestampLength = 23;
+
+  static const char *findTimestamp(const char *line, qsizetype length);
+  static qint64 timestampKey(const char *line, qsizetype length);
+  static qint64 timestampKey(const QDateTime &datetime);
+  // 0 (DEBUG) to 4 (FATAL), or -1 unless the level field holds exactly one of the names LogManager writes.
+  static int levelIndex(const char *line, qsizetype length);
+  // Same names, case-insensitive, plus "critical" for ERROR; -1 for anything else.
+  static int levelIndex(const QString &level_name);
+};
+
+} // namespace QtUtils
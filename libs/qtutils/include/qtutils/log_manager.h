@@ -1,15 +1,20 @@
 #pragma once
 
+#include "qtutils/log_index.h"
+#include "qtutils/log_record.h"
 #include <QByteArray>
 #include <QFile>
 #include <QMessageLogContext>
 #include <QString>
 #include <QThread>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace QtUtils
 {
@@ -20,26 +25,110 @@ public:
   LogManager(const LogManager &) = delete;
   LogManager &operator=(const LogManager &) = delete;
 
+  enum class DrainMode
+  {
+    FileAndConsole,
+    FileOnly
+  };
+
+  enum class SamplingScope
+  {
+    PerLevel,
+    PerCallSite
+  };
+
+  enum class OutputFormat
+  {
+    Text,
+    JsonLines
+  };
+
   static LogManager &instance();
 
-  void shutdown();
+  void shutdown(DrainMode mode = DrainMode::FileAndConsole);
+
+  // Reinstalls the message handler and starts a new worker after shutdown(), keeping the current settings.
+  // Returns false if the manager is already running.
+  bool restart();
+  bool isRunning() const;
+
+  // Time budget for writing the backlog on shutdown; entries left after it expires are summarized
+  // in a single line instead of written. A value <= 0 disables the limit.
+  void setShutdownBudget(int budget_ms);
+  int shutdownBudget() const;
 
   void configure(QtMsgType min_level = QtDebugMsg, bool enable_console = true, bool enable_file = true);
 
   void setMinLevel(QtMsgType level);
   QtMsgType minLevel() const;
 
+  // Keeps one in keep_one_in messages of the given level, counted per level or per call site (exact for up to 1024
+  // sites per process, approximate beyond).
+  // The decision is lock-free and, for a given seed, deterministic.
+  void setSampling(QtMsgType level, quint32 keep_one_in, SamplingScope scope = SamplingScope::PerLevel);
+  quint32 samplingRate(QtMsgType level) const;
+  void setSamplingSeed(quint64 seed);
+
+  // Applies to log files opened after the call.
+  void setIndexEnabled(bool enabled);
+  bool isIndexEnabled() const;
+  void setIndexBlockSize(qint64 bytes);
+
+  void setOutputFormat(OutputFormat format);
+  OutputFormat outputFormat() const;
+
+  // The worker writes to the file once a batch reaches flush_bytes, and wakes up at least every timeout_ms.
+  void setFlushSize(qint64 flush_bytes);
+  qint64 flushSize() const;
+  void setFlushTimeout(int timeout_ms);
+  int flushTimeout() const;
+
+  // Called on the worker thread with each block of bytes right after it was written and flushed to the log file.
+  // Meant for instrumentation; it runs on the write path, so keep it short. Pass nullptr to remove.
+  using WriteObserver = std::function<void(const QByteArray &data)>;
+  void setWriteObserver(WriteObserver observer);
+
+  // The log file is rotated once it reaches max_bytes; after each rotation only the newest max_files *.log files
+  // in the log directory are kept.
+  void setMaxFileSize(qint64 max_bytes);
+  qint64 maxFileSize() const;
+  void setMaxFileCount(int max_files);
+  int maxFileCount() const;
+
+  // Called on the worker thread after each rotation with the time it took to close, rename, prune old files and
+  // open the next one, during which nothing is written. Same rules as the write observer; pass nullptr to remove.
+  using RotationObserver = std::function<void(qint64 duration_ns)>;
+  void setRotationObserver(RotationObserver observer);
+
   void setConsoleEnabled(bool enabled);
   bool isConsoleEnabled() const;
 
   void setFileEnabled(bool enabled);
   bool isFileEnabled() const;
 
+  // Cumulative since the first start; reading it costs a few relaxed loads.
+  struct Stats
+  {
+    quint64 enqueued{0};
+    quint64 processed{0};
+    // Left unwritten when the shutdown drain budget ran out; enqueued == processed + dropped once drained.
+    quint64 dropped{0};
+    qsizetype queue_depth{0};
+    qsizetype max_queue_depth{0};
+    qint64 file_bytes_written{0};
+    quint64 rotations{0};
+  };
+  Stats stats() const;
+
   QString currentLogFile() const;
   qint64 currentFileSize() const;
   qsizetype fileCount() const;
+  bool isStorageReady() const;
 
 private:
+  friend class LogRecord;
+  friend class LogManagerBench;
+
   explicit LogManager();
   ~LogManager();
 
@@ -52,15 +141,43 @@ private:
     QByteArray function;
     QByteArray message;
     quintptr threadid;
+    quint32 sample_rate;
+    std::vector<LogField> fields{};
   };
 
+  static constexpr int kLevelCount = 5;
+
   static void qtMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
   static const char *extractFileName(const char *path);
+  static int levelIndex(QtMsgType type);
+  static quint64 mixSeed(quint64 value);
+  bool sampleKeep(QtMsgType type, const char *file, int line, quint32 &rate);
+  std::atomic<quint64> *siteCounter(quint64 key);
+  bool accepts(QtMsgType type, const char *file, int line, quint32 &sample_rate);
+  void enqueue(LogEntry &&entry);
+  void submit(LogRecord &record);
 
   bool initialize(const QString &log_dir, QtMsgType min_level, bool enable_console, bool enable_file);
+  void prepareStorage();
+  // Called with storage_mutex_ held.
+  bool isLogDirUsable() const;
+  // Sets file_enabled_, or clears it and returns false if enabled is requested for an unusable directory.
+  bool applyFileEnabled(bool enabled);
+  // Only the worker changes the name while running; other threads read it through currentLogFile().
+  void setCurrentFileName(const QString &file_name);
 
   void workerThread();
-  static QString formatLogEntry(const LogEntry &entry);
+  void processBatch(std::deque<LogEntry> &batch);
+  LogEntry makeDropSummary(const std::deque<LogEntry> &dropped);
+  bool drainBudgetExceeded() const;
+  bool isConsoleActive() const;
+  static qint64 steadyNowNs();
+  void encodeEntry(const LogEntry &entry, QByteArray &out) const;
+  static void formatLogEntry(const LogEntry &entry, QByteArray &out);
+  static void encodeJsonEntry(const LogEntry &entry, QByteArray &out);
+  static void appendThreadId(QByteArray &out, quintptr threadid);
+  static void appendJsonString(QByteArray &out, const QByteArray &text);
+  static void appendFieldValue(QByteArray &out, const LogField &field, bool json);
   static const char *levelToString(QtMsgType type);
 
   bool openLogFile();
@@ -75,20 +192,52 @@ private:
 
   QThread *worker_thread_{nullptr};
   std::atomic<bool> thread_is_running_{false};
+  // From initialize() until shutdown() has taken the last entries; stays true while the worker drains.
+  std::atomic<bool> accepting_{false};
   std::atomic<bool> console_enabled_{true};
   std::atomic<bool> file_enabled_{true};
   std::atomic<QtMsgType> min_level_{QtDebugMsg};
+  std::atomic<bool> storage_ready_{false};
+  std::atomic<OutputFormat> output_format_{OutputFormat::Text};
 
+  // Guards log_dir_ and current_file_name_ against readers outside the worker, and orders file enabling with
+  // the worker's directory check.
+  mutable std::mutex storage_mutex_;
   QString log_dir_;
   std::unique_ptr<QFile> current_file_;
   QString current_file_name_;
   std::atomic<qint64> current_file_size_{0};
+  LogIndexWriter index_writer_;
+  std::atomic<bool> index_enabled_{true};
+  std::atomic<qint64> index_block_bytes_{64 * 1024};
 
   std::atomic<qint64> max_file_size_{10 * 1024 * 1024};
   std::atomic<int> max_files_count_{100};
 
   std::atomic<qint64> flush_size_{8 * 1024};
   std::atomic<int> flush_timeout_ms_{200};
+  std::shared_ptr<const WriteObserver> write_observer_;
+  std::shared_ptr<const RotationObserver> rotation_observer_;
+
+  std::atomic<int> shutdown_budget_ms_{3000};
+  std::atomic<qint64> drain_deadline_ns_{0};
+  std::atomic<bool> drain_file_only_{false};
+
+  std::atomic<quint32> sample_rates_[kLevelCount]{};
+  std::atomic<bool> sample_per_site_[kLevelCount]{};
+  std::atomic<quint64> sample_seed_{0};
+  std::atomic<quint64> sample_level_counters_[kLevelCount]{};
+  // Indexed alike: the call site key owning each counter, 0 while the slot is free.
+  std::array<std::atomic<quint64>, 1024> sample_site_keys_{};
+  std::array<std::atomic<quint64>, 1024> sample_site_counters_{};
+
+  std::atomic<quint64> enqueued_count_{0};
+  std::atomic<quint64> processed_count_{0};
+  std::atomic<quint64> dropped_count_{0};
+  std::atomic<qsizetype> queue_depth_{0};
+  std::atomic<qsizetype> max_queue_depth_{0};
+  std::atomic<qint64> file_bytes_written_{0};
+  std::atomic<quint64> rotations_count_{0};
 
   std::deque<LogEntry> queue_;
   std::mutex mutex_;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+namespace QtUtils
+{
+
+class LogMergeSource;
+
+// Streaming k-way merge of LogManager files by timestamp. Plain files are memory-mapped and read sequentially;
+// gzip and zstd files are decompressed through the gzip/zstd command line tools. Memory use is bounded by one
+// read-ahead window per input plus the output buffer, independent of input size.
+class LogMerger
+{
+public:
+  LogMerger();
+  ~LogMerger();
+
+  LogMerger(const LogMerger &) = delete;
+  LogMerger &operator=(const LogMerger &) = delete;
+
+  void setReadAheadBytes(qint64 bytes);
+  void setOutputBufferBytes(qint64 bytes);
+
+  bool addInput(const QString &path);
+  qsizetype inputCount() const;
+
+  bool merge(QIODevice &output);
+
+  qint64 entriesWritten() const;
+  qint64 bytesWritten() const;
+  QString errorString() const;
+
+  static QStringList findLogFiles(const QString &dir_path);
+
+private:
+  std::vector<std::unique_ptr<LogMergeSource>> sources_;
+  qint64 read_ahead_bytes_{8 * 1024 * 1024};
+  qint64 output_buffer_bytes_{4 * 1024 * 1024};
+  qint64 entries_written_{0};
+  qint64 bytes_written_{0};
+  QString error_string_;
+};
+
+} // namespace QtUtils
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <type_traits>
+#include <vector>
+
+namespace QtUtils
+{
+
+// Interned field name. Construct once (e.g. as a static) and reuse; interning takes a lock, lookups by id do not.
+class LogKey
+{
+public:
+  explicit LogKey(const char *name);
+  explicit LogKey(const QByteArray &name);
+
+  quint32 id() const;
+  QByteArray name() const;
+
+  static const QByteArray &nameOf(quint32 id);
+  // Same key as LogKey(name), served from a per-thread cache keyed by the pointer, so repeating a string literal
+  // takes neither the lock nor a hash of the name.
+  static LogKey cached(const char *name);
+
+private:
+  explicit LogKey(quint32 id);
+
+  quint32 id_;
+};
+
+struct LogField
+{
+  enum class Type : quint8
+  {
+    Int,
+    UInt,
+    Double,
+    Bool,
+    String
+  };
+
+  union Scalar
+  {
+    qint64 i;
+    quint64 u;
+    double d;
+    bool b;
+  };
+
+  quint32 key{0};
+  Type type{Type::Int};
+  Scalar scalar{};
+  QByteArray text;
+};
+
+// Structured log entry submitted to LogManager when it goes out of scope. Numeric fields stay binary until the
+// worker encodes them.
+class LogRecord
+{
+public:
+  LogRecord(QtMsgType level, const char *file, int line, const char *function);
+  ~LogRecord();
+
+  LogRecord(const LogRecord &) = delete;
+  LogRecord &operator=(const LogRecord &) = delete;
+
+  bool isActive() const;
+
+  LogRecord &message(const QString &text);
+  LogRecord &message(const char *text);
+
+  template <typename T>
+  LogRecord &field(const LogKey &key, const T &value);
+
+  template <typename T>
+  LogRecord &field(const char *key, const T &value)
+  {
+    return active_ ? field(LogKey::cached(key), value) : *this;
+  }
+
+private:
+  friend class LogManager;
+
+  QtMsgType level_;
+  const char *file_;
+  int line_;
+  const char *function_;
+  qint64 timestamp_ms_{0};
+  quint32 sample_rate_{1};
+  bool active_{false};
+  QByteArray message_;
+  std::vector<LogField> fields_;
+};
+
+template <typename T>
+LogRecord &LogRecord::field(const LogKey &key, const T &value)
+{
+  if (!active_)
+  {
+    return *this;
+  }
+
+  LogField field;
+  field.key = key.id();
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    field.type = LogField::Type::Bool;
+    field.scalar.b = value;
+  }
+  else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+  {
+    field.type = LogField::Type::Int;
+    field.scalar.i = static_cast<qint64>(value);
+  }
+  else if constexpr (std::is_integral_v<T>)
+  {
+    field.type = LogField::Type::UInt;
+    field.scalar.u = static_cast<quint64>(value);
+  }
+  else if constexpr (std::is_floating_point_v<T>)
+  {
+    field.type = LogField::Type::Double;
+    field.scalar.d = static_cast<double>(value);
+  }
+  else if constexpr (std::is_same_v<T, QByteArray>)
+  {
+    field.type = LogField::Type::String;
+    field.text = value;
+  }
+  else if constexpr (std::is_convertible_v<const T &, const char *>)
+  {
+    field.type = LogField::Type::String;
+    field.text = QByteArray(static_cast<const char *>(value));
+  }
+  else
+  {
+    static_assert(std::is_convertible_v<const T &, QString>, "unsupported log field type");
+    field.type = LogField::Type::String;
+    field.text = QString(value).toUtf8();
+  }
+  fields_.push_back(std::move(field));
+  return *this;
+}
+
+} // namespace QtUtils
+
+#define QTUTILS_LOG(level) QtUtils::LogRecord(level, QT_MESSAGELOG_FILE, QT_MESSAGELOG_LINE, QT_MESSAGELOG_FUNC)
@@ -0,0 +1,284 @@
+#include "qtutils/config_cache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+#include <cstring>
+
+namespace QtUtils
+{
+
+namespace
+{
+
+struct CacheHeader
+{
+  char magic[4];
+  quint32 version;
+  quint32 entry_count;
+  quint32 entry_size;
+  quint32 stream_version;
+  quint32 reserved;
+  qint64 ini_size;
+  qint64 ini_mtime_ms;
+  quint64 ini_hash;
+  quint64 data_size;
+};
+
+// Offsets are relative to the data blob that follows the entry table; keys and strings are raw UTF-16.
+struct CacheEntry
+{
+  quint32 key_offset;
+  quint32 key_bytes;
+  quint32 value_offset;
+  quint32 value_bytes;
+  quint32 type;
+  quint32 reserved;
+};
+
+enum ValueType : quint32
+{
+  kInvalid = 0,
+  kString = 1,
+  // Anything else QSettings returns (string lists, @Variant values), stored with QDataStream.
+  kVariant = 2,
+};
+
+constexpr char kCacheMagic[4] = {'Q', 'C', 'F', 'C'};
+constexpr quint32 kCacheVersion = 1;
+
+static_assert(sizeof(CacheHeader) == 56, "unexpected cache header layout");
+static_assert(sizeof(CacheEntry) == 24, "unexpected cache entry layout");
+
+// FNV-1a; qHash is seeded per process and cannot be stored.
+quint64 hashBytes(const uchar *data, qint64 size)
+{
+  quint64 hash = 14695981039346656037ULL;
+  for (qint64 i = 0; i < size; ++i)
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+int streamVersion()
+{
+  return QDataStream().version();
+}
+
+bool readHeader(QFile &file, CacheHeader &header)
+{
+  return file.read(reinterpret_cast<char *>(&header), sizeof(header)) == static_cast<qint64>(sizeof(header)) &&
+         std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0 && header.version == kCacheVersion &&
+         header.entry_size == sizeof(CacheEntry) && header.stream_version == static_cast<quint32>(streamVersion());
+}
+
+bool sameStamp(const CacheHeader &header, const ConfigCache::Stamp &stamp)
+{
+  return header.ini_size == stamp.size && header.ini_mtime_ms == stamp.mtime_ms && header.ini_hash == stamp.hash;
+}
+
+} // namespace
+
+QString ConfigCache::cachePathFor(const QString &ini_file)
+{
+  return ini_file + QStringLiteral(".cache");
+}
+
+bool ConfigCache::stampOf(const QString &ini_file, Stamp &stamp)
+{
+  QFile file(ini_file);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  stamp.size = file.size();
+  stamp.mtime_ms = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+  if (stamp.size == 0)
+  {
+    stamp.hash = hashBytes(nullptr, 0);
+    return true;
+  }
+  const uchar *data = file.map(0, stamp.size);
+  if (data == nullptr)
+  {
+    return false;
+  }
+  stamp.hash = hashBytes(data, stamp.size);
+  return true;
+}
+
+bool ConfigCache::read(const QString &ini_file, QHash<QString, QVariant> &values)
+{
+  values.clear();
+
+  QFile file(cachePathFor(ini_file));
+  CacheHeader header{};
+  Stamp stamp{};
+  if (!file.open(QIODevice::ReadOnly) || !readHeader(file, header) || !stampOf(ini_file, stamp) ||
+      !sameStamp(header, stamp))
+  {
+    return false;
+  }
+
+  const quint64 table_bytes = static_cast<quint64>(header.entry_count) * sizeof(CacheEntry);
+  if (static_cast<quint64>(file.size()) != sizeof(CacheHeader) + table_bytes + header.data_size)
+  {
+    return false;
+  }
+  const uchar *data = file.map(0, file.size());
+  if (data == nullptr)
+  {
+    return false;
+  }
+
+  // The map is page aligned and the header and entries are multiples of 8 bytes, so the table can be used in
+  // place; the writer pads the blob so UTF-16 data starts on even offsets.
+  const auto *entries = reinterpret_cast<const CacheEntry *>(data + sizeof(CacheHeader));
+  const uchar *blob = data + sizeof(CacheHeader) + table_bytes;
+  auto inBlob = [&header](quint32 offset, quint32 bytes)
+  {
+    return static_cast<quint64>(offset) + bytes <= header.data_size;
+  };
+  auto text = [blob](quint32 offset, quint32 bytes)
+  {
+    return QString(reinterpret_cast<const QChar *>(blob + offset), static_cast<int>(bytes / sizeof(QChar)));
+  };
+
+  values.reserve(static_cast<int>(header.entry_count));
+  for (quint32 i = 0; i < header.entry_count; ++i)
+  {
+    const CacheEntry &entry = entries[i];
+    if (!inBlob(entry.key_offset, entry.key_bytes) || !inBlob(entry.value_offset, entry.value_bytes))
+    {
+      values.clear();
+      return false;
+    }
+
+    QVariant value;
+    if (entry.type == kString)
+    {
+      value = text(entry.value_offset, entry.value_bytes);
+    }
+    else if (entry.type == kVariant)
+    {
+      const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(blob + entry.value_offset),
+                                                       static_cast<int>(entry.value_bytes));
+      QDataStream in(bytes);
+      in >> value;
+      if (in.status() != QDataStream::Ok)
+      {
+        values.clear();
+        return false;
+      }
+    }
+    else if (entry.type != kInvalid)
+    {
+      values.clear();
+      return false;
+    }
+    values.insert(text(entry.key_offset, entry.key_bytes), value);
+  }
+  return true;
+}
+
+bool ConfigCache::isFresh(const QString &ini_file, const Stamp &stamp)
+{
+  QFile file(cachePathFor(ini_file));
+  CacheHeader header{};
+  return file.open(QIODevice::ReadOnly) && readHeader(file, header) && sameStamp(header, stamp);
+}
+
+bool ConfigCache::write(const QString &ini_file, const Stamp &stamp, const QHash<QString, QVariant> &values)
+{
+  QStringList keys = values.keys();
+  keys.sort();
+
+  QVector<CacheEntry> entries;
+  entries.reserve(keys.size());
+  QByteArray blob;
+  auto append = [&blob](const void *bytes, int size)
+  {
+    const quint32 offset = static_cast<quint32>(blob.size());
+    blob.append(static_cast<const char *>(bytes), size);
+    if (blob.size() % 2 != 0)
+    {
+      blob.append('\0');
+    }
+    return offset;
+  };
+
+  for (const QString &key : keys)
+  {
+    CacheEntry entry{};
+    entry.key_bytes = static_cast<quint32>(key.size() * sizeof(QChar));
+    entry.key_offset = append(key.constData(), static_cast<int>(entry.key_bytes));
+
+    const QVariant value = values.value(key);
+    if (!value.isValid())
+    {
+      entry.type = kInvalid;
+    }
+    else if (value.userType() == QMetaType::QString)
+    {
+      const QString string = value.toString();
+      entry.type = kString;
+      entry.value_bytes = static_cast<quint32>(string.size() * sizeof(QChar));
+      entry.value_offset = append(string.constData(), static_cast<int>(entry.value_bytes));
+    }
+    else
+    {
+      QByteArray bytes;
+      QDataStream out(&bytes, QIODevice::WriteOnly);
+      out << value;
+      if (out.status() != QDataStream::Ok)
+      {
+        return false;
+      }
+      entry.type = kVariant;
+      entry.value_bytes = static_cast<quint32>(bytes.size());
+      entry.value_offset = append(bytes.constData(), bytes.size());
+    }
+    entries.append(entry);
+  }
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.entry_count = static_cast<quint32>(entries.size());
+  header.entry_size = sizeof(CacheEntry);
+  header.stream_version = static_cast<quint32>(streamVersion());
+  header.ini_size = stamp.size;
+  header.ini_mtime_ms = stamp.mtime_ms;
+  header.ini_hash = stamp.hash;
+  header.data_size = static_cast<quint64>(blob.size());
+
+  // The values may predate a concurrent write to the INI; a cache that claimed them for the new file would be wrong.
+  Stamp current{};
+  if (!stampOf(ini_file, current) || !(current == stamp))
+  {
+    return false;
+  }
+
+  QSaveFile file(cachePathFor(ini_file));
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  const qint64 table_bytes = static_cast<qint64>(entries.size()) * static_cast<qint64>(sizeof(CacheEntry));
+  if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)) ||
+      file.write(reinterpret_cast<const char *>(entries.constData()), table_bytes) != table_bytes ||
+      file.write(blob) != blob.size())
+  {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+} // namespace QtUtils
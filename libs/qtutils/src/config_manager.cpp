@@ -1,5 +1,12 @@
 #include "qtutils/config_manager.h"
 #include "qtutils/common_utils.h"
+#include "qtutils/config_cache.h"
+#include "qtutils/config_shm.h"
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
 
 namespace QtUtils
 {
@@ -16,79 +23,269 @@ ConfigManager::ConfigManager()
   if (config_dir_path.isEmpty())
   {
     qWarning("Cannot create config directory");
+    rebuildSnapshot();
     return;
   }
 
-  QString config_file = config_dir_path + QDir::separator() + QStringLiteral("config.ini");
-  settings_.reset(new QSettings(config_file, QSettings::IniFormat));
+  config_file_path_ = config_dir_path + QDir::separator() + QStringLiteral("config.ini");
+  qDebug("Config file: %s", qPrintable(config_file_path_));
 
-  qDebug("Config file: %s", qPrintable(settings_->fileName()));
-}
-
-void ConfigManager::registerDefaults(const QMap<QString, QVariant> &defaults)
-{
-  for (auto it = defaults.constBegin(); it != defaults.constEnd(); ++it)
+  // A fresh cache spares the INI parse; settings_ is then only created by the first write.
+  QHash<QString, QVariant> values;
+  if (ConfigCache::read(config_file_path_, values))
   {
-    if (!defaults_.contains(it.key()))
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->reserve(values.size());
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it)
     {
-      defaults_.insert(it.key(), it.value());
-      if (!settings_.isNull() && !settings_->contains(it.key()))
-      {
-        settings_->setValue(it.key(), it.value());
-      }
+      snapshot->insert(it.key(), Entry{it.value(), false});
     }
+    publish(std::move(snapshot));
+    return;
+  }
+
+  ConfigCache::Stamp stamp{};
+  const bool has_file = ConfigCache::stampOf(config_file_path_, stamp);
+  ensureSettings();
+  rebuildSnapshot();
+  if (has_file)
+  {
+    ConfigCache::write(config_file_path_, stamp, fileValues(*std::atomic_load(&snapshot_)));
   }
+}
+
+ConfigManager::~ConfigManager()
+{
+  stopWatching();
+  setWriteBehind(0);
+  updateCache();
+}
+
+bool ConfigManager::ensureSettings()
+{
   if (!settings_.isNull())
   {
-    settings_->sync();
+    return true;
   }
+  if (config_file_path_.isEmpty())
+  {
+    return false;
+  }
+  settings_.reset(new QSettings(config_file_path_, QSettings::IniFormat));
+  // sync() then writes a temporary file, flushes it to disk and renames it over config.ini.
+  settings_->setAtomicSyncRequired(true);
+  return true;
 }
 
-QVariant ConfigManager::value(const QString &key, const QVariant &default_value) const
+QHash<QString, QVariant> ConfigManager::fileValues(const Snapshot &snapshot)
 {
-  if (!settings_.isNull() && settings_->contains(key))
+  QHash<QString, QVariant> values;
+  values.reserve(snapshot.size());
+  for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it)
   {
-    return settings_->value(key);
+    if (!it->is_default)
+    {
+      values.insert(it.key(), it->value);
+    }
   }
+  return values;
+}
 
-  if (default_value.isValid())
+void ConfigManager::updateCache() const
+{
+  ConfigCache::Stamp stamp{};
+  if (config_file_path_.isEmpty() || !ConfigCache::stampOf(config_file_path_, stamp) ||
+      ConfigCache::isFresh(config_file_path_, stamp))
   {
-    return default_value;
+    return;
   }
 
-  auto it = defaults_.find(key);
-  if (it != defaults_.end())
+  // settings_ keeps values written by this process as they were set, not as they read back from the file, so the
+  // cache is built from a fresh parse.
+  QSettings settings(config_file_path_, QSettings::IniFormat);
+  QHash<QString, QVariant> values;
+  for (const QString &key : settings.allKeys())
   {
-    return it.value();
+    values.insert(key, settings.value(key));
   }
+  ConfigCache::write(config_file_path_, stamp, values);
+}
+
+void ConfigManager::registerDefaults(const QMap<QString, QVariant> &defaults)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::shared_ptr<const Snapshot> current = std::atomic_load(&snapshot_);
+    auto inFile = [this, &current](const QString &key)
+    {
+      if (!settings_.isNull())
+      {
+        return settings_->contains(key);
+      }
+      auto it = current->constFind(key);
+      return it != current->constEnd() && !it->is_default;
+    };
 
-  return QVariant();
+    bool written = false;
+    for (auto it = defaults.constBegin(); it != defaults.constEnd(); ++it)
+    {
+      if (!defaults_.contains(it.key()))
+      {
+        defaults_.insert(it.key(), it.value());
+        if (!inFile(it.key()) && ensureSettings())
+        {
+          settings_->setValue(it.key(), it.value());
+          written = true;
+        }
+      }
+    }
+    if (written && !deferWrite())
+    {
+      settings_->sync();
+    }
+    rebuildSnapshot();
+  }
+  notifySubscribers();
+}
+
+QVariant ConfigManager::value(const QString &key, const QVariant &default_value) const
+{
+  const Snapshot &values = snapshot();
+  auto it = values.constFind(key);
+  if (it == values.constEnd() || (it->is_default && default_value.isValid()))
+  {
+    return default_value;
+  }
+  return it->value;
 }
 
 void ConfigManager::setValue(const QString &key, const QVariant &value)
 {
-  if (!settings_.isNull())
   {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureSettings())
+    {
+      return;
+    }
     settings_->setValue(key, value);
+    deferWrite();
+
+    auto snapshot = std::make_shared<Snapshot>(*std::atomic_load(&snapshot_));
+    snapshot->insert(key, Entry{value, false});
+    publish(std::move(snapshot));
   }
+  notifySubscribers();
 }
 
 void ConfigManager::remove(const QString &key)
 {
-  if (!settings_.isNull())
   {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureSettings())
+    {
+      return;
+    }
+    // Removing a group removes all keys below it, so the snapshot is rebuilt rather than patched.
     settings_->remove(key);
+    deferWrite();
+    rebuildSnapshot();
   }
+  notifySubscribers();
 }
 
 bool ConfigManager::save()
 {
+  std::lock_guard<std::mutex> lock(mutex_);
   if (settings_.isNull())
   {
-    return false;
+    // Nothing has been written yet.
+    return !config_file_path_.isEmpty();
   }
-  settings_->sync();
-  return settings_->status() == QSettings::NoError;
+  return syncLocked();
+}
+
+ConfigManager::Transaction ConfigManager::begin()
+{
+  return Transaction(*this);
+}
+
+ConfigManager::Transaction::Transaction(ConfigManager &manager) : manager_(&manager)
+{
+}
+
+void ConfigManager::Transaction::set(const QString &key, const QVariant &value)
+{
+  changes_.push_back({key, value, false});
+}
+
+void ConfigManager::Transaction::remove(const QString &key)
+{
+  changes_.push_back({key, QVariant(), true});
+}
+
+bool ConfigManager::Transaction::commit()
+{
+  std::vector<Change> changes;
+  changes.swap(changes_);
+  return changes.empty() || manager_->apply(changes);
+}
+
+bool ConfigManager::apply(const std::vector<Transaction::Change> &changes)
+{
+  bool ok = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureSettings())
+    {
+      return false;
+    }
+    bool removed = false;
+    for (const Transaction::Change &change : changes)
+    {
+      if (change.remove)
+      {
+        settings_->remove(change.key);
+        removed = true;
+      }
+      else
+      {
+        settings_->setValue(change.key, change.value);
+      }
+    }
+
+    if (removed)
+    {
+      rebuildSnapshot();
+    }
+    else
+    {
+      auto snapshot = std::make_shared<Snapshot>(*std::atomic_load(&snapshot_));
+      for (const Transaction::Change &change : changes)
+      {
+        snapshot->insert(change.key, Entry{change.value, false});
+      }
+      publish(std::move(snapshot));
+    }
+    ok = deferWrite() || syncLocked();
+  }
+  notifySubscribers();
+  return ok;
+}
+
+bool ConfigManager::reload()
+{
+  bool ok = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureSettings())
+    {
+      return false;
+    }
+    ok = syncLocked();
+    rebuildSnapshot();
+  }
+  notifySubscribers();
+  return ok;
 }
 
 QString ConfigManager::stringValue(const QString &key, const QString &default_value) const
@@ -129,7 +326,624 @@ bool ConfigManager::boolValue(const QString &key, bool default_value) const
 
 QString ConfigManager::configFilePath() const
 {
-  return !settings_.isNull() ? settings_->fileName() : QString();
+  return config_file_path_;
+}
+
+ConfigManager::Group ConfigManager::group(const QString &prefix) const
+{
+  return Group(keyIndex(), prefix);
+}
+
+QVariantList ConfigManager::values(const QStringList &keys) const
+{
+  const Snapshot &values = snapshot();
+  QVariantList result;
+  result.reserve(keys.size());
+  for (const QString &key : keys)
+  {
+    auto it = values.constFind(key);
+    result.append(it != values.constEnd() ? it->value : QVariant());
+  }
+  return result;
+}
+
+std::shared_ptr<const ConfigManager::KeyIndex> ConfigManager::keyIndex() const
+{
+  checkShared();
+  // Read before the snapshot, which is then at least this new; at worst the index is rebuilt once more.
+  const quint64 version = version_.load(std::memory_order_acquire);
+  std::shared_ptr<const KeyIndex> index = std::atomic_load(&key_index_);
+  if (index != nullptr && index->version == version)
+  {
+    return index;
+  }
+
+  auto built = std::make_shared<KeyIndex>();
+  built->version = version;
+  built->snapshot = std::atomic_load(&snapshot_);
+  built->entries.reserve(static_cast<size_t>(built->snapshot->size()));
+  for (auto it = built->snapshot->constBegin(); it != built->snapshot->constEnd(); ++it)
+  {
+    built->entries.emplace_back(it.key(), &it.value());
+  }
+  std::sort(built->entries.begin(),
+            built->entries.end(),
+            [](const std::pair<QString, const Entry *> &a, const std::pair<QString, const Entry *> &b)
+            {
+              return a.first < b.first;
+            });
+  index = std::move(built);
+  std::atomic_store(&key_index_, index);
+  return index;
+}
+
+ConfigManager::Group::Group(std::shared_ptr<const KeyIndex> index, const QString &prefix)
+    : index_(std::move(index)), prefix_(prefix)
+{
+  // Keys sharing a prefix are contiguous in sorted order.
+  const auto &entries = index_->entries;
+  auto first = std::lower_bound(entries.cbegin(),
+                                entries.cend(),
+                                prefix_,
+                                [](const std::pair<QString, const Entry *> &entry, const QString &key)
+                                {
+                                  return entry.first < key;
+                                });
+  auto last = std::partition_point(first,
+                                   entries.cend(),
+                                   [this](const std::pair<QString, const Entry *> &entry)
+                                   {
+                                     return entry.first.startsWith(prefix_);
+                                   });
+  begin_ = static_cast<size_t>(first - entries.cbegin());
+  end_ = static_cast<size_t>(last - entries.cbegin());
+}
+
+QStringList ConfigManager::Group::keys() const
+{
+  QStringList keys;
+  keys.reserve(size());
+  for (size_t i = begin_; i < end_; ++i)
+  {
+    keys.append(index_->entries[i].first.mid(prefix_.size()));
+  }
+  return keys;
+}
+
+QStringList ConfigManager::Group::childGroups() const
+{
+  QStringList groups;
+  for (size_t i = begin_; i < end_; ++i)
+  {
+    const QString &key = index_->entries[i].first;
+    const int slash = key.indexOf('/', prefix_.size());
+    if (slash <= prefix_.size())
+    {
+      continue;
+    }
+    const QString name = key.mid(prefix_.size(), slash - prefix_.size());
+    if (groups.isEmpty() || groups.constLast() != name)
+    {
+      groups.append(name);
+    }
+  }
+  return groups;
+}
+
+bool ConfigManager::Group::contains(const QString &key) const
+{
+  return index_->snapshot->contains(prefix_ + key);
+}
+
+QVariant ConfigManager::Group::value(const QString &key, const QVariant &default_value) const
+{
+  auto it = index_->snapshot->constFind(prefix_ + key);
+  if (it == index_->snapshot->constEnd() || (it->is_default && default_value.isValid()))
+  {
+    return default_value;
+  }
+  return it->value;
+}
+
+ConfigManager::Group ConfigManager::Group::group(const QString &prefix) const
+{
+  return Group(index_, prefix_ + prefix);
+}
+
+void ConfigManager::Group::forEach(const std::function<void(const QString &key, const QVariant &value)> &visit) const
+{
+  for (size_t i = begin_; i < end_; ++i)
+  {
+    const auto &entry = index_->entries[i];
+    visit(entry.first.mid(prefix_.size()), entry.second->value);
+  }
+}
+
+const ConfigManager::Snapshot &ConfigManager::snapshot() const
+{
+  thread_local quint64 cached_version = 0;
+  thread_local std::shared_ptr<const Snapshot> cached;
+
+  checkShared();
+
+  // publish() stores the snapshot before bumping the version, so a new version always finds a snapshot at least
+  // that new.
+  const quint64 version = version_.load(std::memory_order_acquire);
+  if (version != cached_version)
+  {
+    cached = std::atomic_load(&snapshot_);
+    cached_version = version;
+  }
+  return *cached;
+}
+
+void ConfigManager::rebuildSnapshot()
+{
+  if (shared_ != nullptr && !shared_->isWriter() && shared_->isRetired() && !followReplacement())
+  {
+    // shared_seen_ is left behind, so reads keep checking until a writer brings the name back.
+    return;
+  }
+
+  auto snapshot = std::make_shared<Snapshot>();
+  for (auto it = defaults_.constBegin(); it != defaults_.constEnd(); ++it)
+  {
+    snapshot->insert(it.key(), Entry{it.value(), true});
+  }
+  if (shared_ != nullptr && !shared_->isWriter())
+  {
+    std::vector<ConfigShm::Item> items;
+    quint64 sequence = 0;
+    if (!shared_->read(items, sequence))
+    {
+      // Not retried until the next change; a reader only fails this way against a writer that never pauses.
+      qWarning("Cannot read shared config: %s", qPrintable(shared_->errorString()));
+      shared_seen_.store(shared_->sequence()->load(std::memory_order_acquire), std::memory_order_release);
+      return;
+    }
+    for (ConfigShm::Item &item : items)
+    {
+      snapshot->insert(item.key, Entry{std::move(item.value), item.is_default});
+    }
+    shared_seen_.store(sequence, std::memory_order_release);
+  }
+  else if (!settings_.isNull())
+  {
+    for (const QString &key : settings_->allKeys())
+    {
+      snapshot->insert(key, Entry{settings_->value(key), false});
+    }
+  }
+  else if (const std::shared_ptr<const Snapshot> current = std::atomic_load(&snapshot_))
+  {
+    // Values loaded from the cache stand in for the settings file until it is parsed.
+    for (auto it = current->constBegin(); it != current->constEnd(); ++it)
+    {
+      if (!it->is_default)
+      {
+        snapshot->insert(it.key(), it.value());
+      }
+    }
+  }
+  publish(std::move(snapshot));
+}
+
+void ConfigManager::publish(std::shared_ptr<const Snapshot> snapshot)
+{
+  const std::shared_ptr<const Snapshot> previous = std::atomic_exchange(&snapshot_, snapshot);
+  version_.fetch_add(1, std::memory_order_release);
+
+  if (shared_ != nullptr && shared_->isWriter())
+  {
+    shareSnapshot(*snapshot);
+  }
+
+  // After the version, so a handle that sees the new generation also finds the new snapshot.
+  for (KeySlot &slot : key_slots_)
+  {
+    auto find = [&slot](const Snapshot *values) -> const Entry *
+    {
+      if (values == nullptr)
+      {
+        return nullptr;
+      }
+      auto it = values->constFind(slot.key);
+      return it != values->constEnd() ? &it.value() : nullptr;
+    };
+    const Entry *before = find(previous.get());
+    const Entry *after = find(snapshot.get());
+    if ((before == nullptr) != (after == nullptr) || (before != nullptr && !(*before == *after)))
+    {
+      slot.generation.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  if (subscriptions_.empty())
+  {
+    return;
+  }
+  const QStringList changed = changedKeys(previous.get(), *snapshot);
+  if (changed.isEmpty())
+  {
+    return;
+  }
+  for (const std::shared_ptr<const Subscription> &subscription : subscriptions_)
+  {
+    QStringList matched;
+    for (const QString &key : changed)
+    {
+      const bool wanted = subscription->keys.isEmpty() ||
+                          std::any_of(subscription->keys.cbegin(),
+                                      subscription->keys.cend(),
+                                      [&key](const QString &wanted_key)
+                                      {
+                                        return wanted_key.endsWith('/') ? key.startsWith(wanted_key)
+                                                                        : key == wanted_key;
+                                      });
+      if (wanted)
+      {
+        matched.append(key);
+      }
+    }
+    if (!matched.isEmpty())
+    {
+      pending_notifications_.push_back({subscription, matched});
+    }
+  }
+}
+
+QStringList ConfigManager::changedKeys(const Snapshot *before, const Snapshot &after)
+{
+  QStringList changed;
+  for (auto it = after.constBegin(); it != after.constEnd(); ++it)
+  {
+    auto old = before != nullptr ? before->constFind(it.key()) : after.constEnd();
+    if (before == nullptr || old == before->constEnd() || !(old.value() == it.value()))
+    {
+      changed.append(it.key());
+    }
+  }
+  if (before != nullptr)
+  {
+    for (auto it = before->constBegin(); it != before->constEnd(); ++it)
+    {
+      if (!after.contains(it.key()))
+      {
+        changed.append(it.key());
+      }
+    }
+  }
+  changed.sort();
+  return changed;
+}
+
+void ConfigManager::notifySubscribers()
+{
+  std::vector<Notification> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending.swap(pending_notifications_);
+  }
+  for (const Notification &notification : pending)
+  {
+    const Subscription &subscription = *notification.subscription;
+    std::lock_guard<std::recursive_mutex> call_lock(subscription.call_mutex);
+    if (subscription.active)
+    {
+      subscription.callback(notification.keys);
+    }
+  }
+}
+
+int ConfigManager::subscribe(const QStringList &keys, ChangeCallback callback)
+{
+  auto subscription = std::make_shared<Subscription>();
+  subscription->keys = keys;
+  subscription->callback = std::move(callback);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  subscription->id = next_subscription_id_++;
+  subscriptions_.push_back(std::move(subscription));
+  return subscriptions_.back()->id;
+}
+
+void ConfigManager::unsubscribe(int id)
+{
+  std::shared_ptr<const Subscription> removed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(subscriptions_.begin(),
+                           subscriptions_.end(),
+                           [id](const std::shared_ptr<const Subscription> &subscription)
+                           {
+                             return subscription->id == id;
+                           });
+    if (it == subscriptions_.end())
+    {
+      return;
+    }
+    removed = std::move(*it);
+    subscriptions_.erase(it);
+  }
+
+  // Notifications already handed out still hold the subscription; this waits for one that is running.
+  std::lock_guard<std::recursive_mutex> call_lock(removed->call_mutex);
+  removed->active = false;
+}
+
+bool ConfigManager::startWatching(int debounce_ms)
+{
+  std::lock_guard<std::mutex> lock(watch_mutex_);
+  if (watch_thread_ != nullptr)
+  {
+    return true;
+  }
+  const QString path = configFilePath();
+  if (path.isEmpty())
+  {
+    return false;
+  }
+
+  // Editors and atomic writers replace the file, which drops it from the watch list; the directory watch sees
+  // the replacement and the file is re-added on the next reload.
+  auto *watcher = new QFileSystemWatcher();
+  watcher->addPath(QFileInfo(path).absolutePath());
+  if (QFileInfo::exists(path))
+  {
+    watcher->addPath(path);
+  }
+  auto *debounce = new QTimer();
+  debounce->setSingleShot(true);
+  debounce->setInterval(std::max(0, debounce_ms));
+
+  QObject::connect(watcher, &QFileSystemWatcher::fileChanged, debounce, qOverload<>(&QTimer::start));
+  QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, debounce, qOverload<>(&QTimer::start));
+  QObject::connect(debounce,
+                   &QTimer::timeout,
+                   watcher,
+                   [this, watcher, path]()
+                   {
+                     if (!watcher->files().contains(path) && QFileInfo::exists(path))
+                     {
+                       watcher->addPath(path);
+                     }
+                     reload();
+                   });
+
+  watch_thread_ = new QThread();
+  watch_thread_->setObjectName(QStringLiteral("ConfigWatcher"));
+  watcher->moveToThread(watch_thread_);
+  debounce->moveToThread(watch_thread_);
+  QObject::connect(watch_thread_, &QThread::finished, watcher, &QObject::deleteLater);
+  QObject::connect(watch_thread_, &QThread::finished, debounce, &QObject::deleteLater);
+  watch_thread_->start();
+  return true;
+}
+
+void ConfigManager::stopWatching()
+{
+  std::lock_guard<std::mutex> lock(watch_mutex_);
+  if (watch_thread_ == nullptr)
+  {
+    return;
+  }
+  watch_thread_->quit();
+  watch_thread_->wait();
+  delete watch_thread_;
+  watch_thread_ = nullptr;
+}
+
+bool ConfigManager::isWatching() const
+{
+  std::lock_guard<std::mutex> lock(watch_mutex_);
+  return watch_thread_ != nullptr;
+}
+
+void ConfigManager::setWriteBehind(int quiet_ms)
+{
+  quiet_ms = std::max(0, quiet_ms);
+  QThread *stopped = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(persist_mutex_);
+    write_behind_ms_ = quiet_ms;
+    if (quiet_ms > 0 && persist_thread_ == nullptr && !config_file_path_.isEmpty())
+    {
+      persist_thread_ = QThread::create(
+          [this]()
+          {
+            persistLoop();
+          });
+      persist_thread_->setObjectName(QStringLiteral("ConfigWriter"));
+      persist_thread_->start();
+    }
+    else if (quiet_ms == 0)
+    {
+      std::swap(stopped, persist_thread_);
+    }
+    persist_cond_.notify_all();
+  }
+
+  if (stopped != nullptr)
+  {
+    stopped->wait();
+    delete stopped;
+    save();
+  }
+}
+
+int ConfigManager::writeBehind() const
+{
+  std::lock_guard<std::mutex> lock(persist_mutex_);
+  return write_behind_ms_;
+}
+
+bool ConfigManager::deferWrite()
+{
+  std::lock_guard<std::mutex> lock(persist_mutex_);
+  if (persist_thread_ == nullptr)
+  {
+    return false;
+  }
+  last_change_ = std::chrono::steady_clock::now();
+  // While dirty the writer is already waiting for a deadline and re-reads last_change_ when it expires.
+  if (!dirty_)
+  {
+    dirty_ = true;
+    persist_cond_.notify_one();
+  }
+  return true;
+}
+
+bool ConfigManager::syncLocked()
+{
+  settings_->sync();
+  {
+    std::lock_guard<std::mutex> lock(persist_mutex_);
+    dirty_ = false;
+  }
+  return settings_->status() == QSettings::NoError;
+}
+
+void ConfigManager::persistLoop()
+{
+  std::unique_lock<std::mutex> lock(persist_mutex_);
+  // setWriteBehind(0) clears persist_thread_, which ends the loop; a writer started after it is a new thread.
+  while (persist_thread_ == QThread::currentThread())
+  {
+    if (!dirty_)
+    {
+      persist_cond_.wait(lock);
+      continue;
+    }
+    // Every change pushes the deadline back, so a burst of changes is written once it is over.
+    const auto due = last_change_ + std::chrono::milliseconds(write_behind_ms_);
+    if (std::chrono::steady_clock::now() < due)
+    {
+      persist_cond_.wait_until(lock, due);
+      continue;
+    }
+
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> settings_lock(mutex_);
+      if (!syncLocked())
+      {
+        qWarning("Failed to write config file: %s", qPrintable(settings_->fileName()));
+      }
+    }
+    updateCache();
+    lock.lock();
+  }
+}
+
+bool ConfigManager::shareConfig(const QString &name, qint64 capacity)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (shared_ != nullptr)
+  {
+    return shared_->isWriter();
+  }
+  auto shared = std::make_unique<ConfigShm>();
+  if (!shared->create(name.isEmpty() ? ConfigShm::nameFor(config_file_path_) : name, capacity))
+  {
+    qWarning("Cannot share config: %s", qPrintable(shared->errorString()));
+    return false;
+  }
+  shared_ = std::move(shared);
+  return shareSnapshot(*std::atomic_load(&snapshot_));
+}
+
+bool ConfigManager::followSharedConfig(const QString &name)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shared_ != nullptr)
+    {
+      return !shared_->isWriter();
+    }
+    auto shared = std::make_unique<ConfigShm>();
+    if (!shared->open(name.isEmpty() ? ConfigShm::nameFor(config_file_path_) : name))
+    {
+      qWarning("Cannot follow shared config: %s", qPrintable(shared->errorString()));
+      return false;
+    }
+    shared_ = std::move(shared);
+    rebuildSnapshot();
+    shared_sequence_.store(shared_->sequence(), std::memory_order_release);
+  }
+  notifySubscribers();
+  return true;
+}
+
+bool ConfigManager::shareSnapshot(const Snapshot &snapshot)
+{
+  std::vector<ConfigShm::Item> items;
+  items.reserve(static_cast<size_t>(snapshot.size()));
+  for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it)
+  {
+    items.push_back({it.key(), it->value, it->is_default});
+  }
+  if (!shared_->write(items))
+  {
+    qWarning("Cannot update shared config: %s", qPrintable(shared_->errorString()));
+    return false;
+  }
+  return true;
+}
+
+bool ConfigManager::followReplacement()
+{
+  // Attempts are spaced out: until a new writer creates the segment every read comes through here.
+  const auto now = std::chrono::steady_clock::now();
+  if (now < shared_retry_at_)
+  {
+    return false;
+  }
+  shared_retry_at_ = now + std::chrono::seconds(1);
+
+  auto next = std::make_unique<ConfigShm>();
+  if (!next->open(shared_->name()) || next->isRetired())
+  {
+    if (!shared_retired_warned_)
+    {
+      qWarning("Shared config %s was removed, keeping its last values until it is shared again",
+               qPrintable(shared_->name()));
+      shared_retired_warned_ = true;
+    }
+    return false;
+  }
+  // Lock-free readers may still hold the old sequence pointer, so the old mapping lives on.
+  retired_shared_.push_back(std::move(shared_));
+  shared_ = std::move(next);
+  shared_sequence_.store(shared_->sequence(), std::memory_order_release);
+  shared_retired_warned_ = false;
+  return true;
+}
+
+void ConfigManager::refreshShared() const
+{
+  // Reads are const, but catching up with the shared table is a write like any other.
+  auto *self = const_cast<ConfigManager *>(this);
+  {
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    if (shared_->sequence()->load(std::memory_order_acquire) == shared_seen_.load(std::memory_order_acquire))
+    {
+      return;
+    }
+    self->rebuildSnapshot();
+  }
+  self->notifySubscribers();
+}
+
+const ConfigManager::KeySlot *ConfigManager::resolveKey(const QString &key)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  KeySlot *&slot = key_slot_index_[key];
+  if (slot == nullptr)
+  {
+    slot = &key_slots_.emplace_back(key);
+  }
+  return slot;
 }
 
 } // namespace QtUtils
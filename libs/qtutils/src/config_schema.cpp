@@ -0,0 +1,208 @@
+#include "qtutils/config_schema.h"
+#include "qtutils/config_manager.h"
+#include <QLocale>
+#include <QMap>
+#include <QStringList>
+#include <QVariant>
+#include <algorithm>
+#include <limits>
+
+namespace QtUtils
+{
+
+namespace
+{
+
+QVariant defaultValue(const ConfigField &field)
+{
+  switch (field.type)
+  {
+  case ConfigField::Type::Bool:
+    return field.default_bool;
+  case ConfigField::Type::Int:
+    if (field.default_int >= std::numeric_limits<int>::min() && field.default_int <= std::numeric_limits<int>::max())
+    {
+      return static_cast<int>(field.default_int);
+    }
+    return static_cast<qlonglong>(field.default_int);
+  case ConfigField::Type::Double:
+    return field.default_double;
+  case ConfigField::Type::String:
+    return QString::fromUtf8(field.default_string);
+  }
+  return QVariant();
+}
+
+const char *typeName(ConfigField::Type type)
+{
+  switch (type)
+  {
+  case ConfigField::Type::Bool:
+    return "bool";
+  case ConfigField::Type::Int:
+    return "int";
+  case ConfigField::Type::Double:
+    return "double";
+  case ConfigField::Type::String:
+    return "string";
+  }
+  return "";
+}
+
+// An invalid result means the value is fine as it is.
+QVariant repair(const ConfigField &field, const QVariant &value)
+{
+  switch (field.type)
+  {
+  case ConfigField::Type::Bool:
+  {
+    static const QStringList kAccepted = {"true", "false", "1", "0"};
+    if (value.userType() != QMetaType::Bool && !kAccepted.contains(value.toString().trimmed(), Qt::CaseInsensitive))
+    {
+      return defaultValue(field);
+    }
+    return QVariant();
+  }
+  case ConfigField::Type::Int:
+  {
+    bool ok = false;
+    const qlonglong number = value.toLongLong(&ok);
+    if (!ok)
+    {
+      return defaultValue(field);
+    }
+    if (field.has_range && (number < field.min || number > field.max))
+    {
+      return static_cast<qlonglong>(std::clamp(static_cast<double>(number), field.min, field.max));
+    }
+    return QVariant();
+  }
+  case ConfigField::Type::Double:
+  {
+    bool ok = false;
+    const double number = value.toDouble(&ok);
+    if (!ok)
+    {
+      return defaultValue(field);
+    }
+    if (field.has_range && (number < field.min || number > field.max))
+    {
+      return std::clamp(number, field.min, field.max);
+    }
+    return QVariant();
+  }
+  case ConfigField::Type::String:
+    return QVariant();
+  }
+  return QVariant();
+}
+
+// Shortest text that parses back to the same double; the default of 6 significant digits would round.
+QString doubleText(double value)
+{
+  return QString::number(value, 'g', QLocale::FloatingPointShortest);
+}
+
+QString boundText(const ConfigField &field, double bound)
+{
+  return field.type == ConfigField::Type::Int ? QString::number(static_cast<qint64>(bound)) : doubleText(bound);
+}
+
+QString iniValue(const ConfigField &field)
+{
+  switch (field.type)
+  {
+  case ConfigField::Type::Bool:
+    return field.default_bool ? QStringLiteral("true") : QStringLiteral("false");
+  case ConfigField::Type::Int:
+    return QString::number(field.default_int);
+  case ConfigField::Type::Double:
+    return doubleText(field.default_double);
+  case ConfigField::Type::String:
+    break;
+  }
+  // Quoted so commas and surrounding spaces survive QSettings.
+  QString text = QString::fromUtf8(field.default_string);
+  text.replace('\\', QStringLiteral("\\\\")).replace('"', QStringLiteral("\\\""));
+  return QLatin1Char('"') + text + QLatin1Char('"');
+}
+
+} // namespace
+
+void ConfigSchema::registerDefaults(const ConfigField *fields, size_t count)
+{
+  QMap<QString, QVariant> defaults;
+  for (size_t i = 0; i < count; ++i)
+  {
+    defaults.insert(QString::fromUtf8(fields[i].key), defaultValue(fields[i]));
+  }
+  ConfigManager::instance().registerDefaults(defaults);
+}
+
+int ConfigSchema::validate(const ConfigField *fields, size_t count)
+{
+  ConfigManager &config = ConfigManager::instance();
+  auto transaction = config.begin();
+  int replaced = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const ConfigField &field = fields[i];
+    const QString key = QString::fromUtf8(field.key);
+    const QVariant value = config.value(key);
+    if (!value.isValid())
+    {
+      continue;
+    }
+    const QVariant fixed = repair(field, value);
+    if (fixed.isValid())
+    {
+      qWarning("Config %s: \"%s\" is not a valid %s, using %s",
+               field.key,
+               qPrintable(value.toString()),
+               typeName(field.type),
+               qPrintable(fixed.toString()));
+      transaction.set(key, fixed);
+      ++replaced;
+    }
+  }
+  transaction.commit();
+  return replaced;
+}
+
+QString ConfigSchema::dump(const ConfigField *fields, size_t count)
+{
+  // Sections in order of first use, keys in declaration order within each.
+  QStringList groups;
+  QMap<QString, QString> sections;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const ConfigField &field = fields[i];
+    const QString key = QString::fromUtf8(field.key);
+    // QSettings writes "a/b/c" as "b\c" in section [a].
+    const int slash = key.indexOf('/');
+    const QString group = slash > 0 ? key.left(slash) : QStringLiteral("General");
+    if (!groups.contains(group))
+    {
+      groups.append(group);
+    }
+
+    QString &section = sections[group];
+    section += QStringLiteral("; %1\n").arg(QString::fromUtf8(field.doc));
+    section += QStringLiteral("; type: %1").arg(QLatin1String(typeName(field.type)));
+    if (field.has_range)
+    {
+      section += QStringLiteral(", range: %1..%2").arg(boundText(field, field.min), boundText(field, field.max));
+    }
+    section += QStringLiteral("\n%1=%2\n\n").arg(key.mid(slash + 1).replace('/', '\\'), iniValue(field));
+  }
+
+  QString ini;
+  for (const QString &group : groups)
+  {
+    ini += QStringLiteral("[%1]\n").arg(group);
+    ini += sections.value(group);
+  }
+  return ini;
+}
+
+} // namespace QtUtils
@@ -0,0 +1,471 @@
+#include "qtutils/config_shm.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace QtUtils
+{
+
+struct ConfigShm::Header
+{
+  char magic[4];
+  quint32 version;
+  quint64 capacity;
+  std::atomic<quint64> sequence;
+  // Written under the sequence like the payload; atomics only so that racing reads are well defined.
+  std::atomic<quint64> entry_count;
+  std::atomic<quint64> payload_size;
+  // Set by remove(): this segment no longer has a name and will not change again.
+  std::atomic<quint64> retired;
+};
+
+namespace
+{
+
+// Offsets are relative to the blob that follows the entry table; keys and strings are raw UTF-16.
+struct ShmEntry
+{
+  quint32 key_offset;
+  quint32 key_bytes;
+  quint32 value_offset;
+  quint32 value_bytes;
+  quint32 type;
+  quint32 is_default;
+};
+
+enum ValueType : quint32
+{
+  kInvalid = 0,
+  kString = 1,
+  kVariant = 2,
+};
+
+constexpr char kShmMagic[4] = {'Q', 'C', 'F', 'S'};
+constexpr quint32 kShmVersion = 2;
+// A reader gives up after this many torn copies; only a writer publishing without pause gets there.
+constexpr int kMaxReadAttempts = 1000;
+
+static_assert(sizeof(ShmEntry) == 24, "unexpected shared entry layout");
+static_assert(std::atomic<quint64>::is_always_lock_free, "the sequence must be lock-free to work across processes");
+
+QByteArray encode(const std::vector<ConfigShm::Item> &items)
+{
+  std::vector<ShmEntry> entries;
+  entries.reserve(items.size());
+  QByteArray blob;
+  auto append = [&blob](const void *bytes, int size)
+  {
+    const quint32 offset = static_cast<quint32>(blob.size());
+    blob.append(static_cast<const char *>(bytes), size);
+    if (blob.size() % 2 != 0)
+    {
+      blob.append('\0');
+    }
+    return offset;
+  };
+
+  for (const ConfigShm::Item &item : items)
+  {
+    ShmEntry entry{};
+    entry.is_default = item.is_default ? 1 : 0;
+    entry.key_bytes = static_cast<quint32>(item.key.size() * sizeof(QChar));
+    entry.key_offset = append(item.key.constData(), static_cast<int>(entry.key_bytes));
+    if (!item.value.isValid())
+    {
+      entry.type = kInvalid;
+    }
+    else if (item.value.userType() == QMetaType::QString)
+    {
+      const QString string = item.value.toString();
+      entry.type = kString;
+      entry.value_bytes = static_cast<quint32>(string.size() * sizeof(QChar));
+      entry.value_offset = append(string.constData(), static_cast<int>(entry.value_bytes));
+    }
+    else
+    {
+      QByteArray bytes;
+      QDataStream out(&bytes, QIODevice::WriteOnly);
+      out << item.value;
+      entry.type = kVariant;
+      entry.value_bytes = static_cast<quint32>(bytes.size());
+      entry.value_offset = append(bytes.constData(), bytes.size());
+    }
+    entries.push_back(entry);
+  }
+
+  QByteArray payload(reinterpret_cast<const char *>(entries.data()),
+                     static_cast<int>(entries.size() * sizeof(ShmEntry)));
+  payload.append(blob);
+  return payload;
+}
+
+bool decode(const QByteArray &payload, quint64 count, std::vector<ConfigShm::Item> &items)
+{
+  if (count > static_cast<quint64>(payload.size()) / sizeof(ShmEntry))
+  {
+    return false;
+  }
+  const quint64 table_bytes = count * sizeof(ShmEntry);
+  const auto *entries = reinterpret_cast<const ShmEntry *>(payload.constData());
+  const char *blob = payload.constData() + table_bytes;
+  const quint64 blob_size = static_cast<quint64>(payload.size()) - table_bytes;
+  auto text = [blob](quint32 offset, quint32 bytes)
+  {
+    return QString(reinterpret_cast<const QChar *>(blob + offset), static_cast<int>(bytes / sizeof(QChar)));
+  };
+
+  items.clear();
+  items.reserve(count);
+  for (quint64 i = 0; i < count; ++i)
+  {
+    const ShmEntry &entry = entries[i];
+    if (static_cast<quint64>(entry.key_offset) + entry.key_bytes > blob_size ||
+        static_cast<quint64>(entry.value_offset) + entry.value_bytes > blob_size)
+    {
+      return false;
+    }
+    ConfigShm::Item item{text(entry.key_offset, entry.key_bytes), QVariant(), entry.is_default != 0};
+    if (entry.type == kString)
+    {
+      item.value = text(entry.value_offset, entry.value_bytes);
+    }
+    else if (entry.type == kVariant)
+    {
+      const QByteArray bytes = QByteArray::fromRawData(blob + entry.value_offset, static_cast<int>(entry.value_bytes));
+      QDataStream in(bytes);
+      in >> item.value;
+      if (in.status() != QDataStream::Ok)
+      {
+        return false;
+      }
+    }
+    items.push_back(std::move(item));
+  }
+  return true;
+}
+
+} // namespace
+
+ConfigShm::~ConfigShm()
+{
+  close();
+}
+
+QString ConfigShm::nameFor(const QString &config_file)
+{
+  // Short enough for the 31-character limit some systems put on segment names.
+  const QByteArray digest = QCryptographicHash::hash(config_file.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QStringLiteral("/qtutils-cfg-") + QString::fromLatin1(digest.left(16));
+}
+
+bool ConfigShm::create(const QString &name, qint64 capacity)
+{
+  close();
+#if defined(Q_OS_UNIX)
+  const QByteArray path = name.toLocal8Bit();
+  fd_ = shm_open(path.constData(), O_RDWR | O_CREAT, 0600);
+  if (fd_ < 0)
+  {
+    error_ = QString::fromLocal8Bit(std::strerror(errno));
+    return false;
+  }
+  // The lock goes away with the process, so a crashed or stopped writer's segment can be taken over.
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0)
+  {
+    error_ = errno == EWOULDBLOCK ? QStringLiteral("another process is already sharing this config")
+                                  : QString::fromLocal8Bit(std::strerror(errno));
+    close();
+    return false;
+  }
+
+  // Never shrink: readers may have the segment mapped at its current size. Growing is fine, they remap.
+  struct stat info;
+  qint64 size = static_cast<qint64>(sizeof(Header)) + std::max<qint64>(capacity, 0);
+  if (fstat(fd_, &info) == 0 && info.st_size > size)
+  {
+    size = info.st_size;
+  }
+  if (ftruncate(fd_, size) != 0 || !mapHeader(true) || !mapPayload(size, true))
+  {
+    error_ = QString::fromLocal8Bit(std::strerror(errno));
+    close();
+    return false;
+  }
+  writer_ = true;
+  name_ = name;
+
+  // A writer that died mid-update left the sequence odd, which readers wait out; it ends even either way.
+  const quint64 sequence = header_->sequence.load(std::memory_order_relaxed) | 1;
+  header_->sequence.store(sequence, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header_->magic, kShmMagic, sizeof(kShmMagic));
+  header_->version = kShmVersion;
+  header_->capacity = capacity_;
+  header_->entry_count.store(0, std::memory_order_relaxed);
+  header_->payload_size.store(0, std::memory_order_relaxed);
+  header_->retired.store(0, std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_release);
+  return true;
+#else
+  Q_UNUSED(name);
+  Q_UNUSED(capacity);
+  error_ = QStringLiteral("shared config needs POSIX shared memory");
+  return false;
+#endif
+}
+
+bool ConfigShm::open(const QString &name)
+{
+  close();
+#if defined(Q_OS_UNIX)
+  const QByteArray path = name.toLocal8Bit();
+  fd_ = shm_open(path.constData(), O_RDONLY, 0);
+  struct stat info;
+  if (fd_ < 0 || fstat(fd_, &info) != 0)
+  {
+    error_ = QString::fromLocal8Bit(std::strerror(errno));
+    close();
+    return false;
+  }
+  if (info.st_size < static_cast<qint64>(sizeof(Header)))
+  {
+    error_ = QStringLiteral("segment is not initialized");
+    close();
+    return false;
+  }
+  if (!mapHeader(false) || !mapPayload(info.st_size, false))
+  {
+    error_ = QString::fromLocal8Bit(std::strerror(errno));
+    close();
+    return false;
+  }
+  writer_ = false;
+  name_ = name;
+  if (std::memcmp(header_->magic, kShmMagic, sizeof(kShmMagic)) != 0 || header_->version != kShmVersion)
+  {
+    error_ = QStringLiteral("segment has an unknown layout");
+    close();
+    return false;
+  }
+  return true;
+#else
+  Q_UNUSED(name);
+  error_ = QStringLiteral("shared config needs POSIX shared memory");
+  return false;
+#endif
+}
+
+void ConfigShm::close()
+{
+#if defined(Q_OS_UNIX)
+  if (header_ != nullptr)
+  {
+    munmap(header_, sizeof(Header));
+  }
+  if (payload_map_ != nullptr)
+  {
+    munmap(payload_map_, static_cast<size_t>(map_size_));
+  }
+  // The name stays: followers keep reading it and the next writer takes it over, even after a clean shutdown.
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+  }
+#endif
+  header_ = nullptr;
+  payload_map_ = nullptr;
+  payload_ = nullptr;
+  capacity_ = 0;
+  map_size_ = 0;
+  fd_ = -1;
+  writer_ = false;
+  name_.clear();
+}
+
+bool ConfigShm::remove(const QString &name)
+{
+#if defined(Q_OS_UNIX)
+  const QByteArray path = name.toLocal8Bit();
+  const int fd = shm_open(path.constData(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size >= static_cast<qint64>(sizeof(Header)))
+  {
+    void *map = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED)
+    {
+      // A new sequence wakes followers up so they see the flag and look for the next segment of this name.
+      auto *header = static_cast<Header *>(map);
+      header->retired.store(1, std::memory_order_relaxed);
+      header->sequence.fetch_add(2, std::memory_order_release);
+      munmap(map, sizeof(Header));
+    }
+  }
+  ::close(fd);
+  return shm_unlink(path.constData()) == 0;
+#else
+  Q_UNUSED(name);
+  return false;
+#endif
+}
+
+bool ConfigShm::isOpen() const
+{
+  return header_ != nullptr;
+}
+
+bool ConfigShm::isWriter() const
+{
+  return writer_;
+}
+
+bool ConfigShm::isRetired() const
+{
+  return header_ != nullptr && header_->retired.load(std::memory_order_acquire) != 0;
+}
+
+QString ConfigShm::name() const
+{
+  return name_;
+}
+
+QString ConfigShm::errorString() const
+{
+  return error_;
+}
+
+bool ConfigShm::write(const std::vector<Item> &items)
+{
+  if (!writer_)
+  {
+    return false;
+  }
+  // Encoded before the sequence is bumped, so readers only ever retry across a memcpy.
+  const QByteArray payload = encode(items);
+  if (static_cast<quint64>(payload.size()) > capacity_)
+  {
+    error_ = QStringLiteral("config needs %1 bytes, the segment holds %2").arg(payload.size()).arg(capacity_);
+    return false;
+  }
+
+  const quint64 sequence = header_->sequence.load(std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->entry_count.store(items.size(), std::memory_order_relaxed);
+  header_->payload_size.store(static_cast<quint64>(payload.size()), std::memory_order_relaxed);
+  std::memcpy(payload_, payload.constData(), static_cast<size_t>(payload.size()));
+  header_->sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+bool ConfigShm::read(std::vector<Item> &items, quint64 &sequence)
+{
+  if (header_ == nullptr)
+  {
+    return false;
+  }
+
+  QByteArray payload;
+  for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt)
+  {
+    const quint64 begin = header_->sequence.load(std::memory_order_acquire);
+    if ((begin & 1) != 0)
+    {
+      QThread::yieldCurrentThread();
+      continue;
+    }
+    const quint64 count = header_->entry_count.load(std::memory_order_relaxed);
+    const quint64 size = header_->payload_size.load(std::memory_order_relaxed);
+    if (size > capacity_)
+    {
+      // Either torn or written by a writer that grew the segment after it was mapped here.
+      remapIfGrown();
+      continue;
+    }
+    payload.resize(static_cast<int>(size));
+    std::memcpy(payload.data(), payload_, static_cast<size_t>(size));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->sequence.load(std::memory_order_relaxed) != begin)
+    {
+      continue;
+    }
+
+    // The copy is consistent from here on; a table that still does not decode is corrupt, not torn.
+    sequence = begin;
+    return decode(payload, count, items);
+  }
+  error_ = QStringLiteral("no consistent table after %1 attempts").arg(kMaxReadAttempts);
+  return false;
+}
+
+const std::atomic<quint64> *ConfigShm::sequence() const
+{
+  return header_ != nullptr ? &header_->sequence : nullptr;
+}
+
+bool ConfigShm::mapHeader(bool writable)
+{
+#if defined(Q_OS_UNIX)
+  void *map = mmap(nullptr, sizeof(Header), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  header_ = static_cast<Header *>(map);
+  return true;
+#else
+  Q_UNUSED(writable);
+  return false;
+#endif
+}
+
+bool ConfigShm::mapPayload(qint64 size, bool writable)
+{
+#if defined(Q_OS_UNIX)
+  const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *map = mmap(nullptr, static_cast<size_t>(size), protection, MAP_SHARED, fd_, 0);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  if (payload_map_ != nullptr)
+  {
+    munmap(payload_map_, static_cast<size_t>(map_size_));
+  }
+  payload_map_ = map;
+  payload_ = static_cast<uchar *>(map) + sizeof(Header);
+  map_size_ = size;
+  // Bounded by what is mapped here, not by the header, which a later writer may have grown.
+  capacity_ = static_cast<quint64>(size) - sizeof(Header);
+  return true;
+#else
+  Q_UNUSED(size);
+  Q_UNUSED(writable);
+  return false;
+#endif
+}
+
+bool ConfigShm::remapIfGrown()
+{
+#if defined(Q_OS_UNIX)
+  struct stat info;
+  return !writer_ && fstat(fd_, &info) == 0 && info.st_size > map_size_ && mapPayload(info.st_size, false);
+#else
+  return false;
+#endif
+}
+
+} // namespace QtUtils
@@ -0,0 +1,258 @@
+#include "qtutils/log_index.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace QtUtils
+{
+
+namespace
+{
+
+struct IndexHeader
+{
+  char magic[4];
+  quint32 version;
+  quint32 block_size;
+  quint32 record_size;
+};
+
+constexpr char kIndexMagic[4] = {'Q', 'L', 'I', 'X'};
+constexpr quint32 kIndexVersion = 1;
+
+static_assert(sizeof(IndexHeader) == 16, "unexpected index header layout");
+static_assert(sizeof(LogIndex::Block) == 56, "unexpected index record layout");
+
+} // namespace
+
+QString LogIndex::indexPathFor(const QString &log_file)
+{
+  return log_file + QStringLiteral(".idx");
+}
+
+bool LogIndex::read(const QString &index_file, QVector<Block> &blocks)
+{
+  blocks.clear();
+
+  QFile file(index_file);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  IndexHeader header{};
+  if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)) ||
+      std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || header.version != kIndexVersion ||
+      header.record_size != sizeof(Block))
+  {
+    return false;
+  }
+
+  // A torn trailing record from a crash is ignored.
+  const qint64 count = (file.size() - static_cast<qint64>(sizeof(header))) / static_cast<qint64>(sizeof(Block));
+  blocks.resize(static_cast<int>(count));
+  const qint64 bytes = count * static_cast<qint64>(sizeof(Block));
+  if (bytes > 0 && file.read(reinterpret_cast<char *>(blocks.data()), bytes) != bytes)
+  {
+    blocks.clear();
+    return false;
+  }
+  return true;
+}
+
+// Blocks are written in file order and their timestamps are nearly sorted, so a running max of max_ts and a running
+// min (from the end) of min_ts are both monotonic and can be binary-searched.
+QVector<LogIndex::ByteRange> LogIndex::selectRanges(const QVector<Block> &blocks,
+                                                    qint64 file_size,
+                                                    qint64 from_ms,
+                                                    qint64 to_ms,
+                                                    int min_level)
+{
+  QVector<ByteRange> ranges;
+  const int count = static_cast<int>(blocks.size());
+
+  std::vector<qint64> prefix_max(count);
+  std::vector<qint64> suffix_min(count);
+  for (int i = 0; i < count; ++i)
+  {
+    prefix_max[i] = i > 0 ? std::max(prefix_max[i - 1], blocks[i].max_ts_ms) : blocks[i].max_ts_ms;
+  }
+  for (int i = count - 1; i >= 0; --i)
+  {
+    suffix_min[i] = i + 1 < count ? std::min(suffix_min[i + 1], blocks[i].min_ts_ms) : blocks[i].min_ts_ms;
+  }
+
+  const int first =
+      static_cast<int>(std::lower_bound(prefix_max.begin(), prefix_max.end(), from_ms) - prefix_max.begin());
+  const int last = static_cast<int>(std::upper_bound(suffix_min.begin(), suffix_min.end(), to_ms) - suffix_min.begin());
+
+  for (int i = first; i < last; ++i)
+  {
+    const Block &block = blocks[i];
+    if (block.max_ts_ms < from_ms || block.min_ts_ms > to_ms || block.offset >= file_size)
+    {
+      continue;
+    }
+
+    bool has_level = false;
+    for (int level = std::max(0, min_level); level < kLevelCount; ++level)
+    {
+      has_level = has_level || block.level_counts[level] > 0;
+    }
+    if (has_level)
+    {
+      ranges.append({block.offset, std::min(file_size, block.offset + block.length)});
+    }
+  }
+
+  // Bytes no block covers (written before the index existed, or after its last record) are always scanned.
+  qint64 covered_until = 0;
+  for (const Block &block : blocks)
+  {
+    if (block.offset > covered_until)
+    {
+      ranges.append({covered_until, std::min(file_size, block.offset)});
+    }
+    covered_until = std::max(covered_until, block.offset + block.length);
+  }
+  if (covered_until < file_size)
+  {
+    ranges.append({covered_until, file_size});
+  }
+
+  std::sort(ranges.begin(),
+            ranges.end(),
+            [](const ByteRange &a, const ByteRange &b)
+            {
+              return a.begin < b.begin;
+            });
+
+  QVector<ByteRange> merged;
+  for (const ByteRange &range : ranges)
+  {
+    if (range.begin >= range.end)
+    {
+      continue;
+    }
+    if (!merged.isEmpty() && range.begin <= merged.back().end)
+    {
+      merged.back().end = std::max(merged.back().end, range.end);
+    }
+    else
+    {
+      merged.append(range);
+    }
+  }
+  return merged;
+}
+
+LogIndexWriter::~LogIndexWriter()
+{
+  close();
+}
+
+bool LogIndexWriter::open(const QString &log_file, qint64 block_bytes)
+{
+  close();
+
+  block_bytes_ = std::max<qint64>(1024, block_bytes);
+  file_.setFileName(LogIndex::indexPathFor(log_file));
+  if (!file_.open(QIODevice::ReadWrite))
+  {
+    return false;
+  }
+
+  IndexHeader header{};
+  const bool has_header = file_.size() >= static_cast<qint64>(sizeof(header)) &&
+                          file_.read(reinterpret_cast<char *>(&header), sizeof(header)) ==
+                              static_cast<qint64>(sizeof(header)) &&
+                          std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+                          header.version == kIndexVersion && header.record_size == sizeof(LogIndex::Block);
+
+  if (!has_header)
+  {
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.block_size = static_cast<quint32>(block_bytes_);
+    header.record_size = sizeof(LogIndex::Block);
+    file_.resize(0);
+    file_.seek(0);
+    file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  else
+  {
+    const qint64 records = (file_.size() - static_cast<qint64>(sizeof(header))) / sizeof(LogIndex::Block);
+    file_.resize(static_cast<qint64>(sizeof(header)) + records * static_cast<qint64>(sizeof(LogIndex::Block)));
+    file_.seek(file_.size());
+  }
+
+  block_open_ = false;
+  return true;
+}
+
+void LogIndexWriter::close()
+{
+  if (!file_.isOpen())
+  {
+    return;
+  }
+
+  emitBlock();
+  file_.close();
+}
+
+bool LogIndexWriter::isOpen() const
+{
+  return file_.isOpen();
+}
+
+void LogIndexWriter::addEntry(qint64 offset, qint64 length, qint64 timestamp_ms, int level_index)
+{
+  if (!file_.isOpen())
+  {
+    return;
+  }
+
+  if (!block_open_)
+  {
+    block_ = LogIndex::Block{};
+    block_.offset = offset;
+    block_.min_ts_ms = timestamp_ms;
+    block_.max_ts_ms = timestamp_ms;
+    block_open_ = true;
+  }
+
+  block_.length = offset + length - block_.offset;
+  block_.min_ts_ms = std::min(block_.min_ts_ms, timestamp_ms);
+  block_.max_ts_ms = std::max(block_.max_ts_ms, timestamp_ms);
+  if (level_index >= 0 && level_index < LogIndex::kLevelCount)
+  {
+    ++block_.level_counts[level_index];
+  }
+
+  if (block_.length >= block_bytes_)
+  {
+    emitBlock();
+  }
+}
+
+void LogIndexWriter::flush()
+{
+  if (file_.isOpen())
+  {
+    file_.flush();
+  }
+}
+
+void LogIndexWriter::emitBlock()
+{
+  if (!block_open_)
+  {
+    return;
+  }
+
+  file_.write(reinterpret_cast<const char *>(&block_), sizeof(block_));
+  block_open_ = false;
+}
+
+} // namespace QtUtils
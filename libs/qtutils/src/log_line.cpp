@@ -0,0 +1,128 @@
+#include "qtutils/log_line.h"
+#include <cstring>
+#include <iterator>
+
+namespace QtUtils
+{
+
+namespace
+{
+
+const char *findText(const char *data, qsizetype length, const char *needle, qsizetype needle_length)
+{
+  for (qsizetype i = 0; i + needle_length <= length; ++i)
+  {
+    if (data[i] == needle[0] && std::memcmp(data + i, needle, static_cast<size_t>(needle_length)) == 0)
+    {
+      return data + i;
+    }
+  }
+  return nullptr;
+}
+
+// Level names as written by LogManager, indexed like LogIndex::Block::level_counts.
+constexpr const char *kLevelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR", "FATAL"};
+
+// The name must span the whole token, so "INFORMATION" or "E" are rejected rather than read as a level.
+int levelFromName(const char *name, qsizetype length)
+{
+  for (int level = 0; level < static_cast<int>(std::size(kLevelNames)); ++level)
+  {
+    const qsizetype name_length = static_cast<qsizetype>(std::strlen(kLevelNames[level]));
+    if (length == name_length && std::memcmp(name, kLevelNames[level], static_cast<size_t>(length)) == 0)
+    {
+      return level;
+    }
+  }
+  return -1;
+}
+
+// Token length up to the terminator, or -1 if the line ends first.
+qsizetype tokenLength(const char *token, qsizetype length, char terminator)
+{
+  const void *end = std::memchr(token, terminator, static_cast<size_t>(length));
+  return end != nullptr ? static_cast<const char *>(end) - token : -1;
+}
+
+} // namespace
+
+const char *LogLine::findTimestamp(const char *line, qsizetype length)
+{
+  // text:  [yyyy-MM-dd hh:mm:ss.zzz] ...
+  // json:  {"ts":"yyyy-MM-dd hh:mm:ss.zzz", ...
+  if (length >= kTimestampLength + 2 && line[0] == '[' && line[kTimestampLength + 1] == ']')
+  {
+    return line + 1;
+  }
+  if (length >= kTimestampLength + 7 && std::memcmp(line, "{\"ts\":\"", 7) == 0)
+  {
+    return line + 7;
+  }
+  return nullptr;
+}
+
+qint64 LogLine::timestampKey(const char *line, qsizetype length)
+{
+  const char *ts = findTimestamp(line, length);
+  if (ts == nullptr)
+  {
+    return -1;
+  }
+
+  qint64 key = 0;
+  for (int i = 0; i < kTimestampLength; ++i)
+  {
+    const char c = ts[i];
+    if (c >= '0' && c <= '9')
+    {
+      key = key * 10 + (c - '0');
+    }
+    else if (c != '-' && c != ' ' && c != ':' && c != '.' && c != 'T')
+    {
+      return -1;
+    }
+  }
+  return key;
+}
+
+qint64 LogLine::timestampKey(const QDateTime &datetime)
+{
+  return datetime.toLocalTime().toString("yyyyMMddhhmmsszzz").toLongLong();
+}
+
+int LogLine::levelIndex(const char *line, qsizetype length)
+{
+  // text:  [timestamp] [LEVEL] ...
+  // json:  ..."level":"LEVEL"...
+  if (length > 0 && line[0] == '[')
+  {
+    const qsizetype start = kTimestampLength + 4;
+    if (length <= start)
+    {
+      return -1;
+    }
+    const qsizetype name_length = tokenLength(line + start, length - start, ']');
+    return name_length > 0 ? levelFromName(line + start, name_length) : -1;
+  }
+
+  const char *found = findText(line, length, "\"level\":\"", 9);
+  if (found == nullptr)
+  {
+    return -1;
+  }
+  const char *name = found + 9;
+  const qsizetype name_length = tokenLength(name, length - (name - line), '"');
+  return name_length > 0 ? levelFromName(name, name_length) : -1;
+}
+
+int LogLine::levelIndex(const QString &level_name)
+{
+  const QByteArray upper = level_name.trimmed().toUpper().toLatin1();
+  if (upper == "CRITICAL")
+  {
+    return 3;
+  }
+  return levelFromName(upper.constData(), upper.size());
+}
+
+} // namespace QtUtils
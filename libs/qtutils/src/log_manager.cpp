@@ -1,8 +1,12 @@
 #include "qtutils/log_manager.h"
 #include "qtutils/common_utils.h"
+#include "qtutils/log_index.h"
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QLocale>
+#include <QtNumeric>
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 
@@ -30,44 +34,91 @@ bool LogManager::initialize(const QString &log_dir, QtMsgType min_level, bool en
   min_level_ = min_level;
   console_enabled_ = enable_console;
   file_enabled_ = enable_file;
+  log_dir_ = log_dir;
+  storage_ready_ = false;
+  drain_file_only_ = false;
+  drain_deadline_ns_ = 0;
+
+  // Directory creation, retention cleanup and file opening are deferred to the worker; until then
+  // entries simply accumulate in queue_.
+  accepting_ = true;
+  original_qt_msg_handler_ = qInstallMessageHandler(qtMessageHandler);
+
+  thread_is_running_ = true;
+  worker_thread_ = QThread::create(
+      [this]()
+      {
+        workerThread();
+      });
+  worker_thread_->setObjectName(QStringLiteral("LogManager"));
+  worker_thread_->start();
+  return true;
+}
 
+void LogManager::prepareStorage()
+{
+  QString log_dir = log_dir_;
   if (log_dir.isEmpty())
   {
-    log_dir_ = CommonUtils::getAppLogDirPath();
-  }
-  else
-  {
-    log_dir_ = log_dir;
+    log_dir = CommonUtils::getAppLogDirPath();
   }
 
-  if (log_dir_.isEmpty())
+  bool usable = false;
+  if (log_dir.isEmpty())
   {
     qWarning("Log directory unavailable, disabling file logging");
-    file_enabled_ = false;
   }
   else
   {
-    QDir dir(log_dir_);
+    QDir dir(log_dir);
     if (!dir.exists() && !dir.mkpath("."))
     {
-      qWarning("Failed to create log directory: %s, disabling file logging", qPrintable(log_dir_));
-      file_enabled_ = false;
+      qWarning("Failed to create log directory: %s, disabling file logging", qPrintable(log_dir));
     }
     else
     {
-      cleanupOldLogs();
+      usable = true;
     }
   }
 
-  original_qt_msg_handler_ = qInstallMessageHandler(qtMessageHandler);
+  {
+    // Serialized with applyFileEnabled(), so a configure() racing this check cannot turn file logging back on for
+    // an unusable directory.
+    std::lock_guard<std::mutex> lock(storage_mutex_);
+    log_dir_ = log_dir;
+    if (!usable)
+    {
+      file_enabled_ = false;
+    }
+    storage_ready_.store(true, std::memory_order_release);
+  }
 
-  worker_thread_ = QThread::create(
-      [this]()
-      {
-        workerThread();
-      });
-  worker_thread_->start();
-  thread_is_running_ = true;
+  if (usable)
+  {
+    cleanupOldLogs();
+  }
+}
+
+bool LogManager::isLogDirUsable() const
+{
+  if (!storage_ready_.load(std::memory_order_acquire))
+  {
+    return true;
+  }
+  return !log_dir_.isEmpty() && QDir().mkpath(log_dir_);
+}
+
+bool LogManager::applyFileEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  // Before the worker has checked the directory the request is recorded as is; prepareStorage() overrides it
+  // if the directory turns out unusable.
+  if (enabled && !isLogDirUsable())
+  {
+    file_enabled_ = false;
+    return false;
+  }
+  file_enabled_ = enabled;
   return true;
 }
 
@@ -75,33 +126,35 @@ void LogManager::configure(QtMsgType min_level, bool enable_console, bool enable
 {
   min_level_ = min_level;
   console_enabled_ = enable_console;
-  if (enable_file && (log_dir_.isEmpty() || !QDir().mkpath(log_dir_)))
+  if (!applyFileEnabled(enable_file))
   {
     qWarning("Log directory unavailable, file logging remains disabled");
-    file_enabled_ = false;
-  }
-  else
-  {
-    file_enabled_ = enable_file;
   }
 }
 
-void LogManager::shutdown()
+void LogManager::shutdown(DrainMode mode)
 {
   if (!thread_is_running_)
   {
     return;
   }
 
+  const int budget_ms = shutdown_budget_ms_.load();
+  drain_file_only_ = (mode == DrainMode::FileOnly);
+  drain_deadline_ns_ = budget_ms > 0 ? steadyNowNs() + static_cast<qint64>(budget_ms) * 1000000 : 0;
+
   thread_is_running_ = false;
   cond_.notify_all();
 
   if (worker_thread_ != nullptr)
   {
-    if (!worker_thread_->wait(10000))
+    // The worker checks the deadline itself, so the grace period only covers a write blocked past it. Deleting a
+    // running QThread is never an option, so after the warning the wait goes on; without a budget it never ends.
+    if (budget_ms > 0 && !worker_thread_->wait(static_cast<unsigned long>(std::max(10000, budget_ms + 1000))))
     {
-      qWarning("LogManager worker thread did not stop gracefully");
+      qWarning("LogManager worker thread did not stop within the shutdown budget, still waiting");
     }
+    worker_thread_->wait();
     delete worker_thread_;
     worker_thread_ = nullptr;
   }
@@ -112,32 +165,61 @@ void LogManager::shutdown()
     original_qt_msg_handler_ = nullptr;
   }
 
+  std::deque<LogEntry> remaining;
   {
     std::unique_lock<std::mutex> lock(mutex_);
-    while (!queue_.empty())
-    {
-      LogEntry entry = std::move(queue_.front());
-      queue_.pop_front();
-
-      QString formatted_qs = formatLogEntry(entry);
-      QByteArray bytes = formatted_qs.toUtf8();
-      bytes.append('\n');
+    // LogRecords do not go through the Qt handler, so without this they would queue up until the next restart.
+    accepting_ = false;
+    remaining.swap(queue_);
+    queue_depth_.store(0, std::memory_order_relaxed);
+  }
+  processBatch(remaining);
 
-      if (file_enabled_ && current_file_)
-      {
-        current_file_->write(bytes);
-        current_file_->flush();
-      }
+  closeLogFile();
+}
 
-      if (console_enabled_)
-      {
-        fwrite(bytes.constData(), 1, static_cast<size_t>(bytes.size()), stdout);
-        fflush(stdout);
-      }
-    }
+bool LogManager::restart()
+{
+  if (thread_is_running_)
+  {
+    return false;
   }
+  // Each run writes to a file of its own, so consecutive sessions or benchmark cells never share one.
+  setCurrentFileName(QString());
+  current_file_size_ = 0;
+  return initialize(log_dir_, min_level_.load(), console_enabled_.load(), file_enabled_.load());
+}
 
-  closeLogFile();
+bool LogManager::isRunning() const
+{
+  return thread_is_running_.load();
+}
+
+void LogManager::setShutdownBudget(int budget_ms)
+{
+  shutdown_budget_ms_ = budget_ms;
+}
+
+int LogManager::shutdownBudget() const
+{
+  return shutdown_budget_ms_.load();
+}
+
+qint64 LogManager::steadyNowNs()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool LogManager::drainBudgetExceeded() const
+{
+  qint64 deadline = drain_deadline_ns_.load();
+  return deadline != 0 && steadyNowNs() >= deadline;
+}
+
+bool LogManager::isConsoleActive() const
+{
+  return console_enabled_ && !drain_file_only_;
 }
 
 const char *LogManager::extractFileName(const char *path)
@@ -162,7 +244,8 @@ void LogManager::qtMessageHandler(QtMsgType type, const QMessageLogContext &cont
 {
   LogManager &self = LogManager::instance();
 
-  if (type < self.min_level_)
+  quint32 sample_rate = 1;
+  if (!self.accepts(type, context.file, context.line, sample_rate))
   {
     return;
   }
@@ -172,19 +255,14 @@ void LogManager::qtMessageHandler(QtMsgType type, const QMessageLogContext &cont
   QByteArray message = msg.toUtf8();
   qint64 timestamp_ms = QDateTime::currentMSecsSinceEpoch();
 
-  LogEntry entry{timestamp_ms,
-                 type,
-                 QByteArray(filename),
-                 context.line,
-                 QByteArray(function),
-                 message,
-                 reinterpret_cast<quintptr>(QThread::currentThreadId())};
-
-  {
-    std::unique_lock<std::mutex> lock(self.mutex_);
-    self.queue_.push_back(std::move(entry));
-  }
-  self.cond_.notify_all();
+  self.enqueue(LogEntry{timestamp_ms,
+                        type,
+                        QByteArray(filename),
+                        context.line,
+                        QByteArray(function),
+                        message,
+                        reinterpret_cast<quintptr>(QThread::currentThreadId()),
+                        sample_rate});
 
   if (type == QtFatalMsg)
   {
@@ -201,9 +279,59 @@ void LogManager::qtMessageHandler(QtMsgType type, const QMessageLogContext &cont
   }
 }
 
+bool LogManager::accepts(QtMsgType type, const char *file, int line, quint32 &sample_rate)
+{
+  if (!accepting_.load(std::memory_order_relaxed))
+  {
+    return false;
+  }
+  // QtInfoMsg was added after the other levels, so the enum values are not in severity order.
+  if (levelIndex(type) < levelIndex(min_level_.load(std::memory_order_relaxed)))
+  {
+    return false;
+  }
+  return sampleKeep(type, file, line, sample_rate);
+}
+
+void LogManager::enqueue(LogEntry &&entry)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(entry));
+
+    // Only written under mutex_, so plain stores suffice; readers just need a torn-free value.
+    const qsizetype depth = static_cast<qsizetype>(queue_.size());
+    queue_depth_.store(depth, std::memory_order_relaxed);
+    if (depth > max_queue_depth_.load(std::memory_order_relaxed))
+    {
+      max_queue_depth_.store(depth, std::memory_order_relaxed);
+    }
+    enqueued_count_.store(enqueued_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  cond_.notify_all();
+}
+
+void LogManager::submit(LogRecord &record)
+{
+  const char *function = (record.function_ != nullptr) ? record.function_ : "unknown";
+  LogEntry entry{record.timestamp_ms_,
+                 record.level_,
+                 QByteArray(extractFileName(record.file_)),
+                 record.line_,
+                 QByteArray(function),
+                 std::move(record.message_),
+                 reinterpret_cast<quintptr>(QThread::currentThreadId()),
+                 record.sample_rate_};
+  entry.fields = std::move(record.fields_);
+  enqueue(std::move(entry));
+}
+
 void LogManager::workerThread()
 {
   using namespace std::chrono;
+
+  prepareStorage();
+
   while (true)
   {
     std::deque<LogEntry> batch;
@@ -220,6 +348,7 @@ void LogManager::workerThread()
       if (!queue_.empty())
       {
         batch.swap(queue_);
+        queue_depth_.store(0, std::memory_order_relaxed);
       }
       else if (!thread_is_running_)
       {
@@ -232,61 +361,136 @@ void LogManager::workerThread()
       continue;
     }
 
-    QByteArray file_batch;
-    QByteArray console_batch;
+    processBatch(batch);
 
-    while (!batch.empty())
+    if (!thread_is_running_ && drainBudgetExceeded())
     {
-      writeLogEntry(batch.front(), file_batch, console_batch);
-      batch.pop_front();
+      break;
+    }
+  }
+}
 
-      if (static_cast<qint64>(file_batch.size()) >= flush_size_.load())
-      {
-        flushBatches(file_batch, console_batch);
-        file_batch.clear();
-        console_batch.clear();
-      }
+void LogManager::processBatch(std::deque<LogEntry> &batch)
+{
+  QByteArray file_batch;
+  QByteArray console_batch;
+  int since_budget_check = 0;
+  quint64 written = 0;
+
+  while (!batch.empty())
+  {
+    // The deadline is only armed during shutdown. It is checked before the first entry, so an expired drain writes
+    // nothing more, and then every 256 entries to keep the clock off the hot loop.
+    if (since_budget_check == 0 && drainBudgetExceeded())
+    {
+      LogEntry summary = makeDropSummary(batch);
+      dropped_count_.fetch_add(batch.size(), std::memory_order_relaxed);
+      batch.clear();
+      writeLogEntry(summary, file_batch, console_batch);
+      break;
     }
+    since_budget_check = (since_budget_check + 1) % 256;
 
-    flushBatches(file_batch, console_batch);
+    writeLogEntry(batch.front(), file_batch, console_batch);
+    batch.pop_front();
+    ++written;
+
+    if (static_cast<qint64>(file_batch.size()) >= flush_size_.load())
+    {
+      flushBatches(file_batch, console_batch);
+      file_batch.clear();
+      console_batch.clear();
+    }
   }
+
+  flushBatches(file_batch, console_batch);
+  processed_count_.fetch_add(written, std::memory_order_relaxed);
+}
+
+LogManager::LogEntry LogManager::makeDropSummary(const std::deque<LogEntry> &dropped)
+{
+  qint64 counts[kLevelCount] = {0, 0, 0, 0, 0};
+  for (const LogEntry &entry : dropped)
+  {
+    ++counts[levelIndex(entry.level)];
+  }
+
+  QByteArray message = QString("Shutdown drain budget of %1 ms exceeded, dropped %2 entries "
+                               "(DEBUG=%3 INFO=%4 WARNING=%5 ERROR=%6 FATAL=%7)")
+                           .arg(shutdown_budget_ms_.load())
+                           .arg(static_cast<qulonglong>(dropped.size()))
+                           .arg(counts[0])
+                           .arg(counts[1])
+                           .arg(counts[2])
+                           .arg(counts[3])
+                           .arg(counts[4])
+                           .toUtf8();
+
+  return LogEntry{QDateTime::currentMSecsSinceEpoch(),
+                  QtWarningMsg,
+                  QByteArray(extractFileName(__FILE__)),
+                  __LINE__,
+                  QByteArray(Q_FUNC_INFO),
+                  message,
+                  reinterpret_cast<quintptr>(QThread::currentThreadId()),
+                  1};
 }
 
 void LogManager::writeLogEntry(const LogEntry &entry, QByteArray &file_batch, QByteArray &console_batch)
 {
-  QString formatted_qs = formatLogEntry(entry);
-  QByteArray bytes = formatted_qs.toUtf8();
-  bytes.append('\n');
+  if (file_enabled_ && !current_file_)
+  {
+    if (!openLogFile())
+    {
+      qWarning("Failed to open log file");
+    }
+  }
+
+  const bool to_file = file_enabled_ && current_file_;
+  const bool to_console = isConsoleActive();
+  if (!to_file && !to_console)
+  {
+    return;
+  }
+
+  // Encode straight into the tail of the batch that receives the entry; the console copies it from there.
+  QByteArray &target = to_file ? file_batch : console_batch;
+  const qsizetype start = target.size();
+  encodeEntry(entry, target);
+  const qsizetype length = target.size() - start;
 
-  qint64 max_size = max_file_size_.load();
-  if (current_file_size_.load() + static_cast<qint64>(bytes.size()) >= max_size)
+  if (to_file && (start > 0 || current_file_size_.load() > 0) &&
+      current_file_size_.load() + static_cast<qint64>(file_batch.size()) >= max_file_size_.load())
   {
+    QByteArray tail = file_batch.mid(start);
+    file_batch.truncate(start);
     flushBatches(file_batch, console_batch);
-    file_batch.clear();
+    file_batch = std::move(tail);
     console_batch.clear();
 
+    const qint64 rotation_begin = steadyNowNs();
     if (!rotateLogFile())
     {
       qWarning("Failed to rotate log file");
     }
-  }
+    rotations_count_.fetch_add(1, std::memory_order_relaxed);
 
-  if (file_enabled_ && !current_file_)
-  {
-    if (!openLogFile())
+    const std::shared_ptr<const RotationObserver> observer = std::atomic_load(&rotation_observer_);
+    if (observer)
     {
-      qWarning("Failed to open log file");
+      (*observer)(steadyNowNs() - rotation_begin);
     }
   }
 
-  if (file_enabled_ && current_file_)
+  if (to_file && index_writer_.isOpen())
   {
-    file_batch.append(bytes);
+    const qint64 offset = current_file_size_.load() + static_cast<qint64>(file_batch.size() - length);
+    index_writer_.addEntry(offset, length, entry.timestamp_ms, levelIndex(entry.level));
   }
 
-  if (console_enabled_)
+  if (to_file && to_console)
   {
-    console_batch.append(bytes);
+    console_batch.append(file_batch.constData() + file_batch.size() - length, length);
   }
 }
 
@@ -298,35 +502,317 @@ void LogManager::flushBatches(const QByteArray &file_batch, const QByteArray &co
     if (written > 0)
     {
       current_file_size_ += written;
+      file_bytes_written_.fetch_add(written, std::memory_order_relaxed);
     }
     current_file_->flush();
+    index_writer_.flush();
+
+    const std::shared_ptr<const WriteObserver> observer = std::atomic_load(&write_observer_);
+    if (observer)
+    {
+      (*observer)(file_batch);
+    }
   }
 
-  if (console_enabled_ && !console_batch.isEmpty())
+  if (isConsoleActive() && !console_batch.isEmpty())
   {
     fwrite(console_batch.constData(), 1, static_cast<size_t>(console_batch.size()), stdout);
     fflush(stdout);
   }
 }
 
-QString LogManager::formatLogEntry(const LogEntry &entry)
+void LogManager::encodeEntry(const LogEntry &entry, QByteArray &out) const
+{
+  if (output_format_.load(std::memory_order_relaxed) == OutputFormat::JsonLines)
+  {
+    encodeJsonEntry(entry, out);
+  }
+  else
+  {
+    formatLogEntry(entry, out);
+  }
+}
+
+void LogManager::formatLogEntry(const LogEntry &entry, QByteArray &out)
+{
+  out.append('[');
+  out.append(QDateTime::fromMSecsSinceEpoch(entry.timestamp_ms).toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1());
+  out.append("] [");
+  out.append(levelToString(entry.level));
+  out.append("] [");
+  out.append(entry.file);
+  out.append(':');
+  out.append(QByteArray::number(entry.line));
+  out.append("] [");
+  appendThreadId(out, entry.threadid);
+  out.append("] ");
+
+  // Sampled entries carry their rate so downstream counts can be scaled back up.
+  if (entry.sample_rate > 1)
+  {
+    out.append("[sample 1/");
+    out.append(QByteArray::number(entry.sample_rate));
+    out.append("] ");
+  }
+
+  out.append(entry.message);
+
+  for (const LogField &field : entry.fields)
+  {
+    out.append(' ');
+    out.append(LogKey::nameOf(field.key));
+    out.append('=');
+    appendFieldValue(out, field, false);
+  }
+
+  out.append('\n');
+}
+
+void LogManager::encodeJsonEntry(const LogEntry &entry, QByteArray &out)
+{
+  // "ts" stays the first member so tools can read the timestamp from a fixed prefix.
+  out.append("{\"ts\":\"");
+  out.append(QDateTime::fromMSecsSinceEpoch(entry.timestamp_ms).toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1());
+  out.append("\",\"ts_ms\":");
+  out.append(QByteArray::number(entry.timestamp_ms));
+  out.append(",\"level\":\"");
+  out.append(levelToString(entry.level));
+  out.append("\",\"file\":");
+  appendJsonString(out, entry.file);
+  out.append(",\"line\":");
+  out.append(QByteArray::number(entry.line));
+  out.append(",\"func\":");
+  appendJsonString(out, entry.function);
+  out.append(",\"tid\":\"");
+  appendThreadId(out, entry.threadid);
+  out.append("\",\"msg\":");
+  appendJsonString(out, entry.message);
+
+  if (entry.sample_rate > 1)
+  {
+    out.append(",\"sample_rate\":");
+    out.append(QByteArray::number(entry.sample_rate));
+  }
+
+  if (!entry.fields.empty())
+  {
+    out.append(",\"fields\":{");
+    bool first = true;
+    for (const LogField &field : entry.fields)
+    {
+      if (!first)
+      {
+        out.append(',');
+      }
+      first = false;
+      appendJsonString(out, LogKey::nameOf(field.key));
+      out.append(':');
+      appendFieldValue(out, field, true);
+    }
+    out.append('}');
+  }
+
+  out.append("}\n");
+}
+
+void LogManager::appendThreadId(QByteArray &out, quintptr threadid)
+{
+  static const char digits[] = "0123456789ABCDEF";
+  char buffer[16];
+  quint64 value = static_cast<quint64>(threadid);
+  for (int i = 15; i >= 0; --i)
+  {
+    buffer[i] = digits[value & 0xF];
+    value >>= 4;
+  }
+  out.append(buffer, 16);
+}
+
+void LogManager::appendJsonString(QByteArray &out, const QByteArray &text)
+{
+  static const char hex[] = "0123456789abcdef";
+  out.append('"');
+
+  const char *data = text.constData();
+  const qsizetype size = text.size();
+  qsizetype run_start = 0;
+  for (qsizetype i = 0; i < size; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+
+    out.append(data + run_start, i - run_start);
+    run_start = i + 1;
+    switch (c)
+    {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+    {
+      const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+      out.append(escaped, 6);
+      break;
+    }
+    }
+  }
+
+  out.append(data + run_start, size - run_start);
+  out.append('"');
+}
+
+void LogManager::appendFieldValue(QByteArray &out, const LogField &field, bool json)
+{
+  switch (field.type)
+  {
+  case LogField::Type::Int:
+    out.append(QByteArray::number(field.scalar.i));
+    break;
+  case LogField::Type::UInt:
+    out.append(QByteArray::number(field.scalar.u));
+    break;
+  case LogField::Type::Double:
+    if (!qIsFinite(field.scalar.d))
+    {
+      out.append(json ? "null" : (qIsNaN(field.scalar.d) ? "nan" : (field.scalar.d > 0 ? "inf" : "-inf")));
+    }
+    else
+    {
+      out.append(QByteArray::number(field.scalar.d, 'g', QLocale::FloatingPointShortest));
+    }
+    break;
+  case LogField::Type::Bool:
+    out.append(field.scalar.b ? "true" : "false");
+    break;
+  case LogField::Type::String:
+    if (json || field.text.isEmpty() || field.text.contains(' ') || field.text.contains('"') ||
+        field.text.contains('=') || field.text.contains('\n'))
+    {
+      appendJsonString(out, field.text);
+    }
+    else
+    {
+      out.append(field.text);
+    }
+    break;
+  }
+}
+
+void LogManager::setIndexEnabled(bool enabled)
+{
+  index_enabled_ = enabled;
+}
+
+bool LogManager::isIndexEnabled() const
+{
+  return index_enabled_;
+}
+
+void LogManager::setIndexBlockSize(qint64 bytes)
+{
+  index_block_bytes_ = std::max<qint64>(1024, bytes);
+}
+
+void LogManager::setFlushSize(qint64 flush_bytes)
+{
+  flush_size_ = std::max<qint64>(1, flush_bytes);
+}
+
+qint64 LogManager::flushSize() const
+{
+  return flush_size_.load();
+}
+
+void LogManager::setFlushTimeout(int timeout_ms)
+{
+  flush_timeout_ms_ = std::max(1, timeout_ms);
+}
+
+int LogManager::flushTimeout() const
+{
+  return flush_timeout_ms_.load();
+}
+
+void LogManager::setWriteObserver(WriteObserver observer)
+{
+  std::shared_ptr<const WriteObserver> shared;
+  if (observer)
+  {
+    shared = std::make_shared<const WriteObserver>(std::move(observer));
+  }
+  std::atomic_store(&write_observer_, std::move(shared));
+}
+
+void LogManager::setMaxFileSize(qint64 max_bytes)
+{
+  max_file_size_ = std::max<qint64>(1, max_bytes);
+}
+
+qint64 LogManager::maxFileSize() const
+{
+  return max_file_size_.load();
+}
+
+void LogManager::setMaxFileCount(int max_files)
+{
+  max_files_count_ = std::max(1, max_files);
+}
+
+int LogManager::maxFileCount() const
 {
-  QString thread_id_str = QString("%1").arg(static_cast<qulonglong>(entry.threadid), 16, 16, QChar('0')).toUpper();
+  return max_files_count_.load();
+}
 
-  QDateTime ts = QDateTime::fromMSecsSinceEpoch(entry.timestamp_ms);
-  QString file_str = QString::fromUtf8(entry.file);
-  QString func_str = QString::fromUtf8(entry.function);
-  QString msg_str = QString::fromUtf8(entry.message);
+void LogManager::setRotationObserver(RotationObserver observer)
+{
+  std::shared_ptr<const RotationObserver> shared;
+  if (observer)
+  {
+    shared = std::make_shared<const RotationObserver>(std::move(observer));
+  }
+  std::atomic_store(&rotation_observer_, std::move(shared));
+}
 
-  QString formatted = QString("[%1] [%2] [%3:%4] [%5] %6")
-                          .arg(ts.toString("yyyy-MM-dd hh:mm:ss.zzz"))
-                          .arg(levelToString(entry.level))
-                          .arg(file_str)
-                          .arg(entry.line)
-                          .arg(thread_id_str)
-                          .arg(msg_str);
+void LogManager::setOutputFormat(OutputFormat format)
+{
+  output_format_ = format;
+}
 
-  return formatted;
+LogManager::OutputFormat LogManager::outputFormat() const
+{
+  return output_format_.load();
+}
+
+int LogManager::levelIndex(QtMsgType type)
+{
+  switch (type)
+  {
+  case QtDebugMsg:
+    return 0;
+  case QtInfoMsg:
+    return 1;
+  case QtWarningMsg:
+    return 2;
+  case QtCriticalMsg:
+    return 3;
+  default:
+    return 4;
+  }
 }
 
 const char *LogManager::levelToString(QtMsgType type)
@@ -354,11 +840,12 @@ bool LogManager::openLogFile()
 
   if (current_file_name_.isEmpty())
   {
-    current_file_name_ = generateLogFileName();
+    setCurrentFileName(generateLogFileName());
   }
 
   current_file_ = std::make_unique<QFile>(current_file_name_);
-  if (!current_file_->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+  // No QIODevice::Text: the sidecar index records byte offsets, which newline translation would break.
+  if (!current_file_->open(QIODevice::WriteOnly | QIODevice::Append))
   {
     current_file_.reset();
     return false;
@@ -366,12 +853,19 @@ bool LogManager::openLogFile()
 
   current_file_size_ = current_file_->size();
 
+  if (index_enabled_ && !index_writer_.open(current_file_name_, index_block_bytes_.load()))
+  {
+    qWarning("Failed to open log index: %s", qPrintable(LogIndex::indexPathFor(current_file_name_)));
+  }
+
   qDebug() << "Opened log file:" << current_file_name_;
   return true;
 }
 
 void LogManager::closeLogFile()
 {
+  index_writer_.close();
+
   if (current_file_)
   {
     current_file_->close();
@@ -385,8 +879,6 @@ bool LogManager::rotateLogFile()
 
   closeLogFile();
 
-  QString new_file_name = generateLogFileName();
-
   if (QFile::exists(current_file_name_))
   {
     QString base_name = current_file_name_.left(current_file_name_.lastIndexOf('.'));
@@ -411,13 +903,18 @@ bool LogManager::rotateLogFile()
     {
       qWarning("Failed to rename log file: %s", qPrintable(current_file_name_));
     }
+    else if (QFile::exists(LogIndex::indexPathFor(current_file_name_)))
+    {
+      QFile::rename(LogIndex::indexPathFor(current_file_name_), LogIndex::indexPathFor(rotated_name));
+    }
   }
 
-  current_file_name_ = new_file_name;
+  setCurrentFileName(generateLogFileName());
 
+  // Pruning after the open counts the new file, so at most max_files_count_ files remain.
+  const bool opened = openLogFile();
   cleanupOldLogs();
-
-  return openLogFile();
+  return opened;
 }
 
 void LogManager::cleanupOldLogs()
@@ -434,10 +931,17 @@ void LogManager::cleanupOldLogs()
     return;
   }
 
-  for (int i = 0; i < files_to_delete && i < files.size(); ++i)
+  const QString current_path = QFileInfo(current_file_name_).absoluteFilePath();
+  for (qsizetype i = 0; i < files.size() && files_to_delete > 0; ++i)
   {
+    if (files[i].absoluteFilePath() == current_path)
+    {
+      continue;
+    }
     QFile::remove(files[i].absoluteFilePath());
+    QFile::remove(LogIndex::indexPathFor(files[i].absoluteFilePath()));
     qDebug() << "Deleted old log file:" << files[i].fileName();
+    --files_to_delete;
   }
 }
 
@@ -447,9 +951,107 @@ QString LogManager::generateLogFileName() const
   QString datetime_str = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
   QString file_name = QString("%1/%2-%3.log").arg(log_dir_).arg(app_name).arg(datetime_str);
 
+  // A restart within the same second must not append to the previous run's file.
+  for (int suffix = 1; QFile::exists(file_name) && suffix < 100; ++suffix)
+  {
+    file_name = QString("%1/%2-%3-%4.log").arg(log_dir_).arg(app_name).arg(datetime_str).arg(suffix);
+  }
+
   return file_name;
 }
 
+void LogManager::setSampling(QtMsgType level, quint32 keep_one_in, SamplingScope scope)
+{
+  const int index = levelIndex(level);
+  sample_per_site_[index] = (scope == SamplingScope::PerCallSite);
+  sample_rates_[index] = std::max<quint32>(1, keep_one_in);
+}
+
+quint32 LogManager::samplingRate(QtMsgType level) const
+{
+  return std::max<quint32>(1, sample_rates_[levelIndex(level)].load(std::memory_order_relaxed));
+}
+
+void LogManager::setSamplingSeed(quint64 seed)
+{
+  sample_seed_ = seed;
+  for (auto &counter : sample_level_counters_)
+  {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  for (auto &counter : sample_site_counters_)
+  {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  for (auto &key : sample_site_keys_)
+  {
+    key.store(0, std::memory_order_relaxed);
+  }
+}
+
+quint64 LogManager::mixSeed(quint64 value)
+{
+  // splitmix64 finalizer
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+bool LogManager::sampleKeep(QtMsgType type, const char *file, int line, quint32 &rate)
+{
+  const int index = levelIndex(type);
+  rate = sample_rates_[index].load(std::memory_order_relaxed);
+  if (rate <= 1)
+  {
+    rate = 1;
+    return true;
+  }
+
+  // Call sites are keyed by file name and line rather than by pointer so that the decision sequence is
+  // identical across runs for the same seed.
+  quint64 key = static_cast<quint64>(index);
+  std::atomic<quint64> *counter = &sample_level_counters_[index];
+  if (sample_per_site_[index].load(std::memory_order_relaxed))
+  {
+    key = 14695981039346656037ULL;
+    for (const char *p = extractFileName(file); *p != '\0'; ++p)
+    {
+      key = (key ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+    }
+    key = mixSeed(key ^ (static_cast<quint64>(static_cast<quint32>(line)) << 3) ^ static_cast<quint64>(index));
+    counter = siteCounter(key);
+  }
+
+  const quint64 phase = mixSeed(sample_seed_.load(std::memory_order_relaxed) ^ key) % rate;
+  const quint64 n = counter->fetch_add(1, std::memory_order_relaxed);
+  return (n + phase) % rate == 0;
+}
+
+std::atomic<quint64> *LogManager::siteCounter(quint64 key)
+{
+  // Open addressing with linear probing; a slot is claimed once and keeps its key until the seed is reset. Zero
+  // marks a free slot, so a site hashing to zero shares the key of one.
+  key = std::max<quint64>(key, 1);
+  const size_t size = sample_site_keys_.size();
+  const size_t home = key % size;
+  for (size_t probe = 0; probe < size; ++probe)
+  {
+    const size_t slot = (home + probe) % size;
+    quint64 stored = sample_site_keys_[slot].load(std::memory_order_acquire);
+    if (stored == 0 && sample_site_keys_[slot].compare_exchange_strong(stored, key, std::memory_order_acq_rel))
+    {
+      return &sample_site_counters_[slot];
+    }
+    if (stored == key)
+    {
+      return &sample_site_counters_[slot];
+    }
+  }
+  // More distinct sites than slots: the rest share their home slot's counter, so their 1-in-N is approximate.
+  return &sample_site_counters_[home];
+}
+
 void LogManager::setMinLevel(QtMsgType level)
 {
   min_level_ = level;
@@ -472,12 +1074,10 @@ bool LogManager::isConsoleEnabled() const
 
 void LogManager::setFileEnabled(bool enabled)
 {
-  if (enabled && (log_dir_.isEmpty() || !QDir().mkpath(log_dir_)))
+  if (!applyFileEnabled(enabled))
   {
     qWarning("Log directory unavailable, file logging remains disabled");
-    return;
   }
-  file_enabled_ = enabled;
 }
 
 bool LogManager::isFileEnabled() const
@@ -485,18 +1085,48 @@ bool LogManager::isFileEnabled() const
   return file_enabled_;
 }
 
+LogManager::Stats LogManager::stats() const
+{
+  Stats stats;
+  stats.enqueued = enqueued_count_.load(std::memory_order_relaxed);
+  stats.processed = processed_count_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_count_.load(std::memory_order_relaxed);
+  stats.queue_depth = queue_depth_.load(std::memory_order_relaxed);
+  stats.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  stats.file_bytes_written = file_bytes_written_.load(std::memory_order_relaxed);
+  stats.rotations = rotations_count_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 QString LogManager::currentLogFile() const
 {
+  std::lock_guard<std::mutex> lock(storage_mutex_);
   return current_file_name_;
 }
 
+void LogManager::setCurrentFileName(const QString &file_name)
+{
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  current_file_name_ = file_name;
+}
+
 qint64 LogManager::currentFileSize() const
 {
   return current_file_size_.load();
 }
 
+bool LogManager::isStorageReady() const
+{
+  return storage_ready_.load(std::memory_order_acquire);
+}
+
 qsizetype LogManager::fileCount() const
 {
+  if (!isStorageReady())
+  {
+    return 0;
+  }
+
   QDir log_dir(log_dir_);
   QStringList name_filters = {"*.log"};
   return log_dir.entryList(name_filters, QDir::Files).size();
@@ -0,0 +1,480 @@
+#include "qtutils/log_merger.h"
+#include "qtutils/log_line.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace QtUtils
+{
+
+class LogMergeSource
+{
+public:
+  virtual ~LogMergeSource() = default;
+
+  virtual bool open() = 0;
+  // Moves to the next entry (a timestamped line plus its continuation lines); false at end of input.
+  virtual bool advance() = 0;
+
+  const char *entryData() const
+  {
+    return entry_data_;
+  }
+
+  qint64 entryLength() const
+  {
+    return entry_length_;
+  }
+
+  qint64 key() const
+  {
+    return key_;
+  }
+
+  const QString &errorString() const
+  {
+    return error_;
+  }
+
+protected:
+  static bool startsEntry(const char *line, qint64 length)
+  {
+    return LogLine::findTimestamp(line, length) != nullptr;
+  }
+
+  void setEntry(const char *data, qint64 length)
+  {
+    entry_data_ = data;
+    entry_length_ = length;
+    key_ = LogLine::timestampKey(data, length);
+  }
+
+  const char *entry_data_{nullptr};
+  qint64 entry_length_{0};
+  qint64 key_{-1};
+  QString error_;
+};
+
+namespace
+{
+
+class MappedMergeSource final : public LogMergeSource
+{
+public:
+  MappedMergeSource(const QString &path, qint64 read_ahead)
+      : file_(path),
+        read_ahead_(read_ahead)
+  {
+  }
+
+  bool open() override
+  {
+    if (!file_.open(QIODevice::ReadOnly))
+    {
+      error_ = file_.errorString();
+      return false;
+    }
+
+    size_ = file_.size();
+    if (size_ == 0)
+    {
+      return true;
+    }
+
+    data_ = reinterpret_cast<const char *>(file_.map(0, size_));
+    if (data_ == nullptr)
+    {
+      error_ = file_.errorString();
+      return false;
+    }
+
+#ifdef Q_OS_UNIX
+    page_size_ = std::max<qint64>(4096, sysconf(_SC_PAGESIZE));
+    madvise(const_cast<char *>(data_), static_cast<size_t>(size_), MADV_SEQUENTIAL);
+#endif
+    return true;
+  }
+
+  bool advance() override
+  {
+    if (pos_ >= size_)
+    {
+      return false;
+    }
+
+    const qint64 begin = pos_;
+    qint64 end = lineEnd(begin);
+    while (end < size_)
+    {
+      const qint64 next_end = lineEnd(end);
+      if (startsEntry(data_ + end, next_end - end))
+      {
+        break;
+      }
+      end = next_end;
+    }
+
+    setEntry(data_ + begin, end - begin);
+    pos_ = end;
+    manageWindow(begin);
+    return true;
+  }
+
+private:
+  qint64 lineEnd(qint64 pos) const
+  {
+    const void *newline = std::memchr(data_ + pos, '\n', static_cast<size_t>(size_ - pos));
+    return newline != nullptr ? static_cast<const char *>(newline) - data_ + 1 : size_;
+  }
+
+  // Prefetches the next window and drops pages behind the current entry, so resident memory stays around
+  // two windows no matter how large the file is.
+  void manageWindow(qint64 entry_begin)
+  {
+#ifdef Q_OS_UNIX
+    if (pos_ < next_advice_)
+    {
+      return;
+    }
+
+    const qint64 window_begin = pos_ / page_size_ * page_size_;
+    const qint64 window_length = std::min(read_ahead_, size_ - window_begin);
+    if (window_length > 0)
+    {
+      madvise(const_cast<char *>(data_) + window_begin, static_cast<size_t>(window_length), MADV_WILLNEED);
+    }
+
+    const qint64 release_until = entry_begin / page_size_ * page_size_;
+    if (release_until > released_until_)
+    {
+      madvise(const_cast<char *>(data_) + released_until_,
+              static_cast<size_t>(release_until - released_until_),
+              MADV_DONTNEED);
+      released_until_ = release_until;
+    }
+
+    next_advice_ = pos_ + std::max<qint64>(page_size_, read_ahead_ / 2);
+#else
+    Q_UNUSED(entry_begin);
+#endif
+  }
+
+  QFile file_;
+  const char *data_{nullptr};
+  qint64 size_{0};
+  qint64 pos_{0};
+  qint64 read_ahead_;
+  qint64 page_size_{4096};
+  qint64 next_advice_{0};
+  qint64 released_until_{0};
+};
+
+class ProcessMergeSource final : public LogMergeSource
+{
+public:
+  ProcessMergeSource(const QString &program, const QString &path, qint64 chunk_bytes)
+      : program_(program),
+        path_(path),
+        chunk_bytes_(std::max<qint64>(64 * 1024, chunk_bytes))
+  {
+  }
+
+  ~ProcessMergeSource() override
+  {
+    if (process_.state() != QProcess::NotRunning)
+    {
+      process_.kill();
+      process_.waitForFinished();
+    }
+  }
+
+  bool open() override
+  {
+    process_.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process_.start(program_, QStringList{"-dc", path_}, QIODevice::ReadOnly);
+    if (!process_.waitForStarted())
+    {
+      error_ = QString("failed to start %1 for %2").arg(program_, path_);
+      return false;
+    }
+    return true;
+  }
+
+  bool advance() override
+  {
+    if (pos_ >= buffer_.size() && !fill())
+    {
+      return false;
+    }
+
+    // Offsets are relative to pos_, which fill() may move when it compacts the buffer.
+    qint64 end = 0;
+    qint64 scan = 0;
+    bool first_line = true;
+    while (true)
+    {
+      const char *data = buffer_.constData() + pos_;
+      const qint64 size = buffer_.size() - pos_;
+      const void *newline = std::memchr(data + scan, '\n', static_cast<size_t>(size - scan));
+      if (newline == nullptr)
+      {
+        if (fill())
+        {
+          continue;
+        }
+        end = (first_line || !startsEntry(data + scan, size - scan)) ? size : scan;
+        break;
+      }
+
+      const qint64 line_end = static_cast<const char *>(newline) - data + 1;
+      if (!first_line && startsEntry(data + scan, line_end - scan))
+      {
+        end = scan;
+        break;
+      }
+
+      first_line = false;
+      scan = line_end;
+      if (pos_ + scan >= buffer_.size() && !fill())
+      {
+        end = scan;
+        break;
+      }
+    }
+
+    setEntry(buffer_.constData() + pos_, end);
+    pos_ += end;
+    return true;
+  }
+
+private:
+  bool fill()
+  {
+    while (!eof_)
+    {
+      if (process_.bytesAvailable() > 0)
+      {
+        // Dropping the consumed prefix only once it outweighs what is left keeps the copying linear overall;
+        // removing it after every entry made large inputs quadratic.
+        if (pos_ > 0 && pos_ >= buffer_.size() - pos_)
+        {
+          buffer_.remove(0, static_cast<int>(pos_));
+          pos_ = 0;
+        }
+        buffer_.append(process_.read(chunk_bytes_));
+        return true;
+      }
+
+      if (process_.state() == QProcess::NotRunning || !process_.waitForReadyRead(-1))
+      {
+        if (process_.bytesAvailable() > 0)
+        {
+          continue;
+        }
+
+        eof_ = true;
+        process_.waitForFinished();
+        if (process_.exitStatus() != QProcess::NormalExit || process_.exitCode() != 0)
+        {
+          error_ = QString("%1 failed to decompress %2").arg(program_, path_);
+        }
+      }
+    }
+    return false;
+  }
+
+  QProcess process_;
+  QString program_;
+  QString path_;
+  qint64 chunk_bytes_;
+  QByteArray buffer_;
+  qint64 pos_{0};
+  bool eof_{false};
+};
+
+QString decompressorFor(const QString &path)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return {};
+  }
+
+  const QByteArray magic = file.read(4);
+  if (magic.startsWith("\x1f\x8b"))
+  {
+    return QStringLiteral("gzip");
+  }
+  if (magic == QByteArray("\x28\xb5\x2f\xfd", 4))
+  {
+    return QStringLiteral("zstd");
+  }
+  return {};
+}
+
+} // namespace
+
+LogMerger::LogMerger() = default;
+
+LogMerger::~LogMerger() = default;
+
+void LogMerger::setReadAheadBytes(qint64 bytes)
+{
+  read_ahead_bytes_ = std::max<qint64>(64 * 1024, bytes);
+}
+
+void LogMerger::setOutputBufferBytes(qint64 bytes)
+{
+  output_buffer_bytes_ = std::max<qint64>(4 * 1024, bytes);
+}
+
+bool LogMerger::addInput(const QString &path)
+{
+  std::unique_ptr<LogMergeSource> source;
+  const QString decompressor = decompressorFor(path);
+  if (decompressor.isEmpty())
+  {
+    source = std::make_unique<MappedMergeSource>(path, read_ahead_bytes_);
+  }
+  else
+  {
+    const QString program = QStandardPaths::findExecutable(decompressor);
+    if (program.isEmpty())
+    {
+      error_string_ = QString("%1 is required to read %2").arg(decompressor, path);
+      return false;
+    }
+    source = std::make_unique<ProcessMergeSource>(program, path, read_ahead_bytes_);
+  }
+
+  if (!source->open())
+  {
+    error_string_ = QString("%1: %2").arg(path, source->errorString());
+    return false;
+  }
+
+  sources_.push_back(std::move(source));
+  return true;
+}
+
+qsizetype LogMerger::inputCount() const
+{
+  return static_cast<qsizetype>(sources_.size());
+}
+
+bool LogMerger::merge(QIODevice &output)
+{
+  entries_written_ = 0;
+  bytes_written_ = 0;
+
+  // Ties on the timestamp resolve to the lower input index, which keeps the merge deterministic.
+  using HeapItem = std::pair<qint64, size_t>;
+  std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+
+  for (size_t i = 0; i < sources_.size(); ++i)
+  {
+    if (sources_[i]->advance())
+    {
+      heap.push({sources_[i]->key(), i});
+    }
+  }
+
+  QByteArray buffer;
+  buffer.reserve(static_cast<int>(output_buffer_bytes_));
+
+  auto flushBuffer = [&]()
+  {
+    if (buffer.isEmpty())
+    {
+      return true;
+    }
+    if (output.write(buffer) != buffer.size())
+    {
+      error_string_ = output.errorString();
+      return false;
+    }
+    bytes_written_ += buffer.size();
+    buffer.resize(0);
+    return true;
+  };
+
+  while (!heap.empty())
+  {
+    const size_t index = heap.top().second;
+    heap.pop();
+
+    LogMergeSource &source = *sources_[index];
+    buffer.append(source.entryData(), static_cast<int>(source.entryLength()));
+    if (source.entryLength() > 0 && source.entryData()[source.entryLength() - 1] != '\n')
+    {
+      buffer.append('\n');
+    }
+    ++entries_written_;
+
+    if (buffer.size() >= output_buffer_bytes_ && !flushBuffer())
+    {
+      return false;
+    }
+
+    if (source.advance())
+    {
+      heap.push({source.key(), index});
+    }
+  }
+
+  if (!flushBuffer())
+  {
+    return false;
+  }
+
+  for (const auto &source : sources_)
+  {
+    if (!source->errorString().isEmpty())
+    {
+      error_string_ = source->errorString();
+      return false;
+    }
+  }
+  return true;
+}
+
+qint64 LogMerger::entriesWritten() const
+{
+  return entries_written_;
+}
+
+qint64 LogMerger::bytesWritten() const
+{
+  return bytes_written_;
+}
+
+QString LogMerger::errorString() const
+{
+  return error_string_;
+}
+
+QStringList LogMerger::findLogFiles(const QString &dir_path)
+{
+  QStringList files;
+  const QDir dir(dir_path);
+  const QStringList patterns{"*.log", "*.log.gz", "*.log.zst"};
+  for (const QFileInfo &info : dir.entryInfoList(patterns, QDir::Files, QDir::Name))
+  {
+    files.append(info.absoluteFilePath());
+  }
+  return files;
+}
+
+} // namespace QtUtils
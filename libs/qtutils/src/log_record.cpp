@@ -0,0 +1,167 @@
+#include "qtutils/log_record.h"
+#include "qtutils/log_manager.h"
+#include <QDateTime>
+#include <QHash>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace QtUtils
+{
+
+namespace
+{
+
+constexpr quint32 kMaxKeys = 4096;
+
+// Names are published once and never freed, so the worker can resolve ids without taking the lock.
+struct KeyRegistry
+{
+  std::mutex mutex;
+  QHash<QByteArray, quint32> ids;
+  std::atomic<const QByteArray *> names[kMaxKeys]{};
+  quint32 count{1};
+};
+
+KeyRegistry &keyRegistry()
+{
+  static KeyRegistry registry;
+  return registry;
+}
+
+quint32 internKey(const QByteArray &name)
+{
+  KeyRegistry &registry = keyRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto it = registry.ids.constFind(name);
+    if (it != registry.ids.constEnd())
+    {
+      return it.value();
+    }
+
+    if (registry.count < kMaxKeys)
+    {
+      const quint32 id = registry.count++;
+      registry.names[id].store(new QByteArray(name), std::memory_order_release);
+      registry.ids.insert(name, id);
+      return id;
+    }
+  }
+
+  // Outside the lock: the warning goes through LogManager like any other message.
+  static std::atomic<bool> warned{false};
+  if (!warned.exchange(true))
+  {
+    qWarning("Log field key limit of %u reached, \"%s\" and later new keys are written as \"_\"",
+             kMaxKeys - 1,
+             name.constData());
+  }
+  return 0;
+}
+
+} // namespace
+
+LogKey::LogKey(const char *name)
+    : id_(internKey(QByteArray(name)))
+{
+}
+
+LogKey::LogKey(const QByteArray &name)
+    : id_(internKey(name))
+{
+}
+
+LogKey::LogKey(quint32 id)
+    : id_(id)
+{
+}
+
+LogKey LogKey::cached(const char *name)
+{
+  thread_local QHash<const char *, quint32> ids;
+  auto it = ids.constFind(name);
+  // The pointer may since hold a different string; comparing with the interned name catches that.
+  if (it != ids.constEnd() && std::strcmp(nameOf(it.value()).constData(), name) == 0)
+  {
+    return LogKey(it.value());
+  }
+
+  // Bounded in case names are built at runtime rather than being literals.
+  if (ids.size() >= static_cast<int>(kMaxKeys))
+  {
+    ids.clear();
+  }
+  const quint32 id = internKey(QByteArray(name));
+  ids.insert(name, id);
+  return LogKey(id);
+}
+
+quint32 LogKey::id() const
+{
+  return id_;
+}
+
+QByteArray LogKey::name() const
+{
+  return nameOf(id_);
+}
+
+const QByteArray &LogKey::nameOf(quint32 id)
+{
+  static const QByteArray overflow_name("_");
+  if (id >= kMaxKeys)
+  {
+    return overflow_name;
+  }
+
+  const QByteArray *name = keyRegistry().names[id].load(std::memory_order_acquire);
+  return name != nullptr ? *name : overflow_name;
+}
+
+LogRecord::LogRecord(QtMsgType level, const char *file, int line, const char *function)
+    : level_(level),
+      file_(file),
+      line_(line),
+      function_(function)
+{
+  active_ = LogManager::instance().accepts(level, file, line, sample_rate_);
+  if (active_)
+  {
+    timestamp_ms_ = QDateTime::currentMSecsSinceEpoch();
+  }
+}
+
+LogRecord::~LogRecord()
+{
+  if (active_)
+  {
+    LogManager::instance().submit(*this);
+  }
+}
+
+bool LogRecord::isActive() const
+{
+  return active_;
+}
+
+LogRecord &LogRecord::message(const QString &text)
+{
+  if (active_)
+  {
+    message_ = text.toUtf8();
+  }
+  return *this;
+}
+
+LogRecord &LogRecord::message(const char *text)
+{
+  if (active_)
+  {
+    message_ = QByteArray(text);
+  }
+  return *this;
+}
+
+} // namespace QtUtils
@@ -0,0 +1,143 @@
+#include "qtutils/config_cache.h"
+#include <QFile>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestConfigCache : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void testCachePath();
+  void testWriteAndRead();
+  void testStaleCache();
+  void testChangedBeforeWrite();
+  void testTruncatedCache();
+
+private:
+  static QHash<QString, QVariant> parse(const QString &ini_file);
+  static void writeIni(const QString &ini_file);
+};
+
+QHash<QString, QVariant> TestConfigCache::parse(const QString &ini_file)
+{
+  QSettings settings(ini_file, QSettings::IniFormat);
+  QHash<QString, QVariant> values;
+  for (const QString &key : settings.allKeys())
+  {
+    values.insert(key, settings.value(key));
+  }
+  return values;
+}
+
+void TestConfigCache::writeIni(const QString &ini_file)
+{
+  QSettings settings(ini_file, QSettings::IniFormat);
+  settings.setValue(QStringLiteral("app/title"), QStringLiteral("Ünïcode title"));
+  settings.setValue(QStringLiteral("app/count"), 42);
+  settings.setValue(QStringLiteral("app/empty"), QString());
+  settings.setValue(QStringLiteral("sensors/names"), QStringList{"lidar0", "lidar1"});
+  settings.setValue(QStringLiteral("sensors/rate"), 10.5);
+  settings.sync();
+}
+
+void TestConfigCache::testCachePath()
+{
+  QCOMPARE(QtUtils::ConfigCache::cachePathFor(QStringLiteral("/tmp/config.ini")),
+           QStringLiteral("/tmp/config.ini.cache"));
+}
+
+void TestConfigCache::testWriteAndRead()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString ini_file = dir.filePath(QStringLiteral("config.ini"));
+  writeIni(ini_file);
+
+  QtUtils::ConfigCache::Stamp stamp{};
+  QVERIFY(QtUtils::ConfigCache::stampOf(ini_file, stamp));
+  QVERIFY(!QtUtils::ConfigCache::isFresh(ini_file, stamp));
+
+  const QHash<QString, QVariant> parsed = parse(ini_file);
+  QVERIFY(QtUtils::ConfigCache::write(ini_file, stamp, parsed));
+  QVERIFY(QtUtils::ConfigCache::isFresh(ini_file, stamp));
+
+  QHash<QString, QVariant> cached;
+  QVERIFY(QtUtils::ConfigCache::read(ini_file, cached));
+  QCOMPARE(cached.size(), parsed.size());
+  for (auto it = parsed.constBegin(); it != parsed.constEnd(); ++it)
+  {
+    QVERIFY2(cached.contains(it.key()), qPrintable(it.key()));
+    QCOMPARE(cached.value(it.key()).userType(), it.value().userType());
+    QCOMPARE(cached.value(it.key()), it.value());
+  }
+  QCOMPARE(cached.value(QStringLiteral("app/title")).toString(), QStringLiteral("Ünïcode title"));
+  QCOMPARE(cached.value(QStringLiteral("sensors/names")).toStringList(), (QStringList{"lidar0", "lidar1"}));
+}
+
+void TestConfigCache::testStaleCache()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString ini_file = dir.filePath(QStringLiteral("config.ini"));
+  writeIni(ini_file);
+
+  QtUtils::ConfigCache::Stamp stamp{};
+  QVERIFY(QtUtils::ConfigCache::stampOf(ini_file, stamp));
+  QVERIFY(QtUtils::ConfigCache::write(ini_file, stamp, parse(ini_file)));
+
+  {
+    QSettings settings(ini_file, QSettings::IniFormat);
+    settings.setValue(QStringLiteral("app/count"), 43);
+  }
+
+  QHash<QString, QVariant> cached;
+  QVERIFY(!QtUtils::ConfigCache::read(ini_file, cached));
+  QVERIFY(cached.isEmpty());
+  QVERIFY(!QtUtils::ConfigCache::isFresh(ini_file, stamp));
+
+  QFile::remove(ini_file);
+  QVERIFY(!QtUtils::ConfigCache::read(ini_file, cached));
+}
+
+void TestConfigCache::testChangedBeforeWrite()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString ini_file = dir.filePath(QStringLiteral("config.ini"));
+  writeIni(ini_file);
+
+  QtUtils::ConfigCache::Stamp stamp{};
+  QVERIFY(QtUtils::ConfigCache::stampOf(ini_file, stamp));
+  const QHash<QString, QVariant> parsed = parse(ini_file);
+  {
+    QSettings settings(ini_file, QSettings::IniFormat);
+    settings.setValue(QStringLiteral("app/count"), 43);
+  }
+
+  QVERIFY(!QtUtils::ConfigCache::write(ini_file, stamp, parsed));
+  QVERIFY(!QFile::exists(QtUtils::ConfigCache::cachePathFor(ini_file)));
+}
+
+void TestConfigCache::testTruncatedCache()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString ini_file = dir.filePath(QStringLiteral("config.ini"));
+  writeIni(ini_file);
+
+  QtUtils::ConfigCache::Stamp stamp{};
+  QVERIFY(QtUtils::ConfigCache::stampOf(ini_file, stamp));
+  QVERIFY(QtUtils::ConfigCache::write(ini_file, stamp, parse(ini_file)));
+
+  QFile cache(QtUtils::ConfigCache::cachePathFor(ini_file));
+  QVERIFY(cache.resize(cache.size() - 3));
+
+  QHash<QString, QVariant> cached;
+  QVERIFY(!QtUtils::ConfigCache::read(ini_file, cached));
+}
+
+QTEST_MAIN(TestConfigCache)
+#include "test_config_cache.moc"
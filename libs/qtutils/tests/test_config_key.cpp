@@ -0,0 +1,176 @@
+#include "qtutils/common_utils.h"
+#include "qtutils/config_cache.h"
+#include "qtutils/config_key.h"
+#include "qtutils/config_manager.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QTest>
+#include <QThread>
+
+class TestConfigKey : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void init();
+
+  void testDefault();
+  void testGet();
+  void testTypes();
+  void testInvalidValue();
+  void testClamp();
+  void testRefreshOnChange();
+  void testPerThreadCache();
+
+private:
+  QString original_app_name_;
+  QString config_file_path_;
+};
+
+void TestConfigKey::initTestCase()
+{
+  original_app_name_ = QCoreApplication::applicationName();
+  QCoreApplication::setApplicationName(QStringLiteral("test-config-key"));
+
+  config_file_path_ = QtUtils::CommonUtils::getAppConfigDirPath() + QDir::separator() + QStringLiteral("config.ini");
+  QFile::remove(config_file_path_);
+  QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
+}
+
+void TestConfigKey::cleanupTestCase()
+{
+  if (!config_file_path_.isEmpty())
+  {
+    QFile::remove(config_file_path_);
+    QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
+  }
+  QCoreApplication::setApplicationName(original_app_name_);
+}
+
+void TestConfigKey::init()
+{
+  QtUtils::ConfigManager::instance().remove(QStringLiteral("key"));
+}
+
+void TestConfigKey::testDefault()
+{
+  const QtUtils::ConfigKey<int> key(QStringLiteral("key/missing"), 17);
+  QCOMPARE(key.key(), QStringLiteral("key/missing"));
+  QCOMPARE(key.get(), 17);
+  QCOMPARE(key.defaultValue().toInt(), 17);
+}
+
+void TestConfigKey::testGet()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  const QtUtils::ConfigKey<int> key(QStringLiteral("key/int"), 0);
+
+  config.setValue(QStringLiteral("key/int"), 42);
+  QCOMPARE(key.get(), 42);
+
+  config.setValue(QStringLiteral("key/int"), 43);
+  QCOMPARE(key.get(), 43);
+
+  config.remove(QStringLiteral("key/int"));
+  QCOMPARE(key.get(), 0);
+}
+
+void TestConfigKey::testTypes()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  const QtUtils::ConfigKey<QString> text(QStringLiteral("key/text"), QStringLiteral("none"));
+  const QtUtils::ConfigKey<double> number(QStringLiteral("key/double"), 0.0);
+  const QtUtils::ConfigKey<bool> flag(QStringLiteral("key/bool"), false);
+
+  config.setValue(QStringLiteral("key/text"), QStringLiteral("hello"));
+  config.setValue(QStringLiteral("key/double"), QStringLiteral("2.5"));
+  config.setValue(QStringLiteral("key/bool"), QStringLiteral("true"));
+
+  QCOMPARE(text.get(), QStringLiteral("hello"));
+  QCOMPARE(number.get(), 2.5);
+  QCOMPARE(flag.get(), true);
+}
+
+void TestConfigKey::testInvalidValue()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  const QtUtils::ConfigKey<int> key(QStringLiteral("key/invalid"), 5);
+  const QtUtils::ConfigKey<qint8> narrow(QStringLiteral("key/narrow"), 1);
+
+  config.setValue(QStringLiteral("key/invalid"), QStringLiteral("not a number"));
+  QCOMPARE(key.get(), 5);
+
+  config.setValue(QStringLiteral("key/narrow"), 1000);
+  QCOMPARE(narrow.get(), qint8(1));
+}
+
+void TestConfigKey::testClamp()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  const QtUtils::ConfigKey<int> key(QStringLiteral("key/clamped"), 0, QtUtils::ConfigKey<int>::clamp(0, 4));
+
+  config.setValue(QStringLiteral("key/clamped"), 9);
+  QCOMPARE(key.get(), 4);
+
+  config.setValue(QStringLiteral("key/clamped"), -3);
+  QCOMPARE(key.get(), 0);
+
+  config.setValue(QStringLiteral("key/clamped"), 2);
+  QCOMPARE(key.get(), 2);
+}
+
+void TestConfigKey::testRefreshOnChange()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  int loads = 0;
+  const QtUtils::ConfigKey<int> key(QStringLiteral("key/watched"),
+                                    0,
+                                    [&loads](const int &value)
+                                    {
+                                      ++loads;
+                                      return value;
+                                    });
+
+  config.setValue(QStringLiteral("key/watched"), 1);
+  QCOMPARE(key.get(), 1);
+  QCOMPARE(key.get(), 1);
+  QCOMPARE(loads, 1);
+
+  // Other keys and rewrites of the same value leave the cached value alone.
+  config.setValue(QStringLiteral("key/other"), 2);
+  config.setValue(QStringLiteral("key/watched"), 1);
+  QCOMPARE(key.get(), 1);
+  QCOMPARE(loads, 1);
+
+  config.setValue(QStringLiteral("key/watched"), 3);
+  QCOMPARE(key.get(), 3);
+  QCOMPARE(loads, 2);
+}
+
+void TestConfigKey::testPerThreadCache()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  const QtUtils::ConfigKey<QString> key(QStringLiteral("key/shared"), QString());
+  config.setValue(QStringLiteral("key/shared"), QStringLiteral("first"));
+  QCOMPARE(key.get(), QStringLiteral("first"));
+
+  QString seen;
+  QThread *thread = QThread::create(
+      [&key, &seen]()
+      {
+        seen = key.get();
+      });
+  thread->start();
+  QVERIFY(thread->wait(30000));
+  delete thread;
+  QCOMPARE(seen, QStringLiteral("first"));
+
+  config.setValue(QStringLiteral("key/shared"), QStringLiteral("second"));
+  QCOMPARE(key.get(), QStringLiteral("second"));
+}
+
+QTEST_MAIN(TestConfigKey)
+#include "test_config_key.moc"
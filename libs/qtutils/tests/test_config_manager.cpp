@@ -1,9 +1,17 @@
 #include "qtutils/common_utils.h"
+#include "qtutils/config_cache.h"
 #include "qtutils/config_manager.h"
 #include <QCoreApplication>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QSettings>
 #include <QTest>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class TestConfigManager : public QObject
 {
@@ -26,6 +34,13 @@ private slots:
   void testSave();
   void testRemove();
   void testPersistence();
+  void testDefaultPrecedence();
+  void testConcurrentReads();
+  void testSubscribe();
+  void testWatchReload();
+  void testWriteBehind();
+  void testTransaction();
+  void testGroup();
 
 private:
   QString original_app_name_;
@@ -39,6 +54,7 @@ void TestConfigManager::initTestCase()
 
   config_file_path_ = QtUtils::CommonUtils::getAppConfigDirPath() + QDir::separator() + QStringLiteral("config.ini");
   QFile::remove(config_file_path_);
+  QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
 }
 
 void TestConfigManager::cleanupTestCase()
@@ -46,6 +62,7 @@ void TestConfigManager::cleanupTestCase()
   if (!config_file_path_.isEmpty())
   {
     QFile::remove(config_file_path_);
+    QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
   }
   QCoreApplication::setApplicationName(original_app_name_);
 }
@@ -62,6 +79,13 @@ void TestConfigManager::init()
   config.remove(QStringLiteral("test/remove_key"));
   config.remove(QStringLiteral("test/persist"));
   config.remove(QStringLiteral("test/external"));
+  config.remove(QStringLiteral("test/registered"));
+  config.remove(QStringLiteral("test/counter"));
+  config.remove(QStringLiteral("test/watched"));
+  config.remove(QStringLiteral("test/behind"));
+  config.remove(QStringLiteral("sub"));
+  config.remove(QStringLiteral("tx"));
+  config.remove(QStringLiteral("sensors"));
 }
 
 void TestConfigManager::testInstance()
@@ -171,8 +195,311 @@ void TestConfigManager::testPersistence()
   settings.setValue(QStringLiteral("test/external"), QStringLiteral("external_write"));
   settings.sync();
 
+  QVERIFY(config.reload());
   QCOMPARE(config.stringValue(QStringLiteral("test/external")), QStringLiteral("external_write"));
 }
 
+void TestConfigManager::testDefaultPrecedence()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.registerDefaults({{QStringLiteral("test/registered"), 7}});
+  QCOMPARE(config.intValue(QStringLiteral("test/registered")), 7);
+
+  config.setValue(QStringLiteral("test/registered"), 8);
+  QCOMPARE(config.value(QStringLiteral("test/registered"), 9).toInt(), 8);
+
+  // Without a stored value an explicit default wins over the registered one.
+  config.remove(QStringLiteral("test/registered"));
+  QCOMPARE(config.value(QStringLiteral("test/registered"), 9).toInt(), 9);
+  QCOMPARE(config.intValue(QStringLiteral("test/registered")), 7);
+}
+
+void TestConfigManager::testConcurrentReads()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.setValue(QStringLiteral("test/counter"), 0);
+
+  const int num_threads = 4;
+  const int last_value = 2000;
+  std::atomic<bool> stop{false};
+  std::atomic<int> out_of_order{0};
+
+  QThread *threads[num_threads];
+  for (int t = 0; t < num_threads; ++t)
+  {
+    threads[t] = QThread::create(
+        [&config, &stop, &out_of_order]()
+        {
+          int previous = 0;
+          while (!stop.load(std::memory_order_acquire))
+          {
+            const int current = config.intValue(QStringLiteral("test/counter"), -1);
+            if (current < previous)
+            {
+              out_of_order.fetch_add(1);
+            }
+            previous = current;
+          }
+        });
+    threads[t]->start();
+  }
+
+  for (int i = 1; i <= last_value; ++i)
+  {
+    config.setValue(QStringLiteral("test/counter"), i);
+  }
+  stop.store(true, std::memory_order_release);
+
+  for (int t = 0; t < num_threads; ++t)
+  {
+    QVERIFY(threads[t]->wait(30000));
+    delete threads[t];
+  }
+
+  QCOMPARE(out_of_order.load(), 0);
+  QCOMPARE(config.intValue(QStringLiteral("test/counter")), last_value);
+}
+
+void TestConfigManager::testSubscribe()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  QList<QStringList> exact_calls;
+  QList<QStringList> group_calls;
+  const int exact = config.subscribe({QStringLiteral("sub/level")},
+                                     [&exact_calls](const QStringList &keys)
+                                     {
+                                       exact_calls.append(keys);
+                                     });
+  const int group = config.subscribe({QStringLiteral("sub/")},
+                                     [&group_calls](const QStringList &keys)
+                                     {
+                                       group_calls.append(keys);
+                                     });
+
+  config.setValue(QStringLiteral("sub/level"), 2);
+  config.setValue(QStringLiteral("sub/enabled"), true);
+  config.setValue(QStringLiteral("other/key"), 1);
+  // Rewriting the same value is not a change.
+  config.setValue(QStringLiteral("sub/level"), 2);
+
+  QCOMPARE(exact_calls.size(), 1);
+  QCOMPARE(exact_calls[0], QStringList{QStringLiteral("sub/level")});
+  QCOMPARE(group_calls.size(), 2);
+  QCOMPARE(group_calls[1], QStringList{QStringLiteral("sub/enabled")});
+
+  config.remove(QStringLiteral("sub"));
+  QCOMPARE(group_calls.size(), 3);
+  QCOMPARE(group_calls[2], (QStringList{QStringLiteral("sub/enabled"), QStringLiteral("sub/level")}));
+
+  config.unsubscribe(exact);
+  config.unsubscribe(group);
+  config.remove(QStringLiteral("other"));
+  config.setValue(QStringLiteral("sub/level"), 3);
+  QCOMPARE(exact_calls.size(), 2);
+  QCOMPARE(group_calls.size(), 3);
+
+  // unsubscribe() waits for a callback running on another thread, and none runs after it returns.
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  const int slow = config.subscribe({QStringLiteral("sub/slow")},
+                                    [&started, &finished](const QStringList &)
+                                    {
+                                      started.store(true);
+                                      QThread::msleep(100);
+                                      finished.store(true);
+                                    });
+  QThread *writer = QThread::create(
+      [&config]()
+      {
+        config.setValue(QStringLiteral("sub/slow"), 1);
+      });
+  writer->start();
+  QTRY_VERIFY(started.load());
+  config.unsubscribe(slow);
+  QVERIFY(finished.load());
+  writer->wait();
+  delete writer;
+  config.remove(QStringLiteral("sub"));
+}
+
+void TestConfigManager::testWatchReload()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.setValue(QStringLiteral("test/watched"), QStringLiteral("before"));
+  QVERIFY(config.save());
+
+  struct Seen
+  {
+    std::mutex mutex;
+    QStringList keys;
+  };
+  auto seen = std::make_shared<Seen>();
+  const int id = config.subscribe({QStringLiteral("test/watched")},
+                                  [seen](const QStringList &keys)
+                                  {
+                                    std::lock_guard<std::mutex> lock(seen->mutex);
+                                    seen->keys += keys;
+                                  });
+  QVERIFY(config.startWatching(50));
+  QVERIFY(config.isWatching());
+
+  QSettings settings(config_file_path_, QSettings::IniFormat);
+  settings.setValue(QStringLiteral("test/watched"), QStringLiteral("after"));
+  settings.sync();
+
+  QTRY_COMPARE(config.stringValue(QStringLiteral("test/watched")), QStringLiteral("after"));
+  auto notified = [seen]()
+  {
+    std::lock_guard<std::mutex> lock(seen->mutex);
+    return seen->keys.contains(QStringLiteral("test/watched"));
+  };
+  QTRY_VERIFY(notified());
+
+  config.stopWatching();
+  QVERIFY(!config.isWatching());
+  config.unsubscribe(id);
+}
+
+void TestConfigManager::testWriteBehind()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  QVERIFY(config.save());
+  auto stored = [this]()
+  {
+    QSettings settings(config_file_path_, QSettings::IniFormat);
+    return settings.value(QStringLiteral("test/behind")).toInt();
+  };
+
+  config.setWriteBehind(30);
+  QCOMPARE(config.writeBehind(), 30);
+  for (int i = 1; i <= 5; ++i)
+  {
+    config.setValue(QStringLiteral("test/behind"), i);
+  }
+  QTRY_COMPARE(stored(), 5);
+
+  // save() is a barrier even while a write is pending.
+  config.setWriteBehind(60000);
+  config.setValue(QStringLiteral("test/behind"), 6);
+  QVERIFY(config.save());
+  QCOMPARE(stored(), 6);
+
+  // Turning write-behind off flushes what is still pending.
+  config.setValue(QStringLiteral("test/behind"), 7);
+  config.setWriteBehind(0);
+  QCOMPARE(config.writeBehind(), 0);
+  QCOMPARE(stored(), 7);
+
+  // The atomic replace leaves no temporary files behind; the binary cache refreshed after each flush is expected.
+  const QFileInfo info(config_file_path_);
+  QStringList files = info.dir().entryList({info.fileName() + QStringLiteral("*")}, QDir::Files);
+  files.removeAll(QFileInfo(QtUtils::ConfigCache::cachePathFor(config_file_path_)).fileName());
+  QCOMPARE(files, QStringList{info.fileName()});
+}
+
+void TestConfigManager::testTransaction()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.setValue(QStringLiteral("tx/old"), 1);
+
+  std::vector<QStringList> notifications;
+  const int id = config.subscribe({QStringLiteral("tx/")},
+                                  [&notifications](const QStringList &keys)
+                                  {
+                                    notifications.push_back(keys);
+                                  });
+
+  {
+    auto discarded = config.begin();
+    discarded.set(QStringLiteral("tx/a"), 1);
+  }
+  QVERIFY(!config.value(QStringLiteral("tx/a")).isValid());
+
+  auto tx = config.begin();
+  tx.set(QStringLiteral("tx/a"), 10);
+  tx.set(QStringLiteral("tx/b"), 20);
+  tx.set(QStringLiteral("tx/a"), 11);
+  tx.remove(QStringLiteral("tx/old"));
+  QVERIFY(!config.value(QStringLiteral("tx/b")).isValid());
+  QCOMPARE(config.intValue(QStringLiteral("tx/old")), 1);
+  QVERIFY(notifications.empty());
+
+  QVERIFY(tx.commit());
+  QCOMPARE(config.intValue(QStringLiteral("tx/a")), 11);
+  QCOMPARE(config.intValue(QStringLiteral("tx/b")), 20);
+  QVERIFY(!config.value(QStringLiteral("tx/old")).isValid());
+  QCOMPARE(notifications.size(), size_t(1));
+  QCOMPARE(notifications.front(), (QStringList{"tx/a", "tx/b", "tx/old"}));
+
+  QSettings settings(config_file_path_, QSettings::IniFormat);
+  QCOMPARE(settings.value(QStringLiteral("tx/a")).toInt(), 11);
+  QCOMPARE(settings.value(QStringLiteral("tx/b")).toInt(), 20);
+  QVERIFY(!settings.contains(QStringLiteral("tx/old")));
+
+  // Committing again has nothing left to apply.
+  QVERIFY(tx.commit());
+  QCOMPARE(notifications.size(), size_t(1));
+  config.unsubscribe(id);
+}
+
+void TestConfigManager::testGroup()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  auto tx = config.begin();
+  for (int device = 0; device < 12; ++device)
+  {
+    tx.set(QStringLiteral("sensors/lidar%1/rate").arg(device), 10 + device);
+    tx.set(QStringLiteral("sensors/lidar%1/enabled").arg(device), device % 2 == 0);
+  }
+  tx.set(QStringLiteral("sensors/radar0/rate"), 20);
+  QVERIFY(tx.commit());
+
+  const auto sensors = config.group(QStringLiteral("sensors/"));
+  QCOMPARE(sensors.size(), 25);
+  const QStringList devices = sensors.childGroups();
+  QCOMPARE(devices.size(), 13);
+  QCOMPARE(devices.first(), QStringLiteral("lidar0"));
+  QCOMPARE(devices.last(), QStringLiteral("radar0"));
+
+  QCOMPARE(config.group(QStringLiteral("sensors/lidar")).size(), 24);
+  QCOMPARE(config.group(QStringLiteral("sensors/lidar1/")).size(), 2);
+
+  const auto lidar3 = sensors.group(QStringLiteral("lidar3/"));
+  QCOMPARE(lidar3.prefix(), QStringLiteral("sensors/lidar3/"));
+  QCOMPARE(lidar3.keys(), (QStringList{"enabled", "rate"}));
+  QVERIFY(lidar3.contains(QStringLiteral("rate")));
+  QCOMPARE(lidar3.value(QStringLiteral("rate")).toInt(), 13);
+  QCOMPARE(lidar3.value(QStringLiteral("missing"), 7).toInt(), 7);
+
+  const QMap<QString, int> rates = config.group(QStringLiteral("sensors/lidar1")).toMap<int>();
+  QCOMPARE(rates.value(QStringLiteral("/rate")), 11);
+  QCOMPARE(rates.value(QStringLiteral("0/rate")), 20);
+  QCOMPARE(rates.value(QStringLiteral("1/rate")), 21);
+
+  int visited = 0;
+  lidar3.forEach(
+      [&visited](const QString &key, const QVariant &value)
+      {
+        QVERIFY(key == QStringLiteral("enabled") || key == QStringLiteral("rate"));
+        QVERIFY(value.isValid());
+        ++visited;
+      });
+  QCOMPARE(visited, 2);
+
+  const QVariantList values = config.values({QStringLiteral("sensors/lidar0/rate"),
+                                             QStringLiteral("sensors/missing"),
+                                             QStringLiteral("sensors/radar0/rate")});
+  QCOMPARE(values.size(), 3);
+  QCOMPARE(values[0].toInt(), 10);
+  QVERIFY(!values[1].isValid());
+  QCOMPARE(values[2].toInt(), 20);
+
+  // A view keeps reading the snapshot it was taken from.
+  config.setValue(QStringLiteral("sensors/lidar3/rate"), 99);
+  QCOMPARE(lidar3.value(QStringLiteral("rate")).toInt(), 13);
+  QCOMPARE(config.group(QStringLiteral("sensors/lidar3/")).value(QStringLiteral("rate")).toInt(), 99);
+  QVERIFY(config.group(QStringLiteral("nothing/")).isEmpty());
+}
+
 QTEST_MAIN(TestConfigManager)
 #include "test_config_manager.moc"
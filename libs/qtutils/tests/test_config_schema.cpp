@@ -0,0 +1,163 @@
+#include "qtutils/common_utils.h"
+#include "qtutils/config_cache.h"
+#include "qtutils/config_key.h"
+#include "qtutils/config_manager.h"
+#include "qtutils/config_schema.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace
+{
+
+constexpr auto kNameSpec = QtUtils::configSpec("schema/name", "lidar, front", "Device name");
+constexpr auto kEnabledSpec = QtUtils::configSpec("schema/enabled", true, "Device enabled");
+constexpr auto kRateSpec = QtUtils::configSpec("schema/rate", 10, 1, 100, "Frames per second");
+constexpr auto kGainSpec = QtUtils::configSpec("schema/tuning/gain", 0.5, 0.0, 1.0, "Amplifier gain");
+
+constexpr QtUtils::ConfigField kSchema[] = {
+    QtUtils::ConfigField::of(kNameSpec),
+    QtUtils::ConfigField::of(kEnabledSpec),
+    QtUtils::ConfigField::of(kRateSpec),
+    QtUtils::ConfigField::of(kGainSpec),
+};
+static_assert(QtUtils::ConfigSchema::isValid(kSchema), "test schema must be valid");
+static_assert(kSchema[2].type == QtUtils::ConfigField::Type::Int && kSchema[2].default_int == 10,
+              "typed at compile time");
+
+constexpr QtUtils::ConfigField kDuplicate[] = {
+    QtUtils::ConfigField::of(kRateSpec),
+    QtUtils::ConfigField::of(QtUtils::configSpec("schema/rate", 5, "Same key again")),
+};
+static_assert(!QtUtils::ConfigSchema::isValid(kDuplicate), "duplicate keys are rejected");
+
+constexpr QtUtils::ConfigField kOutOfRange[] = {
+    QtUtils::ConfigField::of(QtUtils::configSpec("schema/level", 9, 0, 4, "Default above the range")),
+};
+static_assert(!QtUtils::ConfigSchema::isValid(kOutOfRange), "defaults outside their range are rejected");
+
+constexpr QtUtils::ConfigField kUndocumented[] = {
+    QtUtils::ConfigField::of(QtUtils::configSpec("schema/flag", false, "")),
+};
+static_assert(!QtUtils::ConfigSchema::isValid(kUndocumented), "keys without a doc are rejected");
+
+constexpr QtUtils::ConfigField kPrecise[] = {
+    QtUtils::ConfigField::of(QtUtils::configSpec("precise/ratio", 0.123456789, 0.000001234567, 98765.4321, "Ratio")),
+    QtUtils::ConfigField::of(QtUtils::configSpec("precise/offset", qint64(0), qint64(-5000000000), qint64(5000000000),
+                                                 "Offset")),
+};
+static_assert(QtUtils::ConfigSchema::isValid(kPrecise), "precise schema must be valid");
+
+} // namespace
+
+class TestConfigSchema : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void testRegisterDefaults();
+  void testKeyFromSpec();
+  void testValidate();
+  void testDump();
+
+private:
+  QString original_app_name_;
+  QString config_file_path_;
+};
+
+void TestConfigSchema::initTestCase()
+{
+  original_app_name_ = QCoreApplication::applicationName();
+  QCoreApplication::setApplicationName(QStringLiteral("test-config-schema"));
+  config_file_path_ = QtUtils::CommonUtils::getAppConfigDirPath() + QDir::separator() + QStringLiteral("config.ini");
+  QFile::remove(config_file_path_);
+  QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
+  QtUtils::ConfigSchema::registerDefaults(kSchema);
+}
+
+void TestConfigSchema::cleanupTestCase()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.remove(QStringLiteral("schema"));
+  config.save();
+  // Without the file the manager has nothing to cache when it is destroyed.
+  QFile::remove(config_file_path_);
+  QFile::remove(QtUtils::ConfigCache::cachePathFor(config_file_path_));
+  QCoreApplication::setApplicationName(original_app_name_);
+}
+
+void TestConfigSchema::testRegisterDefaults()
+{
+  const QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  QCOMPARE(config.stringValue(QStringLiteral("schema/name")), QStringLiteral("lidar, front"));
+  QCOMPARE(config.boolValue(QStringLiteral("schema/enabled")), true);
+  QCOMPARE(config.intValue(QStringLiteral("schema/rate")), 10);
+  QCOMPARE(config.doubleValue(QStringLiteral("schema/tuning/gain")), 0.5);
+}
+
+void TestConfigSchema::testKeyFromSpec()
+{
+  static const QtUtils::ConfigKey<int> rate{kRateSpec};
+  QCOMPARE(rate.key(), QStringLiteral("schema/rate"));
+  QCOMPARE(rate.defaultValue().toInt(), 10);
+
+  // The spec's range clamps reads even before validate() repairs the stored value.
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  config.setValue(QStringLiteral("schema/rate"), 500);
+  QCOMPARE(rate.get(), 100);
+  config.setValue(QStringLiteral("schema/rate"), 10);
+  QCOMPARE(rate.get(), 10);
+}
+
+void TestConfigSchema::testValidate()
+{
+  QtUtils::ConfigManager &config = QtUtils::ConfigManager::instance();
+  QCOMPARE(QtUtils::ConfigSchema::validate(kSchema), 0);
+
+  config.setValue(QStringLiteral("schema/enabled"), QStringLiteral("maybe"));
+  config.setValue(QStringLiteral("schema/rate"), QStringLiteral("250"));
+  config.setValue(QStringLiteral("schema/tuning/gain"), QStringLiteral("loud"));
+  QCOMPARE(QtUtils::ConfigSchema::validate(kSchema), 3);
+
+  QCOMPARE(config.boolValue(QStringLiteral("schema/enabled")), true);
+  QCOMPARE(config.intValue(QStringLiteral("schema/rate")), 100);
+  QCOMPARE(config.doubleValue(QStringLiteral("schema/tuning/gain")), 0.5);
+  QCOMPARE(QtUtils::ConfigSchema::validate(kSchema), 0);
+}
+
+void TestConfigSchema::testDump()
+{
+  const QString ini = QtUtils::ConfigSchema::dump(kSchema);
+  QVERIFY(ini.startsWith(QStringLiteral("[schema]\n")));
+  QVERIFY(ini.contains(QStringLiteral("; Frames per second\n; type: int, range: 1..100\nrate=10\n")));
+  QVERIFY(ini.contains(QStringLiteral("; type: double, range: 0..1\n")));
+
+  // The dump is a valid config file holding every default.
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString file_path = dir.filePath(QStringLiteral("schema.ini"));
+  QFile file(file_path);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(ini.toUtf8());
+  file.close();
+
+  QSettings settings(file_path, QSettings::IniFormat);
+  QCOMPARE(settings.value(QStringLiteral("schema/name")).toString(), QStringLiteral("lidar, front"));
+  QCOMPARE(settings.value(QStringLiteral("schema/enabled")).toBool(), true);
+  QCOMPARE(settings.value(QStringLiteral("schema/rate")).toInt(), 10);
+  QCOMPARE(settings.value(QStringLiteral("schema/tuning/gain")).toDouble(), 0.5);
+
+  // Doubles and wide integer ranges are written in full, not rounded to 6 digits.
+  const QString precise = QtUtils::ConfigSchema::dump(kPrecise);
+  QVERIFY(precise.contains(QStringLiteral("; type: double, range: 1.234567e-06..98765.4321\nratio=0.123456789\n")));
+  QVERIFY(precise.contains(QStringLiteral("; type: int, range: -5000000000..5000000000\noffset=0\n")));
+}
+
+QTEST_MAIN(TestConfigSchema)
+#include "test_config_schema.moc"
@@ -0,0 +1,259 @@
+#include "qtutils/config_shm.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTest>
+#include <QThread>
+#include <atomic>
+#include <memory>
+
+class TestConfigShm : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanupTestCase();
+
+  void testNameFor();
+  void testWriteAndRead();
+  void testSingleWriter();
+  void testMissingSegment();
+  void testCapacity();
+  void testConsistentReads();
+  void testWriterRestart();
+  void testRemove();
+
+private:
+  static QString segmentName(const char *tag);
+  static std::vector<QtUtils::ConfigShm::Item> makeItems(int count, int value);
+};
+
+void TestConfigShm::init()
+{
+#if !defined(Q_OS_UNIX)
+  QSKIP("shared config needs POSIX shared memory");
+#endif
+}
+
+void TestConfigShm::cleanupTestCase()
+{
+  // Segments outlive their writers, so each one a test made is deleted here.
+  for (const char *tag : {"rw", "single", "capacity", "seqlock", "restart", "remove"})
+  {
+    QtUtils::ConfigShm::remove(segmentName(tag));
+  }
+}
+
+QString TestConfigShm::segmentName(const char *tag)
+{
+  return QStringLiteral("/qtutils-test-%1-%2").arg(QCoreApplication::applicationPid()).arg(QLatin1String(tag));
+}
+
+std::vector<QtUtils::ConfigShm::Item> TestConfigShm::makeItems(int count, int value)
+{
+  std::vector<QtUtils::ConfigShm::Item> items;
+  for (int i = 0; i < count; ++i)
+  {
+    items.push_back({QStringLiteral("sensors/lidar%1/rate").arg(i), QString::number(value), false});
+  }
+  return items;
+}
+
+void TestConfigShm::testNameFor()
+{
+  const QString name = QtUtils::ConfigShm::nameFor(QStringLiteral("/home/user/.config/app/config.ini"));
+  QVERIFY(name.startsWith('/'));
+  QVERIFY(name.size() <= 31);
+  QCOMPARE(QtUtils::ConfigShm::nameFor(QStringLiteral("/home/user/.config/app/config.ini")), name);
+  QVERIFY(QtUtils::ConfigShm::nameFor(QStringLiteral("/home/user/.config/other/config.ini")) != name);
+}
+
+void TestConfigShm::testWriteAndRead()
+{
+  const QString name = segmentName("rw");
+  QtUtils::ConfigShm writer;
+  QVERIFY2(writer.create(name, 64 * 1024), qPrintable(writer.errorString()));
+  QVERIFY(writer.isWriter());
+
+  const std::vector<QtUtils::ConfigShm::Item> items = {
+      {QStringLiteral("app/title"), QStringLiteral("Ünïcode title"), false},
+      {QStringLiteral("app/names"), QStringList{"a", "b"}, false},
+      {QStringLiteral("app/count"), 42, true},
+      {QStringLiteral("app/unset"), QVariant(), false},
+  };
+  QVERIFY(writer.write(items));
+
+  QtUtils::ConfigShm reader;
+  QVERIFY2(reader.open(name), qPrintable(reader.errorString()));
+  QVERIFY(!reader.isWriter());
+
+  std::vector<QtUtils::ConfigShm::Item> read;
+  quint64 sequence = 0;
+  QVERIFY(reader.read(read, sequence));
+  QCOMPARE(read.size(), items.size());
+  for (size_t i = 0; i < items.size(); ++i)
+  {
+    QCOMPARE(read[i].key, items[i].key);
+    QCOMPARE(read[i].value, items[i].value);
+    QCOMPARE(read[i].is_default, items[i].is_default);
+  }
+  QCOMPARE(sequence % 2, quint64(0));
+  QCOMPARE(reader.sequence()->load(), sequence);
+
+  QVERIFY(writer.write(makeItems(3, 7)));
+  QVERIFY(reader.sequence()->load() != sequence);
+  QVERIFY(reader.read(read, sequence));
+  QCOMPARE(read.size(), size_t(3));
+  QCOMPARE(read[2].value.toString(), QStringLiteral("7"));
+
+  // A reader cannot write.
+  QVERIFY(!reader.write(items));
+}
+
+void TestConfigShm::testSingleWriter()
+{
+  const QString name = segmentName("single");
+  QtUtils::ConfigShm first;
+  QVERIFY(first.create(name, 4096));
+
+  QtUtils::ConfigShm second;
+  QVERIFY(!second.create(name, 4096));
+  QVERIFY(!second.errorString().isEmpty());
+
+  // Closing the writer frees the name for the next one.
+  first.close();
+  QVERIFY(second.create(name, 4096));
+}
+
+void TestConfigShm::testMissingSegment()
+{
+  QtUtils::ConfigShm reader;
+  QVERIFY(!reader.open(segmentName("missing")));
+  QVERIFY(!reader.isOpen());
+
+  std::vector<QtUtils::ConfigShm::Item> items;
+  quint64 sequence = 0;
+  QVERIFY(!reader.read(items, sequence));
+}
+
+void TestConfigShm::testCapacity()
+{
+  const QString name = segmentName("capacity");
+  QtUtils::ConfigShm writer;
+  QVERIFY(writer.create(name, 1024));
+  QVERIFY(writer.write(makeItems(2, 1)));
+  QVERIFY(!writer.write(makeItems(100, 2)));
+
+  // The previous table stays readable.
+  QtUtils::ConfigShm reader;
+  QVERIFY(reader.open(name));
+  std::vector<QtUtils::ConfigShm::Item> items;
+  quint64 sequence = 0;
+  QVERIFY(reader.read(items, sequence));
+  QCOMPARE(items.size(), size_t(2));
+}
+
+void TestConfigShm::testConsistentReads()
+{
+  const QString name = segmentName("seqlock");
+  QtUtils::ConfigShm writer;
+  QVERIFY(writer.create(name, 256 * 1024));
+  QVERIFY(writer.write(makeItems(64, 0)));
+
+  QtUtils::ConfigShm reader;
+  QVERIFY(reader.open(name));
+
+  std::atomic<bool> stop{false};
+  QThread *thread = QThread::create(
+      [&writer, &stop]()
+      {
+        for (int value = 1; !stop.load(); ++value)
+        {
+          writer.write(makeItems(64, value));
+        }
+      });
+  thread->start();
+
+  // Every table read must come from a single write: all values equal.
+  int torn = 0;
+  int reads = 0;
+  for (int i = 0; i < 2000; ++i)
+  {
+    std::vector<QtUtils::ConfigShm::Item> items;
+    quint64 sequence = 0;
+    if (!reader.read(items, sequence))
+    {
+      continue;
+    }
+    ++reads;
+    for (const auto &item : items)
+    {
+      if (item.value != items.front().value)
+      {
+        ++torn;
+        break;
+      }
+    }
+  }
+  stop.store(true);
+  thread->wait();
+  delete thread;
+
+  QVERIFY(reads > 0);
+  QCOMPARE(torn, 0);
+}
+
+void TestConfigShm::testWriterRestart()
+{
+  const QString name = segmentName("restart");
+  auto writer = std::make_unique<QtUtils::ConfigShm>();
+  QVERIFY(writer->create(name, 4096));
+  QVERIFY(writer->write(makeItems(2, 1)));
+
+  QtUtils::ConfigShm reader;
+  QVERIFY(reader.open(name));
+  std::vector<QtUtils::ConfigShm::Item> items;
+  quint64 sequence = 0;
+
+  // A stopped writer leaves the segment, and its table, to its followers.
+  writer.reset();
+  QVERIFY(reader.read(items, sequence));
+  QCOMPARE(items.size(), size_t(2));
+  QVERIFY(!reader.isRetired());
+
+  // The next writer takes over the same segment and grows it; the follower remaps to read the larger table.
+  writer = std::make_unique<QtUtils::ConfigShm>();
+  QVERIFY(writer->create(name, 256 * 1024));
+  QVERIFY(writer->write(makeItems(500, 2)));
+  QVERIFY(reader.sequence()->load() != sequence);
+  QVERIFY2(reader.read(items, sequence), qPrintable(reader.errorString()));
+  QCOMPARE(items.size(), size_t(500));
+  QCOMPARE(items.back().value.toString(), QStringLiteral("2"));
+}
+
+void TestConfigShm::testRemove()
+{
+  const QString name = segmentName("remove");
+  QtUtils::ConfigShm writer;
+  QVERIFY(writer.create(name, 4096));
+  QVERIFY(writer.write(makeItems(2, 1)));
+  QtUtils::ConfigShm reader;
+  QVERIFY(reader.open(name));
+  const quint64 before = reader.sequence()->load();
+
+  QVERIFY(QtUtils::ConfigShm::remove(name));
+  QVERIFY(reader.isRetired());
+  QVERIFY(reader.sequence()->load() != before);
+  QtUtils::ConfigShm missing;
+  QVERIFY(!missing.open(name));
+
+  // A new writer creates a fresh segment under the name, which a follower can open.
+  QtUtils::ConfigShm next_writer;
+  QVERIFY(next_writer.create(name, 4096));
+  QtUtils::ConfigShm next_reader;
+  QVERIFY(next_reader.open(name));
+  QVERIFY(!next_reader.isRetired());
+}
+
+QTEST_MAIN(TestConfigShm)
+#include "test_config_shm.moc"
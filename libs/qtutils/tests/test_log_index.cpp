@@ -0,0 +1,169 @@
+#include "qtutils/log_index.h"
+#include "qtutils/log_line.h"
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestLogIndex : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void testIndexPath();
+  void testWriteAndRead();
+  void testReopenAppends();
+  void testMissingIndex();
+  void testSelectRanges();
+  void testLineTimestamp();
+  void testLineLevel();
+};
+
+void TestLogIndex::testIndexPath()
+{
+  QCOMPARE(QtUtils::LogIndex::indexPathFor(QStringLiteral("/tmp/app-1.log")), QStringLiteral("/tmp/app-1.log.idx"));
+}
+
+void TestLogIndex::testWriteAndRead()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString log_file = dir.filePath(QStringLiteral("test.log"));
+
+  QtUtils::LogIndexWriter writer;
+  QVERIFY(writer.open(log_file, 1024));
+  QVERIFY(writer.isOpen());
+
+  // 30 entries of 100 bytes: blocks close after 11 entries (1100 >= 1024), the rest is flushed by close().
+  for (int i = 0; i < 30; ++i)
+  {
+    writer.addEntry(i * 100, 100, 1000 + i, i % 5);
+  }
+  writer.close();
+  QVERIFY(!writer.isOpen());
+
+  QVector<QtUtils::LogIndex::Block> blocks;
+  QVERIFY(QtUtils::LogIndex::read(QtUtils::LogIndex::indexPathFor(log_file), blocks));
+  QCOMPARE(blocks.size(), 3);
+
+  QCOMPARE(blocks[0].offset, 0);
+  QCOMPARE(blocks[0].length, 1100);
+  QCOMPARE(blocks[0].min_ts_ms, 1000);
+  QCOMPARE(blocks[0].max_ts_ms, 1010);
+  QCOMPARE(blocks[1].offset, 1100);
+  QCOMPARE(blocks[2].offset + blocks[2].length, 3000);
+
+  quint32 totals[QtUtils::LogIndex::kLevelCount] = {};
+  for (const auto &block : blocks)
+  {
+    for (int level = 0; level < QtUtils::LogIndex::kLevelCount; ++level)
+    {
+      totals[level] += block.level_counts[level];
+    }
+  }
+  for (quint32 total : totals)
+  {
+    QCOMPARE(total, 6u);
+  }
+}
+
+void TestLogIndex::testReopenAppends()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString log_file = dir.filePath(QStringLiteral("test.log"));
+
+  QtUtils::LogIndexWriter writer;
+  QVERIFY(writer.open(log_file, 1024));
+  writer.addEntry(0, 10, 1, 0);
+  writer.close();
+
+  QVERIFY(writer.open(log_file, 1024));
+  writer.addEntry(10, 10, 2, 2);
+  writer.close();
+
+  QVector<QtUtils::LogIndex::Block> blocks;
+  QVERIFY(QtUtils::LogIndex::read(QtUtils::LogIndex::indexPathFor(log_file), blocks));
+  QCOMPARE(blocks.size(), 2);
+  QCOMPARE(blocks[1].offset, 10);
+  QCOMPARE(blocks[1].level_counts[2], 1u);
+}
+
+void TestLogIndex::testMissingIndex()
+{
+  QVector<QtUtils::LogIndex::Block> blocks;
+  QVERIFY(!QtUtils::LogIndex::read(QStringLiteral("/nonexistent/file.log.idx"), blocks));
+  QVERIFY(blocks.isEmpty());
+}
+
+static QString rangesToString(const QVector<QtUtils::LogIndex::ByteRange> &ranges)
+{
+  QStringList parts;
+  for (const auto &range : ranges)
+  {
+    parts.append(QStringLiteral("%1-%2").arg(range.begin).arg(range.end));
+  }
+  return parts.join(' ');
+}
+
+void TestLogIndex::testSelectRanges()
+{
+  // Bytes 0-100 predate the index and 550-1000 follow its last block. Block 2 is older than block 1, and block 3
+  // overlaps block 2.
+  const QVector<QtUtils::LogIndex::Block> blocks = {
+      {100, 100, 10, 20, {0, 1, 0, 0, 0}, 0},
+      {200, 100, 50, 60, {0, 0, 1, 0, 0}, 0},
+      {300, 100, 30, 40, {0, 1, 0, 0, 0}, 0},
+      {350, 100, 45, 48, {1, 0, 0, 0, 0}, 0},
+      {450, 100, 70, 80, {0, 0, 0, 1, 0}, 0},
+  };
+
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges(blocks, 1000, 30, 48, 0)),
+           QStringLiteral("0-100 300-450 550-1000"));
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges(blocks, 1000, 30, 40, 1)),
+           QStringLiteral("0-100 300-400 550-1000"));
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges(blocks, 1000, 0, 100, 3)), QStringLiteral("0-100 450-1000"));
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges(blocks, 1000, 90, 100, 0)),
+           QStringLiteral("0-100 550-1000"));
+
+  // A file truncated below the index only yields ranges within its size.
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges(blocks, 320, 0, 100, 0)), QStringLiteral("0-320"));
+  QCOMPARE(rangesToString(QtUtils::LogIndex::selectRanges({}, 500, 0, 100, 0)), QStringLiteral("0-500"));
+}
+
+void TestLogIndex::testLineTimestamp()
+{
+  const QByteArray text = "[2026-10-18 14:02:10.123] [DEBUG] [main.cpp:12] [0000000000000001] hello";
+  const QByteArray json = "{\"ts\":\"2026-10-18 14:02:10.123\",\"level\":\"ERROR\"}";
+  const QByteArray continuation = "  [1.00,2.00,3.0]";
+
+  QCOMPARE(QtUtils::LogLine::timestampKey(text.constData(), text.size()), Q_INT64_C(20261018140210123));
+  QCOMPARE(QtUtils::LogLine::timestampKey(json.constData(), json.size()), Q_INT64_C(20261018140210123));
+  QCOMPARE(QtUtils::LogLine::timestampKey(continuation.constData(), continuation.size()), Q_INT64_C(-1));
+
+  QDateTime datetime(QDate(2026, 10, 18), QTime(14, 2, 10, 123));
+  QCOMPARE(QtUtils::LogLine::timestampKey(datetime), Q_INT64_C(20261018140210123));
+}
+
+void TestLogIndex::testLineLevel()
+{
+  const QByteArray text = "[2026-10-18 14:02:10.123] [WARNING] [main.cpp:12] [0000000000000001] hello";
+  const QByteArray json = "{\"ts\":\"2026-10-18 14:02:10.123\",\"ts_ms\":1,\"level\":\"ERROR\"}";
+
+  QCOMPARE(QtUtils::LogLine::levelIndex(text.constData(), text.size()), 2);
+  QCOMPARE(QtUtils::LogLine::levelIndex(json.constData(), json.size()), 3);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("info")), 1);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("critical")), 3);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("bogus")), -1);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("warn")), -1);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("dbg")), -1);
+  QCOMPARE(QtUtils::LogLine::levelIndex(QStringLiteral("Fatal")), 4);
+
+  const QByteArray unknown = "[2026-10-18 14:02:10.123] [UNKNOWN] [main.cpp:12] [0000000000000001] hello";
+  const QByteArray json_prefix = "{\"ts\":\"2026-10-18 14:02:10.123\",\"level\":\"ERRORS\"}";
+  QCOMPARE(QtUtils::LogLine::levelIndex(unknown.constData(), unknown.size()), -1);
+  QCOMPARE(QtUtils::LogLine::levelIndex(json_prefix.constData(), json_prefix.size()), -1);
+}
+
+QTEST_MAIN(TestLogIndex)
+#include "test_log_index.moc"
@@ -1,12 +1,24 @@
 #include "qtutils/common_utils.h"
+#include "qtutils/log_index.h"
 #include "qtutils/log_manager.h"
+#include "qtutils/log_record.h"
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryFile>
 #include <QTest>
 #include <QThread>
 #include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#if defined(Q_OS_UNIX)
+#include <cstdio>
+#include <unistd.h>
+#endif
 
 class TestLogManager : public QObject
 {
@@ -17,10 +29,22 @@ private slots:
   void cleanupTestCase();
 
   void testSingleton();
+  void testDeferredStartup();
   void testDefaults();
   void testConfigure();
   void testLevelFiltering();
+  void testSampling();
+  void testSamplingPerCallSite();
+  void testKeyInterning();
+  void testStructuredFields();
+  void testWriteObserver();
   void testFileOutput();
+  void testInfoLevelOrdering();
+  void testRestart();
+  void testStats();
+  void testRotation();
+  void testDrainBudget();
+  void testDrainFileOnly();
 
 private:
   QString original_app_name_;
@@ -37,13 +61,14 @@ void TestLogManager::initTestCase()
   QDir dir(log_dir_);
   if (dir.exists())
   {
-    for (const QFileInfo &fi : dir.entryInfoList(QStringList{"*.log"}, QDir::Files))
+    for (const QFileInfo &fi : dir.entryInfoList(QStringList{"*.log", "*.idx"}, QDir::Files))
     {
       QFile::remove(fi.absoluteFilePath());
     }
   }
 
   QtUtils::LogManager::instance();
+  qDebug() << "logged before storage ready";
 }
 
 void TestLogManager::cleanupTestCase()
@@ -51,7 +76,7 @@ void TestLogManager::cleanupTestCase()
   QDir dir(log_dir_);
   if (dir.exists())
   {
-    for (const QFileInfo &fi : dir.entryInfoList(QStringList{"*.log"}, QDir::Files))
+    for (const QFileInfo &fi : dir.entryInfoList(QStringList{"*.log", "*.idx"}, QDir::Files))
     {
       QFile::remove(fi.absoluteFilePath());
     }
@@ -66,13 +91,20 @@ void TestLogManager::testSingleton()
   QCOMPARE(&a, &b);
 }
 
+void TestLogManager::testDeferredStartup()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QTRY_VERIFY(log.isStorageReady());
+  QTRY_VERIFY(log.currentFileSize() > 0);
+  QVERIFY(log.fileCount() >= 1);
+}
+
 void TestLogManager::testDefaults()
 {
   QtUtils::LogManager &log = QtUtils::LogManager::instance();
   QCOMPARE(log.minLevel(), QtDebugMsg);
   QVERIFY(log.isConsoleEnabled());
   QVERIFY(log.isFileEnabled());
-  QCOMPARE(log.currentFileSize(), 0);
   QVERIFY(log.fileCount() >= 0);
 }
 
@@ -98,6 +130,9 @@ void TestLogManager::testConfigure()
 
   log.setFileEnabled(true);
   QVERIFY(log.isFileEnabled());
+
+  log.setShutdownBudget(5000);
+  QCOMPARE(log.shutdownBudget(), 5000);
 }
 
 void TestLogManager::testLevelFiltering()
@@ -110,6 +145,220 @@ void TestLogManager::testLevelFiltering()
   qCritical() << "should also appear";
 }
 
+static QStringList sampledIds(const QString &log_file, const QString &marker)
+{
+  QFile file(log_file);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return {};
+  }
+
+  QStringList ids;
+  for (const QString &line : QString::fromUtf8(file.readAll()).split('\n'))
+  {
+    int pos = line.indexOf(marker);
+    if (pos >= 0 && line.contains(QStringLiteral("[sample 1/4]")))
+    {
+      ids.append(line.mid(pos + marker.size()).trimmed());
+    }
+  }
+  return ids;
+}
+
+void TestLogManager::testSampling()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  log.configure(QtDebugMsg, false, true);
+
+  log.setSampling(QtDebugMsg, 4);
+  QCOMPARE(log.samplingRate(QtDebugMsg), 4u);
+  QCOMPARE(log.samplingRate(QtWarningMsg), 1u);
+
+  log.setSamplingSeed(42);
+  for (int i = 0; i < 100; ++i)
+  {
+    qDebug() << "sampled run_a" << i;
+  }
+
+  log.setSamplingSeed(42);
+  for (int i = 0; i < 100; ++i)
+  {
+    qDebug() << "sampled run_b" << i;
+  }
+
+  log.setSampling(QtDebugMsg, 1);
+  QCOMPARE(log.samplingRate(QtDebugMsg), 1u);
+
+  const QString log_file = log.currentLogFile();
+  QTRY_COMPARE(sampledIds(log_file, QStringLiteral("sampled run_b")).size(), 25);
+  QCOMPARE(sampledIds(log_file, QStringLiteral("sampled run_a")),
+           sampledIds(log_file, QStringLiteral("sampled run_b")));
+}
+
+// Two call sites logging in lockstep; a shared per-level counter would keep every other entry of only one of them.
+static void logTwoSites(const char *run, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    qDebug() << "site_a" << run << i;
+    qDebug() << "site_b" << run << i;
+  }
+}
+
+static bool keepsEveryFourth(const QStringList &ids)
+{
+  for (int k = 0; k < ids.size(); ++k)
+  {
+    if (ids[k].toInt() != ids[0].toInt() + 4 * k)
+    {
+      return false;
+    }
+  }
+  return ids.size() == 25 && ids[0].toInt() < 4;
+}
+
+void TestLogManager::testSamplingPerCallSite()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  log.configure(QtDebugMsg, false, true);
+  log.setSampling(QtDebugMsg, 4, QtUtils::LogManager::SamplingScope::PerCallSite);
+
+  log.setSamplingSeed(7);
+  logTwoSites("run_1", 100);
+  log.setSamplingSeed(7);
+  logTwoSites("run_2", 100);
+  log.setSampling(QtDebugMsg, 1);
+
+  const QString log_file = log.currentLogFile();
+  QTRY_COMPARE(sampledIds(log_file, QStringLiteral("site_b run_2")).size(), 25);
+  for (const char *site : {"site_a", "site_b"})
+  {
+    const QStringList first = sampledIds(log_file, QStringLiteral("%1 run_1").arg(site));
+    QVERIFY2(keepsEveryFourth(first), site);
+    QCOMPARE(sampledIds(log_file, QStringLiteral("%1 run_2").arg(site)), first);
+  }
+}
+
+void TestLogManager::testKeyInterning()
+{
+  QtUtils::LogKey a("frame_id");
+  QtUtils::LogKey b(QByteArray("frame_id"));
+  QtUtils::LogKey c("point_count");
+
+  QCOMPARE(a.id(), b.id());
+  QVERIFY(a.id() != c.id());
+  QCOMPARE(a.name(), QByteArray("frame_id"));
+  QCOMPARE(QtUtils::LogKey::nameOf(c.id()), QByteArray("point_count"));
+
+  QCOMPARE(QtUtils::LogKey::cached("frame_id").id(), a.id());
+  QCOMPARE(QtUtils::LogKey::cached("frame_id").id(), a.id());
+  // A reused buffer holding a different name must not be served the old id.
+  char buffer[16] = "frame_id";
+  QCOMPARE(QtUtils::LogKey::cached(buffer).id(), a.id());
+  std::strcpy(buffer, "point_count");
+  QCOMPARE(QtUtils::LogKey::cached(buffer).id(), c.id());
+}
+
+static QString findLine(const QString &log_file, const QString &marker)
+{
+  QFile file(log_file);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return {};
+  }
+
+  for (const QString &line : QString::fromUtf8(file.readAll()).split('\n'))
+  {
+    if (line.contains(marker))
+    {
+      return line;
+    }
+  }
+  return {};
+}
+
+void TestLogManager::testStructuredFields()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  log.configure(QtDebugMsg, false, true);
+
+  static const QtUtils::LogKey frame_key("frame");
+  QTUTILS_LOG(QtInfoMsg)
+      .message("structured text")
+      .field(frame_key, 42)
+      .field("speed", 1.5)
+      .field("ok", true)
+      .field("sensor", QStringLiteral("lidar front"));
+
+  const QString log_file = log.currentLogFile();
+  QTRY_VERIFY(!findLine(log_file, QStringLiteral("structured text")).isEmpty());
+  QString text_line = findLine(log_file, QStringLiteral("structured text"));
+  QVERIFY(text_line.contains(QStringLiteral("[INFO]")));
+  QVERIFY(text_line.endsWith(QStringLiteral("frame=42 speed=1.5 ok=true sensor=\"lidar front\"")));
+
+  log.setOutputFormat(QtUtils::LogManager::OutputFormat::JsonLines);
+  QVERIFY(log.outputFormat() == QtUtils::LogManager::OutputFormat::JsonLines);
+  QTUTILS_LOG(QtWarningMsg)
+      .message("structured \"json\"\n")
+      .field(frame_key, -7)
+      .field("ratio", 0.25)
+      .field("count", 3u);
+
+  QTRY_VERIFY(!findLine(log_file, QStringLiteral("\"ts_ms\"")).isEmpty());
+  log.setOutputFormat(QtUtils::LogManager::OutputFormat::Text);
+
+  QJsonParseError error;
+  QJsonDocument doc = QJsonDocument::fromJson(findLine(log_file, QStringLiteral("\"ts_ms\"")).toUtf8(), &error);
+  QCOMPARE(error.error, QJsonParseError::NoError);
+  QJsonObject obj = doc.object();
+  QCOMPARE(obj.value(QStringLiteral("level")).toString(), QStringLiteral("WARNING"));
+  QCOMPARE(obj.value(QStringLiteral("msg")).toString(), QStringLiteral("structured \"json\"\n"));
+  QJsonObject fields = obj.value(QStringLiteral("fields")).toObject();
+  QCOMPARE(fields.value(QStringLiteral("frame")).toInt(), -7);
+  QCOMPARE(fields.value(QStringLiteral("ratio")).toDouble(), 0.25);
+  QCOMPARE(fields.value(QStringLiteral("count")).toInt(), 3);
+}
+
+void TestLogManager::testWriteObserver()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  log.configure(QtDebugMsg, false, true);
+
+  log.setFlushSize(1024);
+  QCOMPARE(log.flushSize(), qint64(1024));
+  log.setFlushTimeout(50);
+  QCOMPARE(log.flushTimeout(), 50);
+
+  // Shared with the worker, which may still be inside the observer after it is removed.
+  struct Observed
+  {
+    std::mutex mutex;
+    QByteArray data;
+  };
+  auto observed = std::make_shared<Observed>();
+  log.setWriteObserver(
+      [observed](const QByteArray &data)
+      {
+        std::lock_guard<std::mutex> lock(observed->mutex);
+        observed->data.append(data);
+      });
+
+  qInfo() << "observed write";
+
+  auto seen = [observed]()
+  {
+    std::lock_guard<std::mutex> lock(observed->mutex);
+    return observed->data.contains("observed write");
+  };
+  QTRY_VERIFY(seen());
+  log.setWriteObserver(nullptr);
+
+  QVERIFY(!findLine(log.currentLogFile(), QStringLiteral("observed write")).isEmpty());
+
+  log.setFlushSize(8 * 1024);
+  log.setFlushTimeout(200);
+}
+
 void TestLogManager::testFileOutput()
 {
   QtUtils::LogManager &log = QtUtils::LogManager::instance();
@@ -165,6 +414,7 @@ void TestLogManager::testFileOutput()
   QString content = QString::fromUtf8(file.readAll());
   file.close();
 
+  QVERIFY(content.contains("logged before storage ready"));
   QVERIFY(content.contains("[DEBUG]"));
   QVERIFY(content.contains("[WARNING]"));
   QVERIFY(content.contains("concurrent thread"));
@@ -177,6 +427,244 @@ void TestLogManager::testFileOutput()
     }
   }
   QCOMPARE(matched_lines, num_threads * msgs_per_thread);
+
+  QVector<QtUtils::LogIndex::Block> blocks;
+  QVERIFY(QtUtils::LogIndex::read(QtUtils::LogIndex::indexPathFor(log_file), blocks));
+  QVERIFY(!blocks.isEmpty());
+  qint64 indexed_entries = 0;
+  for (const auto &block : blocks)
+  {
+    for (quint32 count : block.level_counts)
+    {
+      indexed_entries += count;
+    }
+  }
+  QCOMPARE(indexed_entries, static_cast<qint64>(content.split('\n', Qt::SkipEmptyParts).size()));
+  QCOMPARE(blocks.last().offset + blocks.last().length, QFileInfo(log_file).size());
+}
+
+void TestLogManager::testInfoLevelOrdering()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  log.configure(QtInfoMsg, false, true);
+
+  qDebug() << "ordering debug";
+  qInfo() << "ordering info";
+  qWarning() << "ordering warning";
+  qCritical() << "ordering critical";
+
+  const QString log_file = log.currentLogFile();
+  QTRY_VERIFY(!findLine(log_file, QStringLiteral("ordering critical")).isEmpty());
+  QVERIFY(!findLine(log_file, QStringLiteral("ordering warning")).isEmpty());
+  QVERIFY(!findLine(log_file, QStringLiteral("ordering info")).isEmpty());
+  QVERIFY(findLine(log_file, QStringLiteral("ordering debug")).isEmpty());
+
+  log.configure(QtDebugMsg, true, true);
+}
+
+void TestLogManager::testRestart()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QVERIFY(!log.isRunning());
+  const QString previous_file = log.currentLogFile();
+  const qint64 bytes_before = log.stats().file_bytes_written;
+  QVERIFY(log.restart());
+  QVERIFY(log.isRunning());
+  QVERIFY(!log.restart());
+
+  qWarning() << "logged after restart";
+  log.shutdown();
+  QVERIFY(!log.isRunning());
+
+  // The restarted run gets a new file holding only what it wrote.
+  const QString restarted_file = log.currentLogFile();
+  QVERIFY(!restarted_file.isEmpty());
+  QVERIFY(restarted_file != previous_file);
+  QVERIFY(!findLine(restarted_file, QStringLiteral("logged after restart")).isEmpty());
+  QCOMPARE(QFileInfo(restarted_file).size(), log.stats().file_bytes_written - bytes_before);
+
+  // Records made while stopped are discarded rather than queued for the next start.
+  const quint64 enqueued = log.stats().enqueued;
+  QVERIFY(!QTUTILS_LOG(QtWarningMsg).message("record while stopped").isActive());
+  QCOMPARE(log.stats().enqueued, enqueued);
+}
+
+void TestLogManager::testStats()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QVERIFY(log.restart());
+  const QtUtils::LogManager::Stats before = log.stats();
+
+  for (int i = 0; i < 100; ++i)
+  {
+    qWarning() << "stats entry" << i;
+  }
+  log.shutdown();
+
+  const QtUtils::LogManager::Stats after = log.stats();
+  QVERIFY(after.enqueued >= before.enqueued + 100);
+  QCOMPARE(after.processed + after.dropped, after.enqueued);
+  QCOMPARE(after.queue_depth, qsizetype(0));
+  QVERIFY(after.max_queue_depth >= 1);
+  QVERIFY(after.file_bytes_written > before.file_bytes_written);
+}
+
+void TestLogManager::testRotation()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QVERIFY(log.restart());
+  QTRY_VERIFY(log.isStorageReady());
+  log.configure(QtDebugMsg, false, true);
+
+  log.setMaxFileSize(4096);
+  QCOMPARE(log.maxFileSize(), qint64(4096));
+  log.setMaxFileCount(3);
+  QCOMPARE(log.maxFileCount(), 3);
+
+  auto observed = std::make_shared<std::atomic<int>>(0);
+  log.setRotationObserver(
+      [observed](qint64 duration_ns)
+      {
+        if (duration_ns >= 0)
+        {
+          observed->fetch_add(1);
+        }
+      });
+
+  const QtUtils::LogManager::Stats before = log.stats();
+  const QByteArray payload(100, 'r');
+  for (int i = 0; i < 500; ++i)
+  {
+    qInfo() << "rotation entry" << i << payload;
+  }
+  log.shutdown();
+  log.setRotationObserver(nullptr);
+
+  const QtUtils::LogManager::Stats after = log.stats();
+  QVERIFY(after.rotations >= before.rotations + 5);
+  QCOMPARE(static_cast<quint64>(observed->load()), after.rotations - before.rotations);
+  QVERIFY(QDir(log_dir_).entryList(QStringList{"*.log"}, QDir::Files).size() <= 3);
+
+  log.setMaxFileSize(10 * 1024 * 1024);
+  log.setMaxFileCount(100);
+}
+
+namespace
+{
+
+// Holds the worker inside the write observer until released, so entries pile up behind it.
+struct WorkerGate
+{
+  std::atomic<bool> entered{false};
+  std::atomic<bool> open{false};
+};
+
+std::shared_ptr<WorkerGate> stallWorker(QtUtils::LogManager &log)
+{
+  auto gate = std::make_shared<WorkerGate>();
+  log.setWriteObserver(
+      [gate](const QByteArray &)
+      {
+        gate->entered.store(true);
+        while (!gate->open.load())
+        {
+          QThread::msleep(1);
+        }
+      });
+  return gate;
+}
+
+// Opens the gate from another thread while the caller is blocked in shutdown().
+QThread *openGateLater(const std::shared_ptr<WorkerGate> &gate, unsigned long delay_ms)
+{
+  QThread *thread = QThread::create(
+      [gate, delay_ms]()
+      {
+        QThread::msleep(delay_ms);
+        gate->open.store(true);
+      });
+  thread->start();
+  return thread;
+}
+
+} // namespace
+
+void TestLogManager::testDrainBudget()
+{
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QVERIFY(log.restart());
+  QTRY_VERIFY(log.isStorageReady());
+  log.configure(QtDebugMsg, false, true);
+  log.setShutdownBudget(50);
+
+  auto gate = stallWorker(log);
+  qInfo() << "drain stall";
+  QTRY_VERIFY(gate->entered.load());
+
+  const QtUtils::LogManager::Stats before = log.stats();
+  for (int i = 0; i < 2000; ++i)
+  {
+    qInfo() << "drain backlog" << i;
+  }
+
+  // Released well after the 50 ms deadline: the backlog behind the stalled write is summarized, not written.
+  QThread *opener = openGateLater(gate, 300);
+  log.shutdown();
+  opener->wait();
+  delete opener;
+  log.setWriteObserver(nullptr);
+  log.setShutdownBudget(3000);
+
+  const QtUtils::LogManager::Stats after = log.stats();
+  QVERIFY(after.dropped - before.dropped >= 1000);
+  QCOMPARE(after.processed + after.dropped, after.enqueued);
+
+  const QString summary = findLine(log.currentLogFile(), QStringLiteral("Shutdown drain budget of 50 ms exceeded"));
+  QVERIFY(!summary.isEmpty());
+  QVERIFY(summary.contains(QStringLiteral("dropped %1 entries").arg(after.dropped - before.dropped)));
+  QVERIFY(findLine(log.currentLogFile(), QStringLiteral("drain backlog 1999")).isEmpty());
+}
+
+void TestLogManager::testDrainFileOnly()
+{
+#if !defined(Q_OS_UNIX)
+  QSKIP("captures stdout through a file descriptor");
+#else
+  QtUtils::LogManager &log = QtUtils::LogManager::instance();
+  QVERIFY(log.restart());
+  QTRY_VERIFY(log.isStorageReady());
+  log.configure(QtDebugMsg, true, true);
+
+  QTemporaryFile capture;
+  QVERIFY(capture.open());
+  fflush(stdout);
+  const int saved_stdout = dup(STDOUT_FILENO);
+  QVERIFY(saved_stdout >= 0);
+  QVERIFY(dup2(capture.handle(), STDOUT_FILENO) >= 0);
+
+  auto gate = stallWorker(log);
+  qInfo() << "file only stall";
+  QTRY_VERIFY(gate->entered.load());
+  for (int i = 0; i < 20; ++i)
+  {
+    qInfo() << "file only entry" << i;
+  }
+  QThread *opener = openGateLater(gate, 100);
+  log.shutdown(QtUtils::LogManager::DrainMode::FileOnly);
+  opener->wait();
+  delete opener;
+  log.setWriteObserver(nullptr);
+
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  ::close(saved_stdout);
+
+  // Everything drained after shutdown() began went to the file only.
+  QFile console(capture.fileName());
+  QVERIFY(console.open(QIODevice::ReadOnly));
+  QVERIFY(!console.readAll().contains("file only entry"));
+  QVERIFY(!findLine(log.currentLogFile(), QStringLiteral("file only entry 19")).isEmpty());
+#endif
 }
 
 QTEST_MAIN(TestLogManager)
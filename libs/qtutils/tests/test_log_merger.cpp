@@ -0,0 +1,141 @@
+#include "qtutils/log_merger.h"
+#include <QBuffer>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace
+{
+
+QByteArray line(const char *time, const char *text)
+{
+  return QByteArray("[2026-10-18 ") + time + "] [INFO] [a.cpp:1] [0000000000000001] " + text + "\n";
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+  QFile file(path);
+  return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+} // namespace
+
+class TestLogMerger : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void testMergeOrder();
+  void testContinuationLines();
+  void testMissingTrailingNewline();
+  void testCompressedInput();
+  void testFindLogFiles();
+};
+
+void TestLogMerger::testMergeOrder()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QVERIFY(writeFile(dir.filePath("a.log"), line("10:00:00.000", "a1") + line("10:00:02.000", "a2")));
+  QVERIFY(writeFile(dir.filePath("b.log"), line("10:00:01.000", "b1") + line("10:00:02.000", "b2")));
+  QVERIFY(writeFile(dir.filePath("c.log"), QByteArray()));
+
+  QtUtils::LogMerger merger;
+  QVERIFY(merger.addInput(dir.filePath("a.log")));
+  QVERIFY(merger.addInput(dir.filePath("b.log")));
+  QVERIFY(merger.addInput(dir.filePath("c.log")));
+  QCOMPARE(merger.inputCount(), qsizetype(3));
+
+  QBuffer output;
+  QVERIFY(output.open(QIODevice::WriteOnly));
+  QVERIFY(merger.merge(output));
+
+  // Equal timestamps keep input order.
+  const QByteArray expected = line("10:00:00.000", "a1") + line("10:00:01.000", "b1") +
+                              line("10:00:02.000", "a2") + line("10:00:02.000", "b2");
+  QCOMPARE(output.data(), expected);
+  QCOMPARE(merger.entriesWritten(), qint64(4));
+  QCOMPARE(merger.bytesWritten(), qint64(expected.size()));
+}
+
+void TestLogMerger::testContinuationLines()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QVERIFY(writeFile(dir.filePath("a.log"), line("10:00:03.000", "a1") + "  stack frame 1\n  stack frame 2\n"));
+  QVERIFY(writeFile(dir.filePath("b.log"), line("10:00:01.000", "b1") + line("10:00:05.000", "b2")));
+
+  QtUtils::LogMerger merger;
+  QVERIFY(merger.addInput(dir.filePath("a.log")));
+  QVERIFY(merger.addInput(dir.filePath("b.log")));
+
+  QBuffer output;
+  QVERIFY(output.open(QIODevice::WriteOnly));
+  QVERIFY(merger.merge(output));
+
+  const QByteArray expected = line("10:00:01.000", "b1") + line("10:00:03.000", "a1") +
+                              "  stack frame 1\n  stack frame 2\n" + line("10:00:05.000", "b2");
+  QCOMPARE(output.data(), expected);
+  QCOMPARE(merger.entriesWritten(), qint64(3));
+}
+
+void TestLogMerger::testMissingTrailingNewline()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QByteArray truncated = line("10:00:00.000", "a1");
+  truncated.chop(1);
+  QVERIFY(writeFile(dir.filePath("a.log"), truncated));
+  QVERIFY(writeFile(dir.filePath("b.log"), line("10:00:01.000", "b1")));
+
+  QtUtils::LogMerger merger;
+  QVERIFY(merger.addInput(dir.filePath("a.log")));
+  QVERIFY(merger.addInput(dir.filePath("b.log")));
+
+  QBuffer output;
+  QVERIFY(output.open(QIODevice::WriteOnly));
+  QVERIFY(merger.merge(output));
+  QCOMPARE(output.data(), line("10:00:00.000", "a1") + line("10:00:01.000", "b1"));
+}
+
+void TestLogMerger::testCompressedInput()
+{
+  if (QStandardPaths::findExecutable("gzip").isEmpty())
+  {
+    QSKIP("gzip not available");
+  }
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QVERIFY(writeFile(dir.filePath("a.log"), line("10:00:00.000", "a1") + line("10:00:02.000", "a2")));
+  QVERIFY(writeFile(dir.filePath("b.log"), line("10:00:01.000", "b1")));
+  QCOMPARE(QProcess::execute("gzip", QStringList{dir.filePath("a.log")}), 0);
+
+  QtUtils::LogMerger merger;
+  QVERIFY(merger.addInput(dir.filePath("a.log.gz")));
+  QVERIFY(merger.addInput(dir.filePath("b.log")));
+
+  QBuffer output;
+  QVERIFY(output.open(QIODevice::WriteOnly));
+  QVERIFY(merger.merge(output));
+  QCOMPARE(output.data(), line("10:00:00.000", "a1") + line("10:00:01.000", "b1") + line("10:00:02.000", "a2"));
+}
+
+void TestLogMerger::testFindLogFiles()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QVERIFY(writeFile(dir.filePath("app-2.log"), QByteArray()));
+  QVERIFY(writeFile(dir.filePath("app-1.log.gz"), QByteArray()));
+  QVERIFY(writeFile(dir.filePath("app-1.log.idx"), QByteArray()));
+
+  const QStringList files = QtUtils::LogMerger::findLogFiles(dir.path());
+  QCOMPARE(files.size(), 2);
+  QVERIFY(files[0].endsWith("app-1.log.gz"));
+  QVERIFY(files[1].endsWith("app-2.log"));
+}
+
+QTEST_MAIN(TestLogMerger)
+#include "test_log_merger.moc"